@@ -158,7 +158,13 @@ if [ `hostname -s` == "$HOSTNAME" ]; then
 	# export variables that will be expanded by pyProcMgr
 	export TEST_DIR 
 
-	$PYPROCMGR -v -c $TEST_N_PVCAPTURE -n $TEST_APPTYPE -p $TEST_PVCAPTURE_BASEPORT -d 5.0 -D $TEST_DIR \
-		'bin/$EPICS_HOST_ARCH/pvCapture -S -D $TEST_DIR/pvCapture$PYPROC_ID -f $TEST_DIR/pvCapture$PYPROC_ID/pvs.list'; \
+	if [ -n "$TEST_PVCAPTURE_MULTI_CLIENT" ]; then
+		# One pvCapture process hosts all $TEST_N_PVCAPTURE clients, same per-client dirs
+		$PYPROCMGR -v -c 1 -n $TEST_APPTYPE -p $TEST_PVCAPTURE_BASEPORT -d 5.0 -D $TEST_DIR \
+			"bin/$EPICS_HOST_ARCH/pvCapture -S -N $TEST_N_PVCAPTURE -W ${TEST_PVCAPTURE_THREADS:-4} -D $TEST_DIR/pvCapture%02d -f $TEST_DIR/pvCapture%02d/pvs.list"; \
+	else
+		$PYPROCMGR -v -c $TEST_N_PVCAPTURE -n $TEST_APPTYPE -p $TEST_PVCAPTURE_BASEPORT -d 5.0 -D $TEST_DIR \
+			'bin/$EPICS_HOST_ARCH/pvCapture -S -D $TEST_DIR/pvCapture$PYPROC_ID -f $TEST_DIR/pvCapture$PYPROC_ID/pvs.list'; \
+	fi
 	echo Done: `date` | tee -a $TEST_LOG
 fi
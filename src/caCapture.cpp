@@ -2,39 +2,40 @@
  * Copyright information and license terms for this software can be
  * found in the file LICENSE that is included with the distribution
  */
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <set>
-#include <deque>
-#include <queue>
 #include <string>
 #include <istream>
 #include <fstream>
 #include <sstream>
 
 #include <math.h>
+#include <signal.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <sys/stat.h>
 
 #include <epicsStdlib.h>
 #include <epicsGetopt.h>
 #include <epicsExit.h>
+#include <epicsEvent.h>
 #include <epicsGuard.h>
 #include <epicsTime.h>
+#include <epicsVersion.h>
 #include <alarm.h>
+#include <cadef.h>
 
 #include <pv/pvData.h>
+#include <pv/pvAccess.h>
 #include <pv/logger.h>
-#include <pv/lock.h>
-#include <pv/event.h>
-#include <pv/monitor.h>
-#include <pv/thread.h>
 #include <pv/reftrack.h>
-#include <pv/timeStamp.h>
 
-#include <pv/caProvider.h>
-#include <pv/logger.h>
-#include <pva/client.h>
+#include "pvCollector.h"
+#include "pvStorage.h"
+#include "pvHistogram.h"
 
 #define USE_SIGNAL
 #ifndef EXECNAME
@@ -42,19 +43,23 @@
 #endif
 
 #define CA_CAPTURE_MAJOR_VERSION			0
-#define CA_CAPTURE_MINOR_VERSION			1
+#define CA_CAPTURE_MINOR_VERSION			2
 #define CA_CAPTURE_MAINTENANCE_VERSION		0
 #define CA_CAPTURE_DEVELOPMENT_FLAG		1
 
 namespace pvd = epics::pvData;
 
-namespace EXECNAME {
+namespace {
 
 // From pvAccessCPP/pvtoolsSrc/pvutils.cpp
 double timeout = 5.0;
 bool debugFlag = false;
+bool quiet = false;
 int	verbosity	= 0;
-std::string defaultProvider("ca");
+
+unsigned		caPriority	= CA_PRIORITY_DEFAULT;			// Set by -p
+unsigned long	eventMask	= DBE_VALUE | DBE_ALARM;		// Set by -m
+epicsEvent		connectEvt;									// Signaled when a CaTracker first connects
 
 // This could go to it's own cpp file and header
 // Borrowed from pvAccessCPP/pvtoolsSrc/pvutils.h
@@ -120,479 +125,343 @@ void usage (void)
 {
     fprintf( stdout, "\nUsage: " EXECNAME " [options] <PV:Name>...\n"
     "\n"
+    "Captures PV updates via native Channel Access, w/o the pvAccessCA provider,\n"
+    "and saves them to <dir>/<PV:Name>.caCapture when done.\n"
+    "\n"
     "options:\n"
     "  -h:                Help: Print this message\n"
     "  -V:                Print version and exit\n"
     "Channel Access options:\n"
-    "  -w <sec>:          Wait time, specifies timeout, default is %f second(s)\n"
-    "  -m <msk>: Specify CA event mask to use.  <msk> is any combination of\n"
-    "            'v' (value), 'a' (alarm), 'l' (log/archive), 'p' (property).\n"
-    "            Default event mask is 'va'\n"
-    "  -p <pri>: CA priority (0-%u, default 0=lowest)\n"
-    "Timestamps:\n"
-    "  Default:  Print absolute timestamps (as reported by CA server)\n"
-    "  -t <key>: Specify timestamp source(s) and type, with <key> containing\n"
-    "            's' = CA server (remote) timestamps\n"
-    "            'c' = CA client (local) timestamps (shown in '()'s)\n"
-    "            'n' = no timestamps\n"
-    "            'r' = relative timestamps (time elapsed since start of program)\n"
-    "            'i' = incremental timestamps (time elapsed since last update)\n"
-    "            'I' = incremental timestamps (time since last update, by channel)\n"
-    "            'r', 'i' or 'I' require 's' or 'c' to select the time source\n"
-    "  -P:       Show fiducial pulse ID with timestamps\n"
-    "Enum format:\n"
-    "  -n:       Print DBF_ENUM values as number (default is enum string)\n"
-    "Array values: Print number of elements, then list of values\n"
-    "  Default:  Request and print all elements (dynamic arrays supported)\n"
-    "  -# <num>: Request and print up to <num> elements\n"
-    "  -S:       Print arrays of char as a string (long string)\n"
-    "Floating point format:\n"
-    "  Default:  Use %%g format\n"
-    "  -e <num>: Use %%e format, with a precision of <num> digits\n"
-    "  -f <num>: Use %%f format, with a precision of <num> digits\n"
-    "  -g <num>: Use %%g format, with a precision of <num> digits\n"
-    "  -s:       Get value as string (honors server-side precision)\n"
-    "  -lx:      Round to long integer and print as hex number\n"
-    "  -lo:      Round to long integer and print as octal number\n"
-    "  -lb:      Round to long integer and print as binary number\n"
-    "Integer number format:\n"
-    "  Default:  Print as decimal number\n"
-    "  -0x:      Print as hex number\n"
-    "  -0o:      Print as octal number\n"
-    "  -0b:      Print as binary number\n"
-    "Alternate output field separator:\n"
-    "  -F <ofs>: Use <ofs> to separate fields in output\n"
+    "  -w <sec>:          Wait time for channels to connect, default is %f second(s)\n"
+    "  -m <msk>:          Specify CA event mask to use.  <msk> is any combination of\n"
+    "                     'v' (value), 'a' (alarm), 'l' (log/archive), 'p' (property).\n"
+    "                     Default event mask is 'va'\n"
+    "  -p <pri>:          CA priority (0-%u, default 0=lowest)\n"
     "\n"
     "  -q:                Quiet mode, print only error messages\n"
     "  -d:                Enable debug output\n"
+    "  -D <dir>:          Test directory for captured values, default /tmp/caCaptureTest1\n"
     "  -f <input file>:   Read pvName list from file, one line per pvName.\n"
-    "  -S:                Show each PV as it's captured, same output options as pvmonitor.\n"
-    "  -vv:     Get in Raw mode.     Highlight  valid fields, show all fields.\n"
+    "  -S:                Show each PV as it's captured.\n"
     "\n"
-    "Example: " EXECNAME " -f8 MY:PV1 MY:PV2\n\n"
-    "  (doubles are printed as %%f with precision of 8)\n\n"
-             , DEFAULT_TIMEOUT, CA_PRIORITY_MAX);
+    "Example: " EXECNAME " -D /tmp/caTest MY:PV1 MY:PV2\n\n"
+             , timeout, CA_PRIORITY_MAX);
 }
 
 
-
-/*+**************************************************************************
- *
- * Function:	event_handler
- *
- * Description:	CA event_handler for request type callback
- * 		Prints the event data
- *
- * Arg(s) In:	args  -  event handler args (see CA manual)
- *
- **************************************************************************-*/
-
-static void event_handler (evargs args)
+/// CaTracker
+/// One native CA channel and DBR_TIME_* subscription per PV.
+/// CA callbacks run preemptively on CA's own threads and store each
+/// sample directly into a typed pvStorage, w/o any PVStructure conversion.
+struct CaTracker : public Tracker
 {
-    pv* pv = args.usr;
+    CaTracker( const std::string & pvName, const std::string & testDirPath, bool fShow )
+        :m_pvName( pvName )
+        ,m_testDirPath( testDirPath )
+        ,m_fShow( fShow )
+        ,m_chid( NULL )
+        ,m_evid( NULL )
+        ,m_dbrType( -1 )
+        ,m_pCollector( NULL )
+        ,m_nUpdates( 0 )
+        ,m_nMissed( 0 )
+        ,m_nAlarms( 0 )
+        ,m_nDisconnects( 0 )
+        ,m_lastValue( NAN )
+        ,m_tCreate( 0 )
+        ,m_tConnect( 0 )
+        ,m_tFirstUpdate( 0 )
+    {
+    }
+    virtual ~CaTracker()
+    {
+        clear();
+    }
 
-    pv->status = args.status;
-    if (args.status == ECA_NORMAL)
+    /// create the CA channel, subscription is made on first connect
+    void create( )
     {
-        pv->dbrType = args.type;
-        pv->nElems = args.count;
-        pv->value = (void *) args.dbr;    /* casting away const */
+        m_tCreate = epicsMonotonicGet();
+        int status = ca_create_channel( m_pvName.c_str(), connectionHandler, this, caPriority, &m_chid );
+        if ( status != ECA_NORMAL )
+        {
+            std::cerr << m_pvName << " ca_create_channel error: " << ca_message( status ) << std::endl;
+            m_chid = NULL;
+            haderror = 1;
+            done();
+        }
+    }
 
-        print_time_val_sts(pv, reqElems);
-        fflush(stdout);
+    /// clear the channel, which also clears the subscription
+    void clear( )
+    {
+        if ( m_chid )
+            ca_clear_channel( m_chid );
+        m_chid = NULL;
+        m_evid = NULL;
+    }
 
-        pv->value = NULL;
+    /// CA connection_handler, called on a CA thread
+    static void connectionHandler( struct connection_handler_args args )
+    {
+        CaTracker	*	pTracker = static_cast<CaTracker *>( ca_puser( args.chid ) );
+        if ( pTracker )
+            pTracker->connectEvent( args.op == CA_OP_CONN_UP );
     }
-}
 
-
-/*+**************************************************************************
- *
- * Function:	connection_handler
- *
- * Description:	CA connection_handler 
- *
- * Arg(s) In:	args  -  connection_handler_args (see CA manual)
- *
- **************************************************************************-*/
-
-static void connection_handler ( struct connection_handler_args args )
-{
-    pv *ppv = ( pv * ) ca_puser ( args.chid );
-    if ( args.op == CA_OP_CONN_UP ) {
-        nConn++;
-        if (!ppv->onceConnected) {
-            ppv->onceConnected = 1;
-                                /* Set up pv structure */
-                                /* ------------------- */
-
-                                /* Get natural type and array count */
-            ppv->dbfType = ca_field_type(ppv->chid);
-            ppv->dbrType = dbf_type_to_DBR_TIME(ppv->dbfType); /* Use native type */
-            if (dbr_type_is_ENUM(ppv->dbrType))                /* Enums honour -n option */
+    /// CA event_handler, called on a CA thread
+    static void eventHandler( struct event_handler_args args )
+    {
+        CaTracker	*	pTracker = static_cast<CaTracker *>( args.usr );
+        if ( pTracker && args.status == ECA_NORMAL && args.dbr != NULL )
+            pTracker->capture( args.type, args.dbr );
+    }
+
+    /// scalarType maps a DBR_TIME_* type to the pvStorage type used for it
+    static pvd::ScalarType scalarType( chtype dbrType )
+    {
+        switch ( dbrType )
+        {
+        default:
+        case DBR_TIME_DOUBLE:
+        case DBR_TIME_FLOAT:
+            return pvd::pvDouble;
+        case DBR_TIME_LONG:
+            return pvd::pvInt;
+        case DBR_TIME_SHORT:
+        case DBR_TIME_ENUM:
+        case DBR_TIME_CHAR:
+            return pvd::pvShort;
+        }
+    }
+
+    void connectEvent( bool fConnected )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        if ( !fConnected )
+        {
+            m_nDisconnects++;
+            if ( !quiet )
+                std::cout << std::setw(pvnamewidth) << std::left << m_pvName << " <Disconnect>" << std::endl;
+            return;
+        }
+
+        if ( m_tConnect == 0 )
+        {
+            m_tConnect = epicsMonotonicGet();
+            connectEvt.signal();
+        }
+        if ( m_dbrType >= 0 )
+            return;     // Subscription survives reconnects
+
+        // Subscribe once, w/ the native type and timestamp
+        chtype	dbrType	= dbf_type_to_DBR_TIME( ca_field_type( m_chid ) );
+        if ( dbrType == DBR_TIME_STRING )
+        {
+            std::cerr << m_pvName << ": DBF_STRING not supported" << std::endl;
+            haderror = 1;
+            done();
+            return;
+        }
+        m_dbrType = dbrType;
+
+        pvCollector	*	pCollector	= pvCollector::getPVCollector( m_pvName, scalarType( dbrType ) );
+        switch ( scalarType( dbrType ) )
+        {
+        default:
+        case pvd::pvDouble:
+            m_pCollector = dynamic_cast<pvStorage<double> *>( pCollector ) ? pCollector : NULL;
+            break;
+        case pvd::pvInt:
+            m_pCollector = dynamic_cast<pvStorage<epicsInt32> *>( pCollector ) ? pCollector : NULL;
+            break;
+        case pvd::pvShort:
+            m_pCollector = dynamic_cast<pvStorage<epicsInt16> *>( pCollector ) ? pCollector : NULL;
+            break;
+        }
+        if ( m_pCollector == NULL )
+            std::cerr << m_pvName << ": No storage for " << dbr_type_to_text( dbrType ) << std::endl;
+
+        int status = ca_create_subscription( dbrType, 1, m_chid, eventMask,
+                                             eventHandler, this, &m_evid );
+        if ( status != ECA_NORMAL )
+        {
+            std::cerr << m_pvName << " ca_create_subscription error: " << ca_message( status ) << std::endl;
+            haderror = 1;
+            done();
+            return;
+        }
+        ca_flush_io();
+    }
+
+    /// capture decodes one DBR_TIME_* update straight from the CA buffer
+    void capture( long type, const void * pDbr )
+    {
+        switch ( type )
+        {
+        case DBR_TIME_DOUBLE:
+            {
+            const struct dbr_time_double * p = static_cast<const struct dbr_time_double *>( pDbr );
+            record<double>( p->stamp, p->status, p->severity, p->value );
+            }
+            break;
+        case DBR_TIME_FLOAT:
+            {
+            const struct dbr_time_float * p = static_cast<const struct dbr_time_float *>( pDbr );
+            record<double>( p->stamp, p->status, p->severity, static_cast<double>( p->value ) );
+            }
+            break;
+        case DBR_TIME_LONG:
+            {
+            const struct dbr_time_long * p = static_cast<const struct dbr_time_long *>( pDbr );
+            record<epicsInt32>( p->stamp, p->status, p->severity, p->value );
+            }
+            break;
+        case DBR_TIME_SHORT:
+            {
+            const struct dbr_time_short * p = static_cast<const struct dbr_time_short *>( pDbr );
+            record<epicsInt16>( p->stamp, p->status, p->severity, p->value );
+            }
+            break;
+        case DBR_TIME_ENUM:
             {
-                if (enumAsNr) ppv->dbrType = DBR_TIME_INT;
-                else          ppv->dbrType = DBR_TIME_STRING;
+            const struct dbr_time_enum * p = static_cast<const struct dbr_time_enum *>( pDbr );
+            record<epicsInt16>( p->stamp, p->status, p->severity, static_cast<epicsInt16>( p->value ) );
             }
-            else if (floatAsString &&
-                     (dbr_type_is_FLOAT(ppv->dbrType) || dbr_type_is_DOUBLE(ppv->dbrType)))
+            break;
+        case DBR_TIME_CHAR:
             {
-                ppv->dbrType = DBR_TIME_STRING;
+            const struct dbr_time_char * p = static_cast<const struct dbr_time_char *>( pDbr );
+            record<epicsInt16>( p->stamp, p->status, p->severity, static_cast<epicsInt16>( p->value ) );
             }
-                                /* Set request count */
-            ppv->nElems   = ca_element_count(ppv->chid);
-            ppv->reqElems = reqElems > ppv->nElems ? ppv->nElems : reqElems;
-
-                                /* Issue CA request */
-                                /* ---------------- */
-            /* install monitor once with first connect */
-            ppv->status = ca_create_subscription(ppv->dbrType,
-                                                ppv->reqElems,
-                                                ppv->chid,
-                                                eventMask,
-                                                event_handler,
-                                                (void*)ppv,
-                                                NULL);
+            break;
+        default:
+            LOG( epics::pvAccess::logLevelDebug, "%s: Unexpected DBR type %ld", m_pvName.c_str(), type );
+            break;
         }
     }
-    else if ( args.op == CA_OP_CONN_DOWN ) {
-        nConn--;
-        ppv->status = ECA_DISCONN;
-        print_time_val_sts(ppv, reqElems);
+
+    /// record counts and saves one sample, w/ the same missed counter check as pvCapture
+    template<typename T>
+    void record( const epicsTimeStamp & stamp, dbr_short_t status, dbr_short_t severity, T value )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        if ( m_tFirstUpdate == 0 )
+            m_tFirstUpdate = epicsMonotonicGet();
+
+        // Only capture values w/ NO_ALARM
+        if ( status != NO_ALARM || severity != NO_ALARM )
+        {
+            m_nAlarms++;
+            return;
+        }
+        m_nUpdates++;
+
+        // Saved in POSIX seconds, same as the pvData timeStamps of pvCapture and pvGet
+        epicsUInt64	tsKey	= static_cast<epicsUInt64>( stamp.secPastEpoch ) + POSIX_TIME_AT_EPICS_EPOCH;
+        tsKey <<= 32;
+        tsKey += stamp.nsec;
+        if ( m_pCollector )
+            static_cast<pvStorage<T> *>( m_pCollector )->saveValue( tsKey, value );
+
+        double	dValue	= static_cast<double>( value );
+        if ( dValue != 0 && ! isnan(m_lastValue) && m_lastValue + 1.0 != dValue )
+        {
+            long int	nMissed = lround( dValue - m_lastValue - 1 );
+            if ( nMissed > 0 )
+                m_nMissed += nMissed;
+            LOG( epics::pvAccess::logLevelError, "%s: Missed %ld, prior %ld, cur %ld", m_pvName.c_str(),
+                nMissed, static_cast<long int>(m_lastValue), static_cast<long int>(dValue) );
+        }
+        m_lastValue = dValue;
+
+        if ( m_fShow )
+            std::cout << std::setw(pvnamewidth) << std::left << m_pvName
+                      << " [ " << ( tsKey >> 32 ) << ", " << stamp.nsec << "] " << value << std::endl;
     }
-}
 
-// This could go to it's own cpp file and header
-// Borrowed from pvmonitor.cpp
-struct Worker
-{
-	virtual ~Worker() {}
-	virtual void process(const pvac::MonitorEvent& event) =0;
-};
+    /// Seconds from creation to first connect, or to first update, < 0 if it never happened
+    double timeToConnect( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_tConnect ? ( m_tConnect - m_tCreate ) * 1.0e-9 : -1.0;
+    }
+    double timeToFirstUpdate( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_tFirstUpdate ? ( m_tFirstUpdate - m_tCreate ) * 1.0e-9 : -1.0;
+    }
+    bool isConnected( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_tConnect != 0;
+    }
 
-// This could go to it's own cpp file and header
-// Borrowed from pvmonitor.cpp
-// simple work queue with thread.
-// moves monitor queue handling off of PVA thread(s)
-struct WorkQueue : public epicsThreadRunable
-{
-	typedef std::tr1::shared_ptr<Worker>	value_type;
-	typedef std::tr1::weak_ptr<Worker>		weak_type;
-	// work queue holds only weak_ptr
-	// so jobs must be kept alive seperately
-	typedef std::deque<std::pair<weak_type, pvac::MonitorEvent> > queue_t;
-	epicsEvent		event;
-	epicsMutex		mutex;
-	queue_t			queue;
-	bool			running;
-	pvd::Thread		worker;
-
-	WorkQueue()
-		:running(true)
-		,worker(pvd::Thread::Config()
-				.name("pvCapture handler")
-				.autostart(true)
-				.run(this))
-	{}
-	~WorkQueue() {close();}
-
-	void close()
-	{
-		{
-			epicsGuard<epicsMutex> G(mutex);
-			running = false;
-		}
-		event.signal();
-		worker.exitWait();
-	}
-
-	void push(const weak_type& cb, const pvac::MonitorEvent& evt)
-	{
-		bool wake;
-		{
-			epicsGuard<epicsMutex> G(mutex);
-			if(!running) return; // silently refuse to queue during/after close()
-			wake = queue.empty();
-			queue.push_back(std::make_pair(cb, evt));
-		}
-		if(wake)
-			event.signal();
-	}
-
-	virtual void run() OVERRIDE FINAL
-	{
-		epicsGuard<epicsMutex> G(mutex);
-
-		while(running) {
-			if(queue.empty()) {
-				epicsGuardRelease<epicsMutex> U(G);
-				event.wait();
-			} else {
-				queue_t::value_type ent(queue.front());
-				value_type cb(ent.first.lock());
-				queue.pop_front();
-				if(!cb) continue;
-
-				try {
-					epicsGuardRelease<epicsMutex> U(G);
-					cb->process(ent.second);
-				}catch(std::exception& e){
-					std::cout << "Error in monitor handler : " << e.what() << "\n";
-				}
-			}
-		}
-	}
-};
+    /// Save the timestamped values in storage to <dir>/<pvName>.caCapture
+    void saveValues( )
+    {
+        std::string     saveFilePath( m_testDirPath );
+        saveFilePath += "/";
+        saveFilePath += m_pvName;
+        saveFilePath += ".caCapture";
 
+        if ( m_pCollector == NULL || m_pCollector->getNumSavedValues() == 0 )
+        {
+            std::cout << "Warning: No values to save to test file: " << saveFilePath << std::endl;
+            return;
+        }
 
-// This could go to it's own cpp file and header
-// Borrowed from pvmonitor.cpp
-struct MonTracker : public pvac::ClientChannel::MonitorCallback,
-					public Worker,
-					public Tracker,
-					public std::tr1::enable_shared_from_this<MonTracker>
-{
-	POINTER_DEFINITIONS(MonTracker);
-
-	MonTracker(WorkQueue& monwork, pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest, const char * testDirPath, bool fShow)
-		:monwork(monwork)
-		,m_QueueSizeMax( 262144	)
-		,valid()
-		,fShow(fShow)
-		,m_testDirPath(testDirPath)
-		,mon(channel.monitor(this, pvRequest)	)
-	{}
-	virtual ~MonTracker()
-	{
-		mon.cancel();
-	}
-
-    epicsMutex		queueLock;
-	WorkQueue	&	monwork;
-	
-	typedef	struct _tsReal
-	{
-		epicsTimeStamp	ts;
-		double			val;
-		_tsReal( ) : ts(), val() { val = NAN; };
-		_tsReal( const epicsTimeStamp & newTs, double newVal ) : ts(newTs), val(newVal){ };
-	}	t_TsReal;
-	size_t					m_QueueSizeMax;
-	std::deque<t_TsReal>	m_ValueQueue;
-
-	pvd::BitSet valid; // only access for process()
-	bool	fShow;
-	std::string		m_testDirPath;
-
-	pvac::Monitor mon; // must be last data member
-
-	/// monitorEvent is called for each new pvAccess event for specified request on this client channel
-	/// The ClientChannel defines: virtual void monitorEvent() = 0;
-	virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
-	{
-	// TODO: Getting this error msg if I create multiple MonTracker objects for the same PV name
-	// Unhandled exception following exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
-	// or
-	// Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): tr1::bad_weak_ptr
-	// Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
-	// Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
-		// shared_from_this() will fail as Cancel is delivered in our dtor.
-		if(evt.event==pvac::MonitorEvent::Cancel) return;
-
-		// running on internal provider worker thread
-		// minimize work here.
-		monwork.push(shared_from_this(), evt);
-	}
-
-	/// Save the timestamped values on the queue to a file
-	void saveValues( )
-	{
-		if ( m_ValueQueue.size() == 0 )
-			return;
-
-		std::string		saveFilePath( m_testDirPath );
-		saveFilePath += "/";
-		saveFilePath += mon.name();
-		// std::cout << "Creating test dir: " << m_testDirPath << std::endl;
-		mkdir( m_testDirPath.c_str(), ACCESSPERMS );
-
-		std::cout << "Writing " << m_ValueQueue.size() << " values to test file: " << saveFilePath << std::endl;
-		std::ofstream	fout( saveFilePath.c_str() );
-		fout << "[" << std::endl;
-		for ( std::deque<t_TsReal>::iterator it = m_ValueQueue.begin(); it != m_ValueQueue.end(); ++it )
-		{
-			fout << "    [ [ " << it->ts.secPastEpoch << ", " << it->ts.nsec << "], " << it->val << " ]," << std::endl;
-		}
-		fout << "]" << std::endl;
-	}
-
-	/// capture is called for each pvAccess MonitorEvent::Data on the WorkQueue
-	virtual void capture(const pvac::MonitorEvent& evt) OVERRIDE FINAL
-	{
-		assert( evt.event == pvac::MonitorEvent::Data );
-		std::tr1::shared_ptr<const pvd::PVStructure>	pvStruct = mon.root;
-		assert( pvStruct != 0 );
-
-		try
-		{
-			std::tr1::shared_ptr<const pvd::PVInt>	pStatus = pvStruct->getSubField<pvd::PVInt>("alarm.status");
-			std::tr1::shared_ptr<const pvd::PVInt>	pSeverity = pvStruct->getSubField<pvd::PVInt>("alarm.severity");
-			// Only capture values w/ alarm.status NO_ALARM
-			if ( pStatus == NULL || pStatus->get() != NO_ALARM )
-				return;
-			if ( pSeverity == NULL || pSeverity->get() != 0 )
-				return;
-			std::tr1::shared_ptr<const pvd::PVDouble>	pValue	= pvStruct->getSubField<pvd::PVDouble>("value");
-			double			value			= NAN;
-			if ( pValue )
-			{
-				value = pValue->getAs<double>();
-			}
-
-			epicsUInt32		secPastEpoch	= 1;
-			epicsUInt32		nsec			= 2;
-			std::tr1::shared_ptr<const pvd::PVScalar>	pScalarSec	= pvStruct->getSubFieldT<pvd::PVScalar>("timeStamp.secondsPastEpoch");
-			if ( pScalarSec )
-			{
-				secPastEpoch	= pScalarSec->getAs<pvd::uint32>();
-			}
-			std::tr1::shared_ptr<const pvd::PVScalar>	pScalarNSec	= pvStruct->getSubFieldT<pvd::PVScalar>("timeStamp.nanoseconds");
-			if ( pScalarNSec )
-			{
-				nsec	= pScalarNSec->getAs<pvd::uint32>();
-			}
-			epicsTimeStamp	timeStamp;
-			timeStamp.secPastEpoch = secPastEpoch;
-			timeStamp.nsec = nsec;
-			//pvd::TimeStamp	timeStamp( secPastEpoch, nsec );
-			t_TsReal	tsValue( timeStamp, value );
-			t_TsReal	tsPrior;
-			assert( isnan(tsPrior.val) );
-
-			{	// Keep guard while accessing m_ValueQueue
-			epicsGuard<epicsMutex> G(queueLock);
-			if ( !m_ValueQueue.empty() )
-				tsPrior = m_ValueQueue.back();
-			if ( ! isnan(tsValue.val) )
-			{
-				if( m_ValueQueue.size() >= m_QueueSizeMax )
-					m_ValueQueue.pop_front();
-				m_ValueQueue.push_back( tsValue );
-			}
-			}
-
-			// Check for missed counter update
-			if ( ! isnan(tsValue.val) && tsValue.val != 0 && ! isnan(tsPrior.val) )
-			{
-				if ( tsPrior.val + 1.0 != tsValue.val )
-				{
-					if ( debugFlag )
-					{
-						std::cout	<< "tsPrior:"
-							<< " val="	<< tsPrior.val	
-							<< ", ts=[" << tsPrior.ts.secPastEpoch << ", " << tsPrior.ts.nsec << "]"
-							<< ", SEVR=" << *pSeverity
-							<< ", STAT=" << *pStatus << "\n";
-						std::cout	<< "tsValue:"
-							<< " val="	<< tsValue.val	
-							<< ", ts=[" << tsValue.ts.secPastEpoch << ", " << tsValue.ts.nsec << "]"
-							<< ", SEVR=" << *pSeverity
-							<< ", STAT=" << *pStatus << "\n";
-					}
-					long int	nMissed = lround( tsValue.val - tsPrior.val - 1 );
-					LOG( epics::pvAccess::logLevelError, "%s: Missed %ld, prior %ld, cur %ld", mon.name().c_str(),
-						nMissed, static_cast<long int>(tsPrior.val), static_cast<long int>(tsValue.val) );
-				}
-			}
-		}
-		catch(std::runtime_error& e)
-		{
-			std::cout << "Bad Field Type in capture handler : " << e.what() << "\n";
-		}
-		catch(std::exception& e)
-		{
-			std::cout << "Error in capture handler : " << e.what() << "\n";
-		}
-	}
-
-	/// process is called for each pvAccess event on the WorkQueue
-	virtual void process(const pvac::MonitorEvent& evt) OVERRIDE FINAL
-	{
-		unsigned n;
-		// running on our worker thread
-		switch(evt.event)
-		{
-		case pvac::MonitorEvent::Fail:
-			std::cerr << std::setw(pvnamewidth) << std::left << mon.name() << " Error " << evt.message << "\n";
-			haderror = 1;
-			done();
-			break;
-		case pvac::MonitorEvent::Cancel:
-			break;
-		case pvac::MonitorEvent::Disconnect:
-			std::cout << std::setw(pvnamewidth) << std::left << mon.name() << " <Disconnect>\n";
-			valid.clear();
-			break;
-		case pvac::MonitorEvent::Data:
-			for(n=0; n<2 && mon.poll(); n++)
-			{
-				valid |= mon.changed;
-
-				// Capture the new value
-				capture( evt );
-				if ( fShow )
-				{
-					// pvd::PVStructure::Formatter fmt(mon.root->stream().format(outmode));
-					// std::cout << std::setw(pvnamewidth) << std::left << mon.name() << ' ' << fmt;
-				}
-			}
-			if(n==2)
-			{
-				// too many updates, re-queue to balance with others
-				monwork.push(shared_from_this(), evt);
-			}
-			else if(n==0)
-			{
-				LOG(epics::pvAccess::logLevelDebug, "%s Spurious Data event on channel", mon.name().c_str());
-			}
-			else
-			{
-				if(mon.complete())
-					done();
-			}
-			break;
-		}
-		std::cout.flush();
-	}
+        int status = mkdir( m_testDirPath.c_str(), ACCESSPERMS );
+        if ( status != 0 && errno != EEXIST )
+        {
+            std::cerr << "CaTracker::saveValues error " << errno << " creating test dir: " << m_testDirPath << std::endl;
+            std::cerr << strerror(errno) << std::endl;
+        }
+        std::cout << "Writing " << m_pCollector->getNumSavedValues() << " values to test file: " << saveFilePath << std::endl;
+        std::ofstream   fout( saveFilePath.c_str() );
+        m_pCollector->writeValues( fout );
+        fout.close();
+    }
+
+    void showStats( std::ostream & out )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        out << std::setw(pvnamewidth) << std::left << m_pvName
+            << std::right
+            << " " << std::setw(10) << ( m_dbrType >= 0 ? dbr_type_to_text( m_dbrType ) : "-" )
+            << " " << std::setw(10) << m_nUpdates
+            << " " << std::setw(10) << m_nMissed
+            << " " << std::setw(10) << m_nAlarms
+            << " " << std::setw(10) << m_nDisconnects
+            << std::left << std::endl;
+    }
+
+    std::string             m_pvName;
+    std::string             m_testDirPath;
+    bool                    m_fShow;
+    chid                    m_chid;
+    evid                    m_evid;
+    chtype                  m_dbrType;      // DBR_TIME_* type subscribed, -1 until first connect
+    pvCollector         *   m_pCollector;   // pvStorage<T> matching scalarType(m_dbrType)
+    epicsMutex              m_lock;         // CA callbacks are preemptive
+    size_t                  m_nUpdates;
+    size_t                  m_nMissed;      // Cumulative missed counts from counter value diffs
+    size_t                  m_nAlarms;      // Updates not captured due to alarm status
+    size_t                  m_nDisconnects;
+    double                  m_lastValue;
+    epicsUInt64             m_tCreate;      // epicsMonotonicGet() ns when channel was created
+    epicsUInt64             m_tConnect;     // ns at first connect, 0 if never
+    epicsUInt64             m_tFirstUpdate; // ns at first update, 0 if none
 };
 
 } // namespace
 
 
-
-/*+**************************************************************************
- *
- * Function:	main
- *
- * Description:	main()
- * 		Evaluate command line options, set up CA, connect the
- * 		channels, collect and print the data as requested
- *
- * Arg(s) In:	[options] <pv-name> ...
- *
- * Arg(s) Out:	none
- *
- * Return(s):	Standard return code (0=success, 1=error)
- *
- **************************************************************************-*/
-
 int main (int argc, char *argv[])
 {
     try
     {
     int opt;                    /* getopt() current option */
-    int digits = 0;             /* getopt() no. of float digits */
-    bool monitor    = true;
     bool fShow      = false;
     std::string         pvFilename("");
     std::vector<std::string>    pvList;
@@ -601,12 +470,13 @@ int main (int argc, char *argv[])
 
     // ================ Parse Arguments
 
-    while ((opt = getopt(argc, argv, ":hvVSRD:M:r:w:tmp:qdcF:f:ni")) != -1) {
+    while ((opt = getopt(argc, argv, ":hVSD:w:m:p:qdf:")) != -1) {
         switch (opt) {
         case 'h':               /* Print usage */
             usage();
             return 0;
         case 'V':               /* Print version */
+            {
             printf( "\nEPICS Version %s, CA Protocol version %s\n", EPICS_VERSION_STRING, ca_version() );
             epics::pvAccess::Version version(EXECNAME, "cpp",
                                 CA_CAPTURE_MAJOR_VERSION,
@@ -614,33 +484,8 @@ int main (int argc, char *argv[])
                                 CA_CAPTURE_MAINTENANCE_VERSION,
                                 CA_CAPTURE_DEVELOPMENT_FLAG);
             fprintf(stdout, "%s\n", version.getVersionString().c_str());
-            return 0;
-        case 'n':               /* Print ENUM as index numbers */
-            enumAsNr=1;
-            break;
-        case 'P':               /* Show Fiducial Pulse ID from timestamps */
-            tsShowPulseId = 1;
-            break;
-        case 't':               /* Select timestamp source(s) and type */
-            tsSrcServer = 0;
-            tsSrcClient = 0;
-            {
-                int i = 0;
-                char c;
-                while ((c = optarg[i++]))
-                    switch (c) {
-                    case 's': tsSrcServer = 1; break;
-                    case 'c': tsSrcClient = 1; break;
-                    case 'n': break;
-                    case 'r': tsType = relative; break;
-                    case 'i': tsType = incremental; break;
-                    case 'I': tsType = incrementalByChan; break;
-                    default :
-                        fprintf(stderr, "Invalid argument '%c' "
-                                "for option '-t' - ignored.\n", c);
-                    }
             }
-            break;
+            return 0;
         case 'w':               /* Set CA timeout value */
             double temp;
             if(epicsScanDouble(optarg, &temp) != 1)
@@ -651,20 +496,12 @@ int main (int argc, char *argv[])
                 timeout = temp;
             }
             break;
-        case '#':               /* Array count */
-            if (sscanf(optarg,"%ld", &reqElems) != 1)
-            {
-                fprintf(stderr, "'%s' is not a valid array element count "
-                        "- ignored. ('camonitor -h' for help.)\n", optarg);
-                reqElems = 0;
-            }
-            break;
         case 'p':               /* CA priority */
             if (sscanf(optarg,"%u", &caPriority) != 1)
             {
                 fprintf(stderr, "'%s' is not a valid CA priority "
-                        "- ignored. ('camonitor -h' for help.)\n", optarg);
-                caPriority = DEFAULT_CA_PRIORITY;
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                caPriority = CA_PRIORITY_DEFAULT;
             }
             if (caPriority > CA_PRIORITY_MAX) caPriority = CA_PRIORITY_MAX;
             break;
@@ -687,47 +524,6 @@ int main (int argc, char *argv[])
                     }
             }
             break;
-        case 's':               /* Select string dbr for floating type data */
-            floatAsString = 1;
-            break;
-        case 'S':               /* Treat char array as (long) string */
-            charArrAsStr = 1;
-            break;
-        case 'e':               /* Select %e/%f/%g format, using <arg> digits */
-        case 'f':
-        case 'g':
-            if (sscanf(optarg, "%d", &digits) != 1)
-                fprintf(stderr, 
-                        "Invalid precision argument '%s' "
-                        "for option '-%c' - ignored.\n", optarg, opt);
-            else
-            {
-                if (digits>=0 && digits<=VALID_DOUBLE_DIGITS)
-                    sprintf(dblFormatStr, "%%-.%d%c", digits, opt);
-                else
-                    fprintf(stderr, "Precision %d for option '-%c' "
-                            "out of range - ignored.\n", digits, opt);
-            }
-            break;
-        case 'l':               /* Convert to long and use integer format */
-        case '0':               /* Select integer format */
-            switch ((char) *optarg) {
-            case 'x': outType = hex; break;    /* x print Hex */
-            case 'b': outType = bin; break;    /* b print Binary */
-            case 'o': outType = oct; break;    /* o print Octal */
-            default :
-                outType = dec;
-                fprintf(stderr, "Invalid argument '%s' "
-                        "for option '-%c' - ignored.\n", optarg, opt);
-            }
-            if (outType != dec) {
-              if (opt == '0') outTypeI = outType;
-              else            outTypeF = outType;
-            }
-            break;
-        case 'F':               /* Store this for output and tool_lib formatting */
-            fieldSeparator = (char) *optarg;
-            break;
         case 'S':
             fShow = true;
             break;
@@ -737,6 +533,9 @@ int main (int argc, char *argv[])
         case 'f':               /* Use input stream as input */
             pvFilename = optarg;
             break;
+        case 'q':               /* Quiet mode */
+            quiet = true;
+            break;
         case 'd':               /* Debug log level */
             debugFlag = true;
             break;
@@ -756,13 +555,6 @@ int main (int argc, char *argv[])
         }
     }
 
-    if(monitor)
-        timeout = -1;
-
-	// Add custom CA exception handler
-	// (void) ca_add_exceptionEvent( pfunc, arg )
-
-
     if ( pvFilename.size() > 0 )
     {
         try
@@ -794,31 +586,53 @@ int main (int argc, char *argv[])
     }
 
     // Everything up to here is just related to handling cmd line arguments
-    {   // Create and run PVA clients for pvNames in argv[argc]
+    {   // Create and run native CA channels for pvNames in argv[argc]
     // Configure logging
     SET_LOG_LEVEL(debugFlag ? epics::pvAccess::logLevelDebug : epics::pvAccess::logLevelError);
 
-    epics::pvAccess::ca::CAClientFactory::start();
-
+    // Preemptive callbacks deliver updates on CA's threads w/o ca_pend_event() polling
+    int status = ca_context_create( ca_enable_preemptive_callback );
+    if ( status != ECA_NORMAL )
     {
-        pvac::ClientProvider provider(defaultProvider);
+        std::cerr << "CA error " << ca_message( status ) << " occurred while trying to start channel access" << std::endl;
+        return 1;
+    }
 
-        std::vector<std::tr1::shared_ptr<MonTracker> > tracked;
+    {
+        std::vector<std::tr1::shared_ptr<CaTracker> > tracked;
 
-        epics::auto_ptr<WorkQueue> Q;
-        Q.reset(new WorkQueue);
+        Tracker::prepare(); // install signal handler
 
         for ( std::vector<std::string>::const_iterator it = pvList.begin(); it != pvList.end(); ++it )
         {
-            pvac::ClientChannel chan( provider.connect(*it) );
-
-            // std::tr1::shared_ptr<MonTracker> mon(new MonTracker(*Q, chan, pvRequest, testDirPath.c_str(), fShow));
-            // tracked.push_back(mon);
+            std::tr1::shared_ptr<CaTracker> tracker( new CaTracker( *it, testDirPath, fShow ) );
+            tracked.push_back( tracker );
+            tracker->create();
         }
+        ca_flush_io();
 
-        // ========================== Wait for operations to complete, or timeout
+        // ========================== Wait for channels to connect, or timeout
 
-        Tracker::prepare(); // install signal handler
+        if(debugFlag)
+            std::cerr << "Connecting...\n";
+        epicsUInt64 tStart  = epicsMonotonicGet();
+        size_t      nConnected;
+        for ( ;; )
+        {
+            nConnected = 0;
+            for ( size_t i = 0; i < tracked.size(); i++ )
+                if ( tracked[i]->isConnected() )
+                    nConnected++;
+            double  waited  = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+            if ( nConnected == tracked.size() || waited >= timeout || Tracker::abort )
+                break;
+            connectEvt.wait( timeout - waited );
+        }
+        if ( nConnected < tracked.size() )
+            std::cerr << ( tracked.size() - nConnected ) << " of " << tracked.size()
+                      << " PVs not connected after " << timeout << " sec" << std::endl;
+
+        // ========================== Capture until signaled, or nothing left to capture
 
         if(debugFlag)
             std::cerr << "Waiting...\n";
@@ -828,26 +642,70 @@ int main (int argc, char *argv[])
             while(Tracker::inprog.size() && !Tracker::abort)
             {
                 epicsGuardRelease<epicsMutex> U(G);
-                if(timeout<=0)
-                {
-                    Tracker::doneEvt.wait();
-                }
-                else if(!Tracker::doneEvt.wait(timeout))
-                {
-                    haderror = 1;
-                    std::cerr << "Timeout" << std::endl;
-                    break;
-                }
+                Tracker::doneEvt.wait();
             }
         }
 
+        // Stop all callbacks before reporting and saving
+        for ( size_t i = 0; i < tracked.size(); i++ )
+            tracked[i]->clear();
+
         std::cout << std::endl;
-        for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+        size_t  totalUpdates    = 0;
+        size_t  totalMissed     = 0;
+        size_t  totalAlarms     = 0;
+        std::cout << std::setw(pvnamewidth) << std::left << "PV"
+                  << std::right
+                  << " " << std::setw(10) << "Type"
+                  << " " << std::setw(10) << "Updates"
+                  << " " << std::setw(10) << "Missed"
+                  << " " << std::setw(10) << "Alarms"
+                  << " " << std::setw(10) << "Discons"
+                  << std::left << std::endl;
+        for ( std::vector<std::tr1::shared_ptr<CaTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
         {
-            (*it)->saveValues();
+            (*it)->showStats( std::cout );
+            totalUpdates    += (*it)->m_nUpdates;
+            totalMissed     += (*it)->m_nMissed;
+            totalAlarms     += (*it)->m_nAlarms;
+        }
+        std::cout << "Total: " << totalUpdates << " updates, " << totalMissed << " missed, "
+                  << totalAlarms << " w/ alarms" << std::endl;
+
+        // Startup report: time from channel creation to connect and to first update
+        pvHistogram     connectTimes( "time to connect" );
+        pvHistogram     firstUpdateTimes( "time to first update" );
+        size_t          nNeverConnected = 0;
+        size_t          nNoUpdate       = 0;
+        for ( std::vector<std::tr1::shared_ptr<CaTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+        {
+            double  tConnect    = (*it)->timeToConnect();
+            double  tFirst      = (*it)->timeToFirstUpdate();
+            if ( tConnect < 0 )
+            {
+                nNeverConnected++;
+                if ( debugFlag )
+                    std::cout << (*it)->m_pvName << " never connected" << std::endl;
+            }
+            else
+                connectTimes.add( tConnect );
+            if ( tFirst < 0 )
+                nNoUpdate++;
+            else
+                firstUpdateTimes.add( tFirst );
         }
+        std::cout << "Startup: " << nNeverConnected << " PVs never connected, "
+                  << nNoUpdate << " PVs w/o updates" << std::endl;
+        connectTimes.show( std::cout, true );
+        firstUpdateTimes.show( std::cout );
 
+        for ( std::vector<std::tr1::shared_ptr<CaTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+        {
+            (*it)->saveValues();
+        }
     }
+    ca_context_destroy();
+
     // ========================== All done now
 
     if(debugFlag)
@@ -0,0 +1,923 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <epicsGetopt.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <pv/thread.h>
+#include <pv/pvAccess.h>
+
+#include "pvCaptureFile.h"
+#include "pvGapScan.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvAnalyze"
+#endif
+
+#define PV_ANALYZE_MAJOR_VERSION		0
+#define PV_ANALYZE_MINOR_VERSION		1
+#define PV_ANALYZE_MAINTENANCE_VERSION	0
+#define PV_ANALYZE_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool        debugFlag       = false;
+bool        fPVRates        = true;     // Per PV per second rates in the summary, -c leaves them out
+double      gapScanPeriod   = 0.0;      // Nominal update period for the -J gap scan, 0 for none
+size_t      nThreads        = 0;        // Analysis threads, 0 for one per CPU
+epicsUInt32 outlierWindow   = 7 * 86400;    // Max sec from the median second before a timestamp is an outlier, -w
+
+/// One timestamped value, or a timeout from a legacy .pvget file
+struct TsValue
+{
+    epicsUInt64     tsKey;
+    double          value;
+    bool            fTimeout;
+
+    bool operator<( const TsValue & other ) const
+    {
+        return tsKey < other.tsKey;
+    }
+};
+
+/// One test file, found by the scan
+struct TestFile
+{
+    std::string     filePath;
+    std::string     fileType;   // pvCapture, caCapture or pvget, same as stressTestFile.getFileType()
+    size_t          numLines;
+    size_t          numTsValues;
+    size_t          numTimeouts;
+    size_t          numBytes;
+    bool            fOk;
+
+    TestFile() : numLines( 0 ), numTsValues( 0 ), numTimeouts( 0 ), numBytes( 0 ), fOk( false ) {}
+};
+
+/// Per PV results, same metrics as stressTestPV.analyze()
+/// Per second rates are indexed from firstSec, w/ zeroes for gaps
+struct TestPV
+{
+    std::string             pvName;
+    size_t                  iClient;
+    std::vector<size_t>     files;          // Indices into testFiles
+    size_t                  numTsValues;    // Unique timestamps, timeouts included
+    size_t                  numMissed;      // Missed counter values
+    size_t                  numTimeouts;
+    size_t                  numOutliers;    // Timestamps dropped, too far from the PV's median second
+    double                  startTime;
+    double                  endTime;
+    epicsUInt32             firstSec;
+    std::vector<epicsUInt32>    tsRates;
+    std::vector<epicsUInt32>    tsMissRates;
+    std::vector<epicsUInt32>    timeoutRates;
+    std::tr1::shared_ptr<pvGapScan> gapScan;    // Arrival order scan w/ -J
+
+    TestPV() : iClient( 0 ), numTsValues( 0 ), numMissed( 0 ), numTimeouts( 0 ), numOutliers( 0 ), startTime( 0.0 ), endTime( 0.0 ), firstSec( 0 ) {}
+};
+
+/// Per client totals, same metrics as stressTestClient.analyze()
+struct TestClient
+{
+    std::string             clientName;
+    std::string             hostName;
+    std::string             clientType;     // Type of its first file
+    std::vector<size_t>     pvs;            // Indices into testPVs
+    size_t                  numTsValues;
+    size_t                  numMissed;
+    size_t                  numTimeouts;
+    size_t                  numOutliers;    // PV outliers, plus the values of PVs too far from the client's median second
+    double                  startTime;
+    double                  endTime;
+    epicsUInt32             firstSec;
+    std::vector<epicsUInt32>    tsRates;
+    std::vector<epicsUInt32>    tsMissRates;
+
+    TestClient() : numTsValues( 0 ), numMissed( 0 ), numTimeouts( 0 ), numOutliers( 0 ), startTime( 0.0 ), endTime( 0.0 ), firstSec( 0 ) {}
+};
+
+std::vector<TestFile>       testFiles;
+std::vector<TestPV>         testPVs;
+std::vector<TestClient>     testClients;
+
+bool endsWith( const std::string & str, const std::string & suffix )
+{
+    return str.size() >= suffix.size() && str.compare( str.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+/// fileTypeOf returns the stressTest.readFiles type for fileName, empty if not a test file
+std::string fileTypeOf( const std::string & fileName )
+{
+    if ( endsWith( fileName, ".pvget" ) )
+        return "pvget";
+    // Binary files from pvCaptureConvert count as the type they were converted from
+    if ( endsWith( fileName, "pvCaptureBin" ) )
+        return "pvCapture";
+    if ( endsWith( fileName, ".caCaptureBin" ) )
+        return "caCapture";
+    if ( endsWith( fileName, "pvCapture" ) )
+        return "pvCapture";
+    if ( endsWith( fileName, ".caCapture" ) )
+        return "caCapture";
+    return std::string();
+}
+
+/// scanDir walks dirPath, adding client test files to testFiles, testPVs and testClients.
+/// Test files follow TESTNAME/HOSTNAME/clients/CLIENTNAME/PVNAME.*, see stressTestClient.pathToTestAttr
+void scanDir( const std::string & dirPath, std::map<std::string, size_t> & clientIndex,
+              std::map<std::string, size_t> & pvIndex )
+{
+    DIR *   dir = opendir( dirPath.c_str() );
+    if ( dir == NULL )
+    {
+        std::cerr << EXECNAME ": Unable to read directory " << dirPath << std::endl;
+        return;
+    }
+    std::vector<std::string>    names;
+    for ( struct dirent * entry = readdir( dir ); entry != NULL; entry = readdir( dir ) )
+        if ( strcmp( entry->d_name, "." ) != 0 && strcmp( entry->d_name, ".." ) != 0 )
+            names.push_back( entry->d_name );
+    closedir( dir );
+    std::sort( names.begin(), names.end() );
+
+    for ( size_t i = 0; i < names.size(); i++ )
+    {
+        std::string     filePath( dirPath + "/" + names[i] );
+        struct stat     fileStat;
+        if ( stat( filePath.c_str(), &fileStat ) != 0 )
+            continue;
+        if ( S_ISDIR( fileStat.st_mode ) )
+        {
+            scanDir( filePath, clientIndex, pvIndex );
+            continue;
+        }
+        std::string     fileType( fileTypeOf( names[i] ) );
+        if ( fileType.empty() )
+            continue;
+        // Read the binary copy of a converted file instead of the text
+        if (    pvCaptureFile::isCaptureFileName( names[i] )
+            &&  std::binary_search( names.begin(), names.end(), pvCaptureFile::binaryFileName( names[i] ) ) )
+            continue;
+
+        // .../HOSTNAME/clients/CLIENTNAME/FILENAME
+        std::vector<std::string>    parts;
+        std::string::size_type      end = dirPath.size();
+        for ( size_t iPart = 0; iPart < 3 && end != std::string::npos && end > 0; iPart++ )
+        {
+            std::string::size_type  slash = dirPath.rfind( '/', end - 1 );
+            std::string::size_type  start = ( slash == std::string::npos ) ? 0 : slash + 1;
+            parts.push_back( dirPath.substr( start, end - start ) );
+            end = slash;
+        }
+        if ( parts.size() < 3 || parts[1] != "clients" )
+            continue;
+        const std::string &     clientName  = parts[0];
+        const std::string &     hostName    = parts[2];
+        std::string             pvName( names[i], 0, names[i].find( '.' ) );
+        if ( pvName == clientName )
+            continue;
+
+        std::map<std::string, size_t>::iterator itClient = clientIndex.find( clientName );
+        if ( itClient == clientIndex.end() )
+        {
+            TestClient  client;
+            client.clientName   = clientName;
+            client.hostName     = hostName;
+            client.clientType   = fileType;
+            itClient = clientIndex.insert( std::make_pair( clientName, testClients.size() ) ).first;
+            testClients.push_back( client );
+        }
+        TestClient &    client  = testClients[itClient->second];
+        if ( client.hostName != hostName )
+        {
+            std::cerr << EXECNAME ": Client " << clientName << " host is " << client.hostName
+                      << ", not " << hostName << ", " << filePath << " ignored" << std::endl;
+            continue;
+        }
+        if ( client.clientType != fileType )
+            std::cerr << EXECNAME ": Client " << clientName << ", type " << client.clientType
+                      << " Warning: Adding type " << fileType << std::endl;
+
+        std::string     pvKey( clientName + "/" + pvName );
+        std::map<std::string, size_t>::iterator itPV = pvIndex.find( pvKey );
+        if ( itPV == pvIndex.end() )
+        {
+            TestPV  testPV;
+            testPV.pvName   = pvName;
+            testPV.iClient  = itClient->second;
+            itPV = pvIndex.insert( std::make_pair( pvKey, testPVs.size() ) ).first;
+            client.pvs.push_back( testPVs.size() );
+            testPVs.push_back( testPV );
+        }
+        TestFile    testFile;
+        testFile.filePath   = filePath;
+        testFile.fileType   = fileType;
+        testPVs[itPV->second].files.push_back( testFiles.size() );
+        testFiles.push_back( testFile );
+    }
+}
+
+/// readPVGetFile reads legacy pvget command line output:
+///   PV:NAME YYYY-MM-DD HH:MM:SS.FFF  VALUE
+/// or a Timeout line.  Timeouts have no timestamp and are placed 2 sec after the
+/// prior value, as in stressTestFile.processPVGetFile
+bool readPVGetFile( TestFile & testFile, std::vector<TsValue> & tsValues )
+{
+    pvMappedFile    mappedFile;
+    if ( mappedFile.open( testFile.filePath ) != 0 )
+    {
+        std::cerr << EXECNAME ": Unable to open " << testFile.filePath << std::endl;
+        return false;
+    }
+    testFile.numBytes   = mappedFile.size();
+    epicsUInt64     priorKey    = 0;
+    bool            fPrior      = false;
+    for ( const char * p = mappedFile.begin(); p < mappedFile.end(); )
+    {
+        const char *    pEol    = static_cast<const char *>( memchr( p, '\n', mappedFile.end() - p ) );
+        if ( pEol == NULL )
+            pEol = mappedFile.end();
+        std::string     line( p, pEol );
+        p = pEol + 1;
+        testFile.numLines++;
+
+        TsValue     tsValue;
+        if ( line.compare( 0, 7, "Timeout" ) == 0 )
+        {
+            testFile.numTimeouts++;
+            if ( !fPrior )
+                continue;
+            tsValue.tsKey       = priorKey + ( static_cast<epicsUInt64>( 2 ) << 32 ) + 1;
+            tsValue.value       = 0.0;
+            tsValue.fTimeout    = true;
+        }
+        else
+        {
+            char        pvName[256];
+            struct tm   tmValue;
+            double      sec;
+            memset( &tmValue, 0, sizeof(tmValue) );
+            if ( sscanf( line.c_str(), "%255s %d-%d-%d %d:%d:%lf %lf", pvName, &tmValue.tm_year, &tmValue.tm_mon,
+                         &tmValue.tm_mday, &tmValue.tm_hour, &tmValue.tm_min, &sec, &tsValue.value ) != 8 )
+                continue;
+            tmValue.tm_year -= 1900;
+            tmValue.tm_mon  -= 1;
+            tmValue.tm_sec  = static_cast<int>( sec );
+            // pvget prints no zone, stressTestFile.py reads it as UTC too
+            time_t      posixSec    = timegm( &tmValue );
+            epicsUInt32 nsec        = static_cast<epicsUInt32>( ( sec - tmValue.tm_sec ) * 1.0e9 );
+            tsValue.tsKey       = ( static_cast<epicsUInt64>( posixSec ) << 32 ) + nsec;
+            tsValue.fTimeout    = false;
+        }
+        priorKey    = tsValue.tsKey;
+        fPrior      = true;
+        tsValues.push_back( tsValue );
+    }
+    testFile.numTsValues    = tsValues.size();
+    return true;
+}
+
+/// readCaptureFile reads a .pvCapture or .caCapture file, text or binary
+bool readCaptureFile( TestFile & testFile, std::vector<TsValue> & tsValues )
+{
+    pvMappedFile    mappedFile;
+    if ( mappedFile.open( testFile.filePath ) != 0 )
+    {
+        std::cerr << EXECNAME ": Unable to open " << testFile.filePath << std::endl;
+        return false;
+    }
+    testFile.numBytes   = mappedFile.size();
+    pvCaptureFile   captureFile;
+    int             status  = captureFile.parse( mappedFile.begin(), mappedFile.end(), testFile.filePath );
+    testFile.numLines   = captureFile.getNumLines();
+    if ( status != 0 )
+        std::cerr << EXECNAME ": " << testFile.filePath << " kept " << captureFile.getNumSamples()
+                  << " samples before the parse error" << std::endl;
+    const std::vector<epicsUInt64> &    tsKeys  = captureFile.getTsKeys();
+    const std::vector<double> &         values  = captureFile.getValues();
+    tsValues.reserve( tsValues.size() + tsKeys.size() );
+    for ( size_t i = 0; i < tsKeys.size(); i++ )
+    {
+        TsValue     tsValue;
+        tsValue.tsKey       = tsKeys[i];
+        tsValue.value       = values[i];
+        tsValue.fTimeout    = false;
+        tsValues.push_back( tsValue );
+    }
+    testFile.numTsValues    = tsKeys.size();
+    return true;
+}
+
+/// gapScanFile scans the values read from one file, tsValues from iFirst on, in file order
+void gapScanFile( pvGapScan & gapScan, const std::vector<TsValue> & tsValues, size_t iFirst )
+{
+    std::vector<epicsUInt64>    tsKeys;
+    std::vector<double>         values;
+    tsKeys.reserve( tsValues.size() - iFirst );
+    values.reserve( tsValues.size() - iFirst );
+    for ( size_t i = iFirst; i < tsValues.size(); i++ )
+    {
+        if ( tsValues[i].fTimeout )
+            continue;
+        tsKeys.push_back( tsValues[i].tsKey );
+        values.push_back( tsValues[i].value );
+    }
+    gapScan.scan( tsKeys, values );
+    gapScan.endSeries();
+}
+
+/// analyzePV reads all files of one PV and computes its metrics
+void analyzePV( TestPV & testPV )
+{
+    std::vector<TsValue>    tsValues;
+    if ( gapScanPeriod > 0.0 )
+    {
+        pvGapScan::Config   config;
+        config.period   = gapScanPeriod;
+        testPV.gapScan.reset( new pvGapScan( testPV.pvName, config ) );
+    }
+    for ( size_t i = 0; i < testPV.files.size(); i++ )
+    {
+        TestFile &  testFile    = testFiles[testPV.files[i]];
+        size_t      iFirst      = tsValues.size();
+        if ( testFile.fileType == "pvget" )
+            testFile.fOk = readPVGetFile( testFile, tsValues );
+        else
+            testFile.fOk = readCaptureFile( testFile, tsValues );
+        // Before sorting, backwards timestamps only show in arrival order
+        if ( testPV.gapScan )
+            gapScanFile( *testPV.gapScan, tsValues, iFirst );
+    }
+    if ( tsValues.empty() )
+        return;
+
+    // stressTestPV keys values by timestamp, the last value for a timestamp wins
+    std::stable_sort( tsValues.begin(), tsValues.end() );
+    size_t  nUnique = 0;
+    for ( size_t i = 0; i < tsValues.size(); i++ )
+    {
+        if ( nUnique && tsValues[nUnique - 1].tsKey == tsValues[i].tsKey )
+            tsValues[nUnique - 1] = tsValues[i];
+        else
+            tsValues[nUnique++] = tsValues[i];
+    }
+    tsValues.resize( nUnique );
+
+    // The per second rates are dense, so one stray timestamp, ex. a 0 stamp
+    // from an unprocessed record, would size them for decades.  Drop the
+    // timestamps too far from the median second as outliers.
+    epicsUInt64 medianSec   = tsValues[tsValues.size() / 2].tsKey >> 32;
+    TsValue     lo, hi;
+    lo.tsKey    = medianSec > outlierWindow ? ( medianSec - outlierWindow ) << 32 : 0;
+    hi.tsKey    = ( medianSec + outlierWindow + 1 ) << 32;
+    std::vector<TsValue>::iterator  itLo    = std::lower_bound( tsValues.begin(), tsValues.end(), lo );
+    std::vector<TsValue>::iterator  itHi    = std::lower_bound( itLo, tsValues.end(), hi );
+    testPV.numOutliers  = tsValues.size() - ( itHi - itLo );
+    tsValues.erase( itHi, tsValues.end() );
+    tsValues.erase( tsValues.begin(), itLo );
+
+    testPV.numTsValues  = tsValues.size();
+    testPV.startTime    = ( tsValues.front().tsKey >> 32 ) + ( tsValues.front().tsKey & 0xFFFFFFFF ) * 1.0e-9;
+    testPV.endTime      = ( tsValues.back().tsKey >> 32 ) + ( tsValues.back().tsKey & 0xFFFFFFFF ) * 1.0e-9;
+    testPV.firstSec     = static_cast<epicsUInt32>( tsValues.front().tsKey >> 32 );
+    size_t  nSec        = static_cast<size_t>( ( tsValues.back().tsKey >> 32 ) - testPV.firstSec ) + 1;
+    testPV.tsRates.assign( nSec, 0 );
+    testPV.tsMissRates.assign( nSec, 0 );
+    testPV.timeoutRates.assign( nSec, 0 );
+
+    bool    fPrior      = false;
+    double  priorValue  = 0.0;
+    for ( size_t i = 0; i < tsValues.size(); i++ )
+    {
+        size_t  iSec    = static_cast<size_t>( ( tsValues[i].tsKey >> 32 ) - testPV.firstSec );
+        testPV.tsRates[iSec]++;
+        if ( tsValues[i].fTimeout )
+        {
+            testPV.timeoutRates[iSec]++;
+            testPV.numTimeouts++;
+            continue;
+        }
+        // Counts missed between counter values, a counter reset is not a miss
+        if ( fPrior && tsValues[i].value > priorValue + 1.0 )
+        {
+            epicsUInt32 nMissed = static_cast<epicsUInt32>( tsValues[i].value - priorValue - 1.0 );
+            testPV.tsMissRates[iSec]    += nMissed;
+            testPV.numMissed            += nMissed;
+        }
+        priorValue  = tsValues[i].value;
+        fPrior      = true;
+    }
+}
+
+// This could go to it's own cpp file and header
+/// AnalyzeWorker
+/// One thread of the pool, analyzes PVs until none are left.  PVs are handed
+/// out one at a time so a few huge files don't leave the other threads idle.
+struct AnalyzeWorker : public epicsThreadRunable
+{
+    static epicsMutex   c_lock;
+    static size_t       c_nextPV;   // guarded by c_lock
+
+    virtual void run()
+    {
+        for ( ;; )
+        {
+            size_t  iPV;
+            {
+                epicsGuard<epicsMutex> G(c_lock);
+                if ( c_nextPV >= testPVs.size() )
+                    break;
+                iPV = c_nextPV++;
+            }
+            analyzePV( testPVs[iPV] );
+        }
+    }
+};
+
+epicsMutex  AnalyzeWorker::c_lock;
+size_t      AnalyzeWorker::c_nextPV = 0;
+
+/// addRates adds a per second rate vector starting at srcFirst to dst starting at dstFirst
+void addRates( std::vector<epicsUInt32> & dst, epicsUInt32 dstFirst, const std::vector<epicsUInt32> & src, epicsUInt32 srcFirst )
+{
+    for ( size_t i = 0; i < src.size(); i++ )
+        dst[srcFirst - dstFirst + i] += src[i];
+}
+
+/// analyzeClient rolls its PVs up, same as stressTestClient.analyze()
+void analyzeClient( TestClient & client )
+{
+    // A PV w/ only stray timestamps would stretch the client's dense rates the
+    // same way, so PVs too far from the median first second aren't rolled up
+    std::vector<epicsUInt32>    firstSecs;
+    for ( size_t i = 0; i < client.pvs.size(); i++ )
+        if ( testPVs[client.pvs[i]].numTsValues )
+            firstSecs.push_back( testPVs[client.pvs[i]].firstSec );
+    epicsUInt32 medianSec   = 0;
+    if ( !firstSecs.empty() )
+    {
+        std::nth_element( firstSecs.begin(), firstSecs.begin() + firstSecs.size() / 2, firstSecs.end() );
+        medianSec = firstSecs[firstSecs.size() / 2];
+    }
+    std::vector<bool>   fRollUp( client.pvs.size(), false );
+
+    bool        fTimes  = false;
+    epicsUInt32 lastSec = 0;
+    for ( size_t i = 0; i < client.pvs.size(); i++ )
+    {
+        const TestPV &  testPV  = testPVs[client.pvs[i]];
+        client.numTsValues  += testPV.numTsValues;
+        client.numMissed    += testPV.numMissed;
+        client.numTimeouts  += testPV.numTimeouts;
+        client.numOutliers  += testPV.numOutliers;
+        if ( testPV.numTsValues == 0 )
+            continue;
+        epicsUInt32 pvLastSec   = testPV.firstSec + static_cast<epicsUInt32>( testPV.tsRates.size() ) - 1;
+        if (    testPV.firstSec + static_cast<epicsUInt64>( outlierWindow ) < medianSec
+            ||  pvLastSec > static_cast<epicsUInt64>( medianSec ) + outlierWindow )
+        {
+            client.numOutliers  += testPV.numTsValues;
+            continue;
+        }
+        fRollUp[i] = true;
+        if ( !fTimes || testPV.startTime < client.startTime )
+            client.startTime = testPV.startTime;
+        if ( !fTimes || testPV.endTime > client.endTime )
+            client.endTime = testPV.endTime;
+        if ( !fTimes || testPV.firstSec < client.firstSec )
+            client.firstSec = testPV.firstSec;
+        if ( !fTimes || pvLastSec > lastSec )
+            lastSec = pvLastSec;
+        fTimes = true;
+    }
+    if ( !fTimes )
+        return;
+    client.tsRates.assign( lastSec - client.firstSec + 1, 0 );
+    client.tsMissRates.assign( lastSec - client.firstSec + 1, 0 );
+    for ( size_t i = 0; i < client.pvs.size(); i++ )
+    {
+        const TestPV &  testPV  = testPVs[client.pvs[i]];
+        if ( !fRollUp[i] )
+            continue;
+        addRates( client.tsRates, client.firstSec, testPV.tsRates, testPV.firstSec );
+        addRates( client.tsMissRates, client.firstSec, testPV.tsMissRates, testPV.firstSec );
+    }
+}
+
+/// writeJsonString writes str as a quoted JSON string
+void writeJsonString( std::ostream & out, const std::string & str )
+{
+    out << '"';
+    for ( size_t i = 0; i < str.size(); i++ )
+    {
+        if ( str[i] == '"' || str[i] == '\\' )
+            out << '\\';
+        out << str[i];
+    }
+    out << '"';
+}
+
+void writeJsonRates( std::ostream & out, const char * name, const std::vector<epicsUInt32> & rates )
+{
+    out << ", \"" << name << "\": [";
+    for ( size_t i = 0; i < rates.size(); i++ )
+        out << ( i ? "," : "" ) << rates[i];
+    out << "]";
+}
+
+/// writeJsonGapScan writes the -J gap scan results of one PV
+void writeJsonGapScan( std::ostream & out, const pvGapScan & gapScan )
+{
+    const pvHistogram & interArrival    = gapScan.getInterArrival();
+    out << ",\n          \"gapScan\": { \"numSteps\": " << gapScan.getNumSteps()
+        << ", \"numMissed\": " << gapScan.getNumMissed()
+        << ", \"numBackwards\": " << gapScan.getNumBackwards()
+        << ", \"numLate\": " << gapScan.getNumLate()
+        << ", \"numEarly\": " << gapScan.getNumEarly()
+        << ", \"jitter\": " << gapScan.getJitter()
+        << ", \"maxJitter\": " << gapScan.getMaxJitter()
+        << ", \"interArrivalP50\": " << interArrival.percentile( 50.0 )
+        << ", \"interArrivalP99\": " << interArrival.percentile( 99.0 )
+        << ", \"interArrivalMax\": " << interArrival.max();
+    if ( fPVRates )
+    {
+        // Step sizes as keys, so counter resets and repeats stand out from misses
+        char    step[32];
+        const std::map<double, epicsUInt64> &   steps   = gapScan.getSteps();
+        out << ", \"steps\": {";
+        for ( std::map<double, epicsUInt64>::const_iterator it = steps.begin(); it != steps.end(); ++it )
+        {
+            snprintf( step, sizeof(step), "%.17g", it->first );
+            out << ( it == steps.begin() ? " \"" : ", \"" ) << step << "\": " << it->second;
+        }
+        out << " }";
+        const std::vector<pvGapScan::Exception> &   exceptions  = gapScan.getExceptions();
+        out << ",\n            \"exceptions\": [";
+        for ( size_t i = 0; i < exceptions.size(); i++ )
+            out << ( i ? ", " : " " ) << "[ " << exceptions[i].index << ", \"" << pvGapScan::exceptionName( exceptions[i].type )
+                << "\", " << ( exceptions[i].tsKey >> 32 ) << ", " << ( exceptions[i].tsKey & 0xFFFFFFFF )
+                << ", " << exceptions[i].delta << " ]";
+        out << " ]";
+    }
+    out << " }";
+}
+
+/// writeJson writes the summary stressTest.readSummary() loads.  Per second rates
+/// are arrays starting at firstSec instead of dicts keyed by second, to keep it compact.
+void writeJson( std::ostream & out, const std::string & testName, const std::string & testPath )
+{
+    size_t      numTsValues = 0, numMissed = 0, numTimeouts = 0, numOutliers = 0;
+    bool        fTimes      = false;
+    double      startTime   = 0.0, endTime = 0.0;
+    for ( size_t i = 0; i < testClients.size(); i++ )
+    {
+        const TestClient &  client  = testClients[i];
+        numTsValues += client.numTsValues;
+        numMissed   += client.numMissed;
+        numTimeouts += client.numTimeouts;
+        numOutliers += client.numOutliers;
+        if ( client.tsRates.empty() )
+            continue;
+        if ( !fTimes || client.startTime < startTime )
+            startTime = client.startTime;
+        if ( !fTimes || client.endTime > endTime )
+            endTime = client.endTime;
+        fTimes = true;
+    }
+
+    // Same totals as the file type table in stressTest.report()
+    std::map<std::string, TestFile> fileTypes;
+    std::map<std::string, size_t>   fileTypeCounts;
+    for ( size_t i = 0; i < testFiles.size(); i++ )
+    {
+        TestFile &  total   = fileTypes[testFiles[i].fileType];
+        total.numLines      += testFiles[i].numLines;
+        total.numTsValues   += testFiles[i].numTsValues;
+        total.numTimeouts   += testFiles[i].numTimeouts;
+        fileTypeCounts[testFiles[i].fileType]++;
+    }
+
+    std::ios::fmtflags  flags( out.flags() );
+    out << std::fixed << std::setprecision(9);
+    out << "{\n"
+        << "  \"tool\": \"" EXECNAME "\",\n"
+        << "  \"version\": \"" << PV_ANALYZE_MAJOR_VERSION << "." << PV_ANALYZE_MINOR_VERSION
+                                << "." << PV_ANALYZE_MAINTENANCE_VERSION << "\",\n"
+        << "  \"testName\": ";
+    writeJsonString( out, testName );
+    out << ",\n  \"testPath\": ";
+    writeJsonString( out, testPath );
+    out << ",\n"
+        << "  \"gapScanPeriod\": " << gapScanPeriod << ",\n"
+        << "  \"startTime\": " << startTime << ",\n"
+        << "  \"endTime\": " << endTime << ",\n"
+        << "  \"numPVs\": " << testPVs.size() << ",\n"
+        << "  \"numTsValues\": " << numTsValues << ",\n"
+        << "  \"numMissed\": " << numMissed << ",\n"
+        << "  \"numTimeouts\": " << numTimeouts << ",\n"
+        << "  \"numOutliers\": " << numOutliers << ",\n"
+        << "  \"fileTypes\": {";
+    for ( std::map<std::string, TestFile>::iterator it = fileTypes.begin(); it != fileTypes.end(); ++it )
+    {
+        out << ( it == fileTypes.begin() ? "\n" : ",\n" ) << "    \"" << it->first << "\": { \"numFiles\": " << fileTypeCounts[it->first]
+            << ", \"numLines\": " << it->second.numLines << ", \"numTsValues\": " << it->second.numTsValues
+            << ", \"numTimeouts\": " << it->second.numTimeouts << " }";
+    }
+    out << "\n  },\n"
+        << "  \"clients\": [";
+    for ( size_t iClient = 0; iClient < testClients.size(); iClient++ )
+    {
+        const TestClient &  client  = testClients[iClient];
+        out << ( iClient ? ",\n" : "\n" ) << "    { \"name\": ";
+        writeJsonString( out, client.clientName );
+        out << ", \"host\": ";
+        writeJsonString( out, client.hostName );
+        out << ", \"type\": \"" << client.clientType << "\""
+            << ", \"numPVs\": " << client.pvs.size()
+            << ", \"numTsValues\": " << client.numTsValues
+            << ", \"numMissed\": " << client.numMissed
+            << ", \"numTimeouts\": " << client.numTimeouts
+            << ", \"numOutliers\": " << client.numOutliers
+            << ", \"startTime\": " << client.startTime
+            << ", \"endTime\": " << client.endTime
+            << ", \"firstSec\": " << client.firstSec;
+        writeJsonRates( out, "tsRates", client.tsRates );
+        writeJsonRates( out, "tsMissRates", client.tsMissRates );
+        out << ",\n      \"pvs\": [";
+        for ( size_t i = 0; i < client.pvs.size(); i++ )
+        {
+            const TestPV &  testPV  = testPVs[client.pvs[i]];
+            out << ( i ? ",\n" : "\n" ) << "        { \"name\": ";
+            writeJsonString( out, testPV.pvName );
+            out << ", \"numTsValues\": " << testPV.numTsValues
+                << ", \"numMissed\": " << testPV.numMissed
+                << ", \"numTimeouts\": " << testPV.numTimeouts
+                << ", \"numOutliers\": " << testPV.numOutliers
+                << ", \"startTime\": " << testPV.startTime
+                << ", \"endTime\": " << testPV.endTime
+                << ", \"firstSec\": " << testPV.firstSec;
+            if ( fPVRates )
+            {
+                writeJsonRates( out, "tsRates", testPV.tsRates );
+                writeJsonRates( out, "tsMissRates", testPV.tsMissRates );
+                writeJsonRates( out, "timeoutRates", testPV.timeoutRates );
+            }
+            if ( testPV.gapScan )
+                writeJsonGapScan( out, *testPV.gapScan );
+            out << " }";
+        }
+        out << "\n      ] }";
+    }
+    out << "\n  ]\n}\n";
+    out.flags( flags );
+}
+
+/// showReport prints the client table of stressTest.report( level=2 )
+void showReport( std::ostream & out, const std::string & testName )
+{
+    char    line[256];
+    out << "\nStressTest Report:\n" << "TestName: " << testName << "\n";
+    out << "Clients                            NumPVs NumTsValues NumMissed Timeouts\n";
+    size_t  numTsValues = 0, numMissed = 0, numTimeouts = 0, numOutliers = 0;
+    std::vector<std::pair<std::string, size_t> >    sorted;
+    for ( size_t i = 0; i < testClients.size(); i++ )
+        sorted.push_back( std::make_pair( testClients[i].clientName, i ) );
+    std::sort( sorted.begin(), sorted.end() );
+    for ( size_t i = 0; i < sorted.size(); i++ )
+    {
+        const TestClient &  client  = testClients[sorted[i].second];
+        snprintf( line, sizeof(line), "    %-30s %6zu %11zu %9zu %8zu\n", client.clientName.c_str(),
+                  client.pvs.size(), client.numTsValues, client.numMissed, client.numTimeouts );
+        out << line;
+        numTsValues += client.numTsValues;
+        numMissed   += client.numMissed;
+        numTimeouts += client.numTimeouts;
+        numOutliers += client.numOutliers;
+    }
+    snprintf( line, sizeof(line), "    %-30s %6zu %11zu %9zu %8zu\n", "Total", testPVs.size(), numTsValues, numMissed, numTimeouts );
+    out << line;
+    if ( numOutliers )
+        out << "Outliers: " << numOutliers << " timestamps more than " << outlierWindow
+            << " sec from their PV or client median left out of the rates" << std::endl;
+}
+
+/// showGapScans shows the -J gap scan of each PV w/ exceptions, and the totals
+void showGapScans( std::ostream & out )
+{
+    std::vector<const pvGapScan *>  gapScans;
+    for ( size_t i = 0; i < testPVs.size(); i++ )
+        if ( testPVs[i].gapScan )
+            gapScans.push_back( testPVs[i].gapScan.get() );
+    out << "\n";
+    pvGapScan::showTotals( out, gapScans, gapScanPeriod, debugFlag );
+}
+
+void usage (void)
+{
+    fprintf( stdout, "\nUsage: " EXECNAME " [options] <testTop>\n"
+    "\n"
+    "Parallel stress test result analyzer, the C++ counterpart of stressTest.readFiles.\n"
+    "Scans <testTop>/<host>/clients/<client>/ for .pvCapture, .caCapture and .pvget files,\n"
+    "reading the pvCaptureConvert binary copy of a capture file when there is one,\n"
+    "memory maps and parses them on a thread pool, and computes the per PV, per client\n"
+    "and per test NumTsValues, NumMissed, NumTimeouts and per second rates.\n"
+    "Writes a JSON summary for stressTestView.py --summary and prints the client report.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -o <file>:         Write the JSON summary to <file>, default is stdout\n"
+    "  -j <n>:            Analysis threads, default is one per CPU\n"
+    "  -c:                Compact: leave the per PV per second rates, steps and exceptions out of the summary\n"
+    "  -J <sec>:          Gap scan each PV in arrival order for counter steps other than +1, backwards\n"
+    "                     timestamps and inter-arrival times over 2x or under 0.5x the nominal\n"
+    "                     update period <sec>, ex. $TEST_COUNTER_DELAY\n"
+    "  -w <sec>:          Outlier window: timestamps more than <sec> from a PV's median second,\n"
+    "                     ex. 0 stamps from unprocessed records, are counted as outliers and\n"
+    "                     left out of its rates, as are PVs that far from their client's median.\n"
+    "                     default is 604800, one week\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -o $TEST_TOP/summary.json $TEST_TOP\n\n" );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+    std::string     jsonFilename;
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVo:j:cJ:w:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_ANALYZE_MAJOR_VERSION,
+                                PV_ANALYZE_MINOR_VERSION,
+                                PV_ANALYZE_MAINTENANCE_VERSION,
+                                PV_ANALYZE_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 'o':
+            jsonFilename = optarg;
+            break;
+        case 'j':
+        {
+            unsigned int    count;
+            if ( sscanf( optarg, "%u", &count ) != 1 || count == 0 )
+                fprintf(stderr, "'%s' is not a valid thread count "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                nThreads = count;
+        }
+            break;
+        case 'c':
+            fPVRates = false;
+            break;
+        case 'J':
+        {
+            double  period;
+            if ( sscanf( optarg, "%lf", &period ) != 1 || period <= 0.0 )
+                fprintf(stderr, "'%s' is not a valid update period "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                gapScanPeriod = period;
+        }
+            break;
+        case 'w':
+        {
+            unsigned int    window;
+            if ( sscanf( optarg, "%u", &window ) != 1 || window == 0 )
+                fprintf(stderr, "'%s' is not a valid outlier window "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                outlierWindow = window;
+        }
+            break;
+        case 'd':               /* Debug output */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+    if ( optind != argc - 1 )
+    {
+        fprintf(stderr, "One test directory expected. ('" EXECNAME " -h' for help.)\n");
+        return 1;
+    }
+    std::string     testPath( argv[optind] );
+    while ( testPath.size() > 1 && testPath[testPath.size() - 1] == '/' )
+        testPath.erase( testPath.size() - 1 );
+    std::string     testName( testPath.substr( testPath.rfind( '/' ) == std::string::npos ? 0 : testPath.rfind( '/' ) + 1 ) );
+    if ( nThreads == 0 )
+        nThreads = epicsThreadGetCPUs();
+
+    // ========================== Scan, then analyze on the pool
+
+    const epicsUInt64   tStart  = epicsMonotonicGet();
+    {
+        std::map<std::string, size_t>   clientIndex;
+        std::map<std::string, size_t>   pvIndex;
+        scanDir( testPath, clientIndex, pvIndex );
+    }
+    const epicsUInt64   tScan   = epicsMonotonicGet();
+    std::cerr << EXECNAME ": " << testName << ": " << testFiles.size() << " files, " << testPVs.size()
+              << " PVs, " << testClients.size() << " clients, analyzing on " << nThreads << " threads" << std::endl;
+
+    std::vector<AnalyzeWorker>  workers( nThreads );
+    std::vector<std::tr1::shared_ptr<pvd::Thread> >   threads;
+    for ( size_t i = 0; i < nThreads; i++ )
+        threads.push_back( std::tr1::shared_ptr<pvd::Thread>( new pvd::Thread( pvd::Thread::Config()
+                                                                .name( "pvAnalyze" )
+                                                                .autostart( true )
+                                                                .run( &workers[i] ) ) ) );
+    for ( size_t i = 0; i < threads.size(); i++ )
+        threads[i]->exitWait();
+    threads.clear();
+
+    for ( size_t i = 0; i < testClients.size(); i++ )
+        analyzeClient( testClients[i] );
+    const epicsUInt64   tEnd    = epicsMonotonicGet();
+
+    size_t  numBytes    = 0, numFailed = 0;
+    for ( size_t i = 0; i < testFiles.size(); i++ )
+    {
+        numBytes    += testFiles[i].numBytes;
+        numFailed   += testFiles[i].fOk ? 0 : 1;
+    }
+    double  analyzeSec  = ( tEnd - tScan ) * 1.0e-9;
+    std::cerr << EXECNAME ": Scan " << ( tScan - tStart ) * 1.0e-9 << " sec, analysis " << analyzeSec << " sec, "
+              << numBytes / 1.0e6 << " MB, " << ( analyzeSec > 0.0 ? numBytes / 1.0e6 / analyzeSec : 0.0 ) << " MB/s";
+    if ( numFailed )
+        std::cerr << ", " << numFailed << " files unreadable";
+    std::cerr << std::endl;
+    showReport( std::cerr, testName );
+    if ( gapScanPeriod > 0.0 )
+        showGapScans( std::cerr );
+
+    if ( jsonFilename.empty() )
+        writeJson( std::cout, testName, testPath );
+    else
+    {
+        std::ofstream   fout( jsonFilename.c_str() );
+        if ( !fout )
+        {
+            std::cerr << "Error: Unable to write " << jsonFilename << "\n";
+            return 1;
+        }
+        writeJson( fout, testName, testPath );
+    }
+
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
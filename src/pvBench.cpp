@@ -0,0 +1,991 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/logger.h>
+#include <pv/configuration.h>
+#include <pva/client.h>
+
+#include "pvHistogram.h"
+#include "pvImpairProxy.h"
+#include "pvLoadServer.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvBench"
+#endif
+
+#define PV_BENCH_MAJOR_VERSION			0
+#define PV_BENCH_MINOR_VERSION			1
+#define PV_BENCH_MAINTENANCE_VERSION	0
+#define PV_BENCH_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool        debugFlag       = false;
+bool        getMode         = false;    // -m get: closed loop gets instead of monitors
+double      runDuration     = 5.0;      // Measured seconds per run
+double      warmupDuration  = 1.0;      // Unmeasured seconds per run after connect
+double      connectTimeout  = 10.0;     // Max seconds to wait for all PVs to connect
+double      tickRateOpt     = 0.0;      // Server ticks per sec, 0 ticks at the update rate
+unsigned    benchPort       = 5095;     // Loopback TCP port, UDP search port is benchPort+1
+size_t      queueSize       = 0;        // Monitor record[queueSize], 0 for the default
+bool        impairFlag      = false;    // Clients connect through a pvImpairProxy on benchPort+2
+pvImpairProxy::Config   impairConfig;   // Delay, jitter, bandwidth, resets and drops to inject
+bool        abortFlag       = false;
+epicsEvent  abortEvt;
+
+void alldone(int num)
+{
+    (void)num;
+    abortFlag = true;
+    abortEvt.signal();
+}
+
+/// threadCpuNs returns the CPU time used by the calling thread in ns, 0 if not supported
+epicsUInt64 threadCpuNs( )
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+        return static_cast<epicsUInt64>( ts.tv_sec ) * 1000000000u + ts.tv_nsec;
+#endif
+    return 0;
+}
+
+/// processCpuNs returns the CPU time used by all threads of this process in ns, 0 if not supported
+epicsUInt64 processCpuNs( )
+{
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+    struct timespec ts;
+    if ( clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts ) == 0 )
+        return static_cast<epicsUInt64>( ts.tv_sec ) * 1000000000u + ts.tv_nsec;
+#endif
+    return 0;
+}
+
+/// Counters shared by all clients of one run, read as a snapshot at the
+/// start and end of the measured window
+struct BenchCounts
+{
+    epicsUInt64     nUpdates;   // Monitor updates or successful gets
+    epicsUInt64     nDrops;     // Counter gaps for monitors, failed gets
+    epicsUInt64     nOverruns;  // Monitor updates w/ a non-empty overrun BitSet
+    epicsUInt64     nOverrunGaps;   // Part of nDrops in gaps ending at an overrun update
+    epicsUInt64     cpuNs;      // CPU spent in client callbacks
+
+    BenchCounts() : nUpdates(0), nDrops(0), nOverruns(0), nOverrunGaps(0), cpuNs(0) {}
+    void add( const BenchCounts & other )
+    {
+        nUpdates    += other.nUpdates;
+        nDrops      += other.nDrops;
+        nOverruns   += other.nOverruns;
+        nOverrunGaps    += other.nOverrunGaps;
+        cpuNs       += other.cpuNs;
+    }
+};
+
+/// decodeUpdate gets the counter value, the last element for circular buffers,
+/// and the latency from the server timestamp to now.  Returns false if pvStruct
+/// lacks either.
+bool decodeUpdate( const pvd::PVStructure & pvStruct, double & value, double & latency )
+{
+    pvd::PVScalar::const_shared_pointer         pvScalar    = pvStruct.getSubField<pvd::PVScalar>( "value" );
+    pvd::PVScalarArray::const_shared_pointer    pvArray     = pvStruct.getSubField<pvd::PVScalarArray>( "value" );
+    pvd::PVScalar::const_shared_pointer         pvSec       = pvStruct.getSubField<pvd::PVScalar>( "timeStamp.secondsPastEpoch" );
+    pvd::PVScalar::const_shared_pointer         pvNsec      = pvStruct.getSubField<pvd::PVScalar>( "timeStamp.nanoseconds" );
+    if ( !pvSec || !pvNsec )
+        return false;
+    if ( pvScalar )
+        value = pvScalar->getAs<double>();
+    else if ( pvArray )
+    {
+        pvd::shared_vector<const double>    values;
+        pvArray->getAs<double>( values );
+        if ( values.empty() )
+            return false;
+        value = values[values.size() - 1];
+    }
+    else
+        return false;
+
+    // pvData timeStamps count from the POSIX epoch
+    epicsTimeStamp  tsServer;
+    tsServer.secPastEpoch   = static_cast<epicsUInt32>( pvSec->getAs<epicsUInt64>() - POSIX_TIME_AT_EPICS_EPOCH );
+    tsServer.nsec           = pvNsec->getAs<epicsUInt32>();
+    epicsTimeStamp  tsNow;
+    epicsTimeGetCurrent( &tsNow );
+    latency = epicsTimeDiffInSeconds( &tsNow, &tsServer );
+    return true;
+}
+
+// This could go to it's own cpp file and header
+/// BenchMonitor
+/// pvCapture style client for one PV: counts updates, detects drops from
+/// gaps in the counter, and adds server to client latency to c_latency.
+/// Gaps ending at an update the server marked as overrun are counted apart,
+/// those updates were squashed by the server's queue, not lost on the way.
+/// This is a stand-in for throughput runs, pvImpair -C checks pvCapture's
+/// own missed counts against the proxy.
+struct BenchMonitor : public pvac::ClientChannel::MonitorCallback
+{
+    static pvHistogram  c_latency;
+    static epicsEvent   c_connectEvt;   // Signaled on each first connect
+
+    BenchMonitor( pvac::ClientChannel & channel, const pvd::PVStructurePtr & pvRequest )
+        :m_connected( false )
+        ,m_lastValue( NAN )
+    {
+        // Hold m_lock so an early monitorEvent() waits for mon
+        epicsGuard<epicsMutex> G(m_lock);
+        mon = channel.monitor( this, pvRequest );
+    }
+    virtual ~BenchMonitor()
+    {
+        mon.cancel();
+    }
+
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+    try {
+        epicsGuard<epicsMutex> G(m_lock);
+        switch(evt.event)
+        {
+        case pvac::MonitorEvent::Data:
+        {
+            // The first Data event follows the connect
+            if ( !m_connected )
+            {
+                m_connected = true;
+                c_connectEvt.signal();
+            }
+            epicsUInt64 cpuStart = threadCpuNs();
+            while ( mon.poll() )
+            {
+                double  value, latency;
+                if ( !decodeUpdate( *mon.root, value, latency ) )
+                    continue;
+                m_counts.nUpdates++;
+                bool    fOverrun = !mon.overrun.isEmpty();
+                if ( fOverrun )
+                    m_counts.nOverruns++;
+                // Counters wrap for small integer types, only count forward gaps
+                if ( !isnan( m_lastValue ) && value > m_lastValue + 1.0 )
+                {
+                    epicsUInt64 nGap = static_cast<epicsUInt64>( value - m_lastValue - 1.0 );
+                    m_counts.nDrops += nGap;
+                    if ( fOverrun )
+                        m_counts.nOverrunGaps += nGap;
+                }
+                m_lastValue = value;
+                c_latency.add( latency );
+            }
+            m_counts.cpuNs += threadCpuNs() - cpuStart;
+        }
+            break;
+        case pvac::MonitorEvent::Disconnect:
+            m_connected = false;
+            m_lastValue = NAN;
+            break;
+        case pvac::MonitorEvent::Fail:
+            std::cerr << "Error: " << mon.name() << " monitor failed, " << evt.message << "\n";
+            break;
+        default:
+            break;
+        }
+    }
+    catch(std::exception& e){
+        std::cerr << "Error in BenchMonitor : " << e.what() << "\n";
+    }
+    }
+
+    bool isConnected( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_connected;
+    }
+
+    BenchCounts getCounts( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_counts;
+    }
+
+    epicsMutex      m_lock;
+    bool            m_connected;
+    double          m_lastValue;
+    BenchCounts     m_counts;
+    pvac::Monitor mon; // must be last data member
+};
+
+pvHistogram BenchMonitor::c_latency( "latency" );
+epicsEvent  BenchMonitor::c_connectEvt;
+
+// This could go to it's own cpp file and header
+/// BenchGetter
+/// pvGet style closed loop client for one PV: one get in flight at a time.
+/// getDone only records the result and queues the getter on c_ready, the
+/// main thread issues the next get, as in pvGet's ChurnSlot.
+struct BenchGetter : public pvac::ClientChannel::GetCallback
+{
+    static epicsMutex                   c_lock;     // guards c_ready and all getter state
+    static epicsEvent                   c_wakeup;   // signaled when a getter is queued on c_ready
+    static std::vector<BenchGetter*>    c_ready;
+    static pvHistogram                  c_latency;
+
+    BenchGetter( const pvac::ClientChannel & channel, const pvd::PVStructurePtr & pvRequest )
+        :m_channel( channel )
+        ,m_pvRequest( pvRequest )
+        ,m_tIssue( 0 )
+        ,m_busy( false )
+    {
+    }
+    virtual ~BenchGetter()
+    {
+        op.cancel();
+    }
+
+    /// issue the next get, main thread only
+    void issue( )
+    {
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( m_busy )
+                return;
+            m_busy      = true;
+            m_tIssue    = epicsMonotonicGet();
+        }
+        try {
+            op = m_channel.get( this, m_pvRequest );
+        }
+        catch(std::exception& e){
+            std::cerr << "Error issuing get on " << m_channel.name() << ": " << e.what() << "\n";
+            epicsGuard<epicsMutex> G(c_lock);
+            m_busy = false;
+            m_counts.nDrops++;
+            c_ready.push_back( this );
+        }
+    }
+
+    virtual void getDone(const pvac::GetEvent& event) OVERRIDE FINAL
+    {
+        epicsUInt64 cpuStart    = threadCpuNs();
+        double      latency     = ( epicsMonotonicGet() - m_tIssue ) * 1.0e-9;
+        bool        fSuccess    = event.event == pvac::GetEvent::Success;
+        if ( fSuccess )
+        {
+            double  value, age;
+            fSuccess = event.value && decodeUpdate( *event.value, value, age );
+        }
+        if ( fSuccess )
+            c_latency.add( latency );
+        else if ( event.event == pvac::GetEvent::Fail )
+            LOG( pva::logLevelError, "%s: get failed, %s", m_channel.name().c_str(), event.message.c_str() );
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( !m_busy )
+                return;
+            m_busy = false;
+            if ( fSuccess )
+                m_counts.nUpdates++;
+            else if ( event.event != pvac::GetEvent::Cancel )
+                m_counts.nDrops++;
+            m_counts.cpuNs += threadCpuNs() - cpuStart;
+            if ( event.event != pvac::GetEvent::Cancel )
+                c_ready.push_back( this );
+        }
+        c_wakeup.signal();
+    }
+
+    BenchCounts getCounts( )
+    {
+        epicsGuard<epicsMutex> G(c_lock);
+        return m_counts;
+    }
+
+    pvac::ClientChannel     m_channel;
+    pvd::PVStructurePtr     m_pvRequest;
+    epicsUInt64             m_tIssue;   // epicsMonotonicGet() when issued
+    bool                    m_busy;     // guarded by c_lock
+    BenchCounts             m_counts;   // guarded by c_lock
+    pvac::Operation         op;
+};
+
+epicsMutex                  BenchGetter::c_lock;
+epicsEvent                  BenchGetter::c_wakeup;
+std::vector<BenchGetter*>   BenchGetter::c_ready;
+pvHistogram                 BenchGetter::c_latency( "latency" );
+
+/// One point of the sweep and its results
+struct BenchRun
+{
+    size_t          nPVs;
+    double          rate;
+    pvd::ScalarType type;
+    size_t          arraySize;
+
+    size_t          nConnected;
+    double          duration;       // Measured seconds
+    double          serverPostRate; // Server posts per sec
+    double          updateRate;     // Updates or gets received per sec
+    epicsUInt64     nUpdates;
+    epicsUInt64     nDrops;
+    epicsUInt64     nOverruns;      // Updates the server marked as overrun
+    epicsUInt64     nOverrunGaps;   // Drops in gaps ending at an overrun update
+    double          dropRate;       // Drops per update offered
+    double          latencyP50;     // seconds
+    double          latencyP99;
+    double          latencyMax;
+    double          cpuPerUpdate;   // Process CPU seconds per update, includes the in-process server
+    double          clientCpuPerUpdate; // CPU seconds per update in client callbacks
+    // Ground truth from the impairment proxy, w/ -L, -D, -B or -R
+    epicsUInt64     nInjected;      // Dropped updates a client could see as a gap
+    epicsUInt64     nResets;
+    epicsUInt64     nResetLost;     // Updates queued in the proxy when it reset a connection
+
+    BenchRun()
+        :nPVs( 0 ), rate( 0.0 ), type( pvd::pvDouble ), arraySize( 1 )
+        ,nConnected( 0 ), duration( 0.0 ), serverPostRate( 0.0 ), updateRate( 0.0 )
+        ,nUpdates( 0 ), nDrops( 0 ), nOverruns( 0 ), nOverrunGaps( 0 ), dropRate( 0.0 )
+        ,latencyP50( 0.0 ), latencyP99( 0.0 ), latencyMax( 0.0 )
+        ,cpuPerUpdate( 0.0 ), clientCpuPerUpdate( 0.0 )
+        ,nInjected( 0 ), nResets( 0 ), nResetLost( 0 )
+    {
+    }
+};
+
+/// pumpGets re-issues completed gets until tEnd, returns early on abort
+void pumpGets( epicsUInt64 tEnd )
+{
+    while ( !abortFlag )
+    {
+        epicsUInt64 tNow = epicsMonotonicGet();
+        if ( tNow >= tEnd )
+            break;
+        std::vector<BenchGetter*>   ready;
+        {
+            epicsGuard<epicsMutex> G(BenchGetter::c_lock);
+            ready.swap( BenchGetter::c_ready );
+        }
+        for ( size_t i = 0; i < ready.size(); i++ )
+            ready[i]->issue();
+        if ( ready.empty() )
+            BenchGetter::c_wakeup.wait( std::min( 0.1, ( tEnd - tNow ) * 1.0e-9 ) );
+    }
+}
+
+/// runBench runs one point of the sweep: starts a pvLoadServer on loopback,
+/// connects one client per PV, warms up, then measures for runDuration
+void runBench( BenchRun & run )
+{
+    pvLoadServer::Config    config;
+    config.prefix       = "PVA:BENCH:";
+    config.nCounters    = run.arraySize > 1 ? 0 : run.nPVs;
+    config.nCircBuffs   = run.arraySize > 1 ? run.nPVs : 0;
+    config.circBuffSize = run.arraySize;
+    config.rate         = run.rate;
+    config.tickRate     = tickRateOpt > 0.0 ? tickRateOpt : run.rate;
+    config.type         = run.type;
+    config.serverPort   = benchPort;
+    config.broadcastPort = benchPort + 1;
+    config.intfAddrList = "127.0.0.1";
+    pvLoadServer    server( config );
+    server.start();
+
+    // Clients skip the search and connect straight to the proxy
+    std::tr1::shared_ptr<pvImpairProxy>  proxy;
+    pvac::ClientChannel::Options        channelOptions;
+    if ( impairFlag )
+    {
+        std::ostringstream  upstream, proxyAddr;
+        upstream << "127.0.0.1:" << server.getServerPort();
+        proxyAddr << "127.0.0.1:" << benchPort + 2;
+        impairConfig.listenPort = benchPort + 2;
+        impairConfig.upstream   = upstream.str();
+        proxy.reset( new pvImpairProxy( impairConfig ) );
+        proxy->start();
+        channelOptions.address  = proxyAddr.str();
+    }
+
+    // Search only the loopback server, never the site's PVs
+    std::ostringstream  udpPort;
+    udpPort << benchPort + 1;
+    pvac::ClientProvider    provider( "pva", pva::ConfigurationBuilder()
+                                                .push_env()
+                                                .add( "EPICS_PVA_ADDR_LIST", "127.0.0.1" )
+                                                .add( "EPICS_PVA_AUTO_ADDR_LIST", "NO" )
+                                                .add( "EPICS_PVA_BROADCAST_PORT", udpPort.str() )
+                                                .push_map()
+                                                .build() );
+
+    std::ostringstream  request;
+    if ( getMode )
+        request << "field(value,timeStamp)";
+    else if ( queueSize )
+        request << "record[queueSize=" << queueSize << "]field(value,timeStamp)";
+    else
+        request << "field(value,timeStamp)";
+    pvd::PVStructurePtr pvRequest( pvd::createRequest( request.str() ) );
+
+    const std::vector<std::string> &            pvNames = server.getPVNames();
+    std::vector<std::tr1::shared_ptr<BenchMonitor> >    monitors;
+    std::vector<std::tr1::shared_ptr<BenchGetter> >     getters;
+    BenchMonitor::c_latency.clear();
+    BenchGetter::c_latency.clear();
+    {
+        epicsGuard<epicsMutex> G(BenchGetter::c_lock);
+        BenchGetter::c_ready.clear();
+    }
+    for ( size_t i = 0; i < pvNames.size(); i++ )
+    {
+        pvac::ClientChannel channel( provider.connect( pvNames[i], channelOptions ) );
+        if ( getMode )
+        {
+            std::tr1::shared_ptr<BenchGetter>   getter( new BenchGetter( channel, pvRequest ) );
+            getters.push_back( getter );
+            getter->issue();
+        }
+        else
+            monitors.push_back( std::tr1::shared_ptr<BenchMonitor>( new BenchMonitor( channel, pvRequest ) ) );
+    }
+
+    // Wait for all PVs to connect, the first get of each doubles as its connect
+    epicsUInt64 tConnectEnd = epicsMonotonicGet() + static_cast<epicsUInt64>( connectTimeout * 1.0e9 );
+    while ( !abortFlag && epicsMonotonicGet() < tConnectEnd )
+    {
+        size_t  nConnected = 0;
+        if ( getMode )
+        {
+            for ( size_t i = 0; i < getters.size(); i++ )
+                if ( getters[i]->getCounts().nUpdates )
+                    nConnected++;
+            pumpGets( epicsMonotonicGet() + 100000000u );
+        }
+        else
+        {
+            for ( size_t i = 0; i < monitors.size(); i++ )
+                if ( monitors[i]->isConnected() )
+                    nConnected++;
+            BenchMonitor::c_connectEvt.wait( 0.1 );
+        }
+        run.nConnected = nConnected;
+        if ( nConnected == pvNames.size() )
+            break;
+    }
+    if ( run.nConnected < pvNames.size() )
+        std::cerr << EXECNAME ": Only " << run.nConnected << " of " << pvNames.size() << " PVs connected\n";
+
+    // Warm up, then snapshot and measure
+    epicsUInt64 tWarmupEnd = epicsMonotonicGet() + static_cast<epicsUInt64>( warmupDuration * 1.0e9 );
+    if ( getMode )
+        pumpGets( tWarmupEnd );
+    else
+        abortEvt.wait( warmupDuration );
+
+    pvHistogram &   latency = getMode ? BenchGetter::c_latency : BenchMonitor::c_latency;
+    BenchCounts     countsStart;
+    for ( size_t i = 0; i < monitors.size(); i++ )
+        countsStart.add( monitors[i]->getCounts() );
+    for ( size_t i = 0; i < getters.size(); i++ )
+        countsStart.add( getters[i]->getCounts() );
+    latency.clear();
+    epicsUInt64 postsStart  = server.getNumPosts();
+    pvImpairProxy::Stats    proxyStart;
+    if ( proxy )
+        proxyStart = proxy->getStats();
+    epicsUInt64 cpuStart    = processCpuNs();
+    epicsUInt64 tStart      = epicsMonotonicGet();
+
+    if ( getMode )
+        pumpGets( tStart + static_cast<epicsUInt64>( runDuration * 1.0e9 ) );
+    else
+        abortEvt.wait( runDuration );
+
+    epicsUInt64 tEnd        = epicsMonotonicGet();
+    epicsUInt64 cpuEnd      = processCpuNs();
+    epicsUInt64 postsEnd    = server.getNumPosts();
+    pvImpairProxy::Stats    proxyEnd;
+    if ( proxy )
+        proxyEnd = proxy->getStats();
+    BenchCounts countsEnd;
+    for ( size_t i = 0; i < monitors.size(); i++ )
+        countsEnd.add( monitors[i]->getCounts() );
+    for ( size_t i = 0; i < getters.size(); i++ )
+        countsEnd.add( getters[i]->getCounts() );
+
+    run.duration        = ( tEnd - tStart ) * 1.0e-9;
+    run.nUpdates        = countsEnd.nUpdates - countsStart.nUpdates;
+    run.nDrops          = countsEnd.nDrops - countsStart.nDrops;
+    run.nOverruns       = countsEnd.nOverruns - countsStart.nOverruns;
+    run.nOverrunGaps    = countsEnd.nOverrunGaps - countsStart.nOverrunGaps;
+    if ( run.duration > 0.0 )
+    {
+        run.serverPostRate  = ( postsEnd - postsStart ) / run.duration;
+        run.updateRate      = run.nUpdates / run.duration;
+    }
+    if ( run.nUpdates + run.nDrops )
+        run.dropRate    = static_cast<double>( run.nDrops ) / ( run.nUpdates + run.nDrops );
+    run.latencyP50      = latency.percentile( 50.0 );
+    run.latencyP99      = latency.percentile( 99.0 );
+    run.latencyMax      = latency.max();
+    if ( run.nUpdates )
+    {
+        run.cpuPerUpdate        = ( cpuEnd - cpuStart ) * 1.0e-9 / run.nUpdates;
+        run.clientCpuPerUpdate  = ( countsEnd.cpuNs - countsStart.cpuNs ) * 1.0e-9 / run.nUpdates;
+    }
+    run.nInjected       = proxyEnd.nDropped - proxyStart.nDropped;
+    run.nResets         = proxyEnd.nResets - proxyStart.nResets;
+    run.nResetLost      = proxyEnd.nResetLost - proxyStart.nResetLost;
+
+    // Clients go before the server so they don't see a disconnect storm
+    monitors.clear();
+    getters.clear();
+    {
+        epicsGuard<epicsMutex> G(BenchGetter::c_lock);
+        BenchGetter::c_ready.clear();
+    }
+    if ( proxy )
+    {
+        if ( debugFlag )
+            proxy->showStats( std::cerr );
+        proxy->stop();
+    }
+    server.stop();
+}
+
+void showRunHeader( std::ostream & out )
+{
+    out << std::setw(7) << "PVs" << " " << std::setw(8) << "Rate" << " " << std::setw(7) << "Type"
+        << " " << std::setw(6) << "Size" << " " << std::setw(7) << "Conn"
+        << " " << std::setw(10) << "Posts/s" << " " << std::setw(10) << "Upd/s"
+        << " " << std::setw(8) << "Drop%" << " " << std::setw(9) << "p50(ms)"
+        << " " << std::setw(9) << "p99(ms)" << " " << std::setw(9) << "Max(ms)"
+        << " " << std::setw(9) << "CPU(us)" << " " << std::setw(9) << "Cli(us)";
+    if ( impairFlag )
+        out << " " << std::setw(9) << "Missed" << " " << std::setw(9) << "Injected"
+            << " " << std::setw(9) << "Overruns" << " " << std::setw(9) << "OvrGaps"
+            << " " << std::setw(7) << "Resets" << " " << std::setw(9) << "ResetLost";
+    out << std::endl;
+}
+
+void showRun( std::ostream & out, const BenchRun & run )
+{
+    std::ios::fmtflags  flags( out.flags() );
+    out << std::setw(7) << run.nPVs << " " << std::setw(8) << run.rate
+        << " " << std::setw(7) << pvd::ScalarTypeFunc::name( run.type )
+        << " " << std::setw(6) << run.arraySize << " " << std::setw(7) << run.nConnected
+        << std::fixed << std::setprecision(0)
+        << " " << std::setw(10) << run.serverPostRate << " " << std::setw(10) << run.updateRate
+        << std::setprecision(3)
+        << " " << std::setw(8) << run.dropRate * 100.0
+        << " " << std::setw(9) << run.latencyP50 * 1e3 << " " << std::setw(9) << run.latencyP99 * 1e3
+        << " " << std::setw(9) << run.latencyMax * 1e3
+        << " " << std::setw(9) << run.cpuPerUpdate * 1e6 << " " << std::setw(9) << run.clientCpuPerUpdate * 1e6;
+    if ( impairFlag )
+        out << " " << std::setw(9) << run.nDrops - run.nOverrunGaps << " " << std::setw(9) << run.nInjected
+            << " " << std::setw(9) << run.nOverruns << " " << std::setw(9) << run.nOverrunGaps
+            << " " << std::setw(7) << run.nResets << " " << std::setw(9) << run.nResetLost;
+    out << std::endl;
+    out.flags( flags );
+}
+
+/// writeJson writes all runs as one JSON document
+void writeJson( std::ostream & out, const std::vector<BenchRun> & runs )
+{
+    char    hostname[256] = "";
+    gethostname( hostname, sizeof(hostname) - 1 );
+    char    startTime[64];
+    epicsTimeStamp  now;
+    epicsTimeGetCurrent( &now );
+    epicsTimeToStrftime( startTime, sizeof(startTime), "%Y-%m-%dT%H:%M:%S", &now );
+
+    std::ios::fmtflags  flags( out.flags() );
+    out << "{\n"
+        << "  \"tool\": \"" EXECNAME "\",\n"
+        << "  \"version\": \"" << PV_BENCH_MAJOR_VERSION << "." << PV_BENCH_MINOR_VERSION
+                                << "." << PV_BENCH_MAINTENANCE_VERSION << "\",\n"
+        << "  \"host\": \"" << hostname << "\",\n"
+        << "  \"time\": \"" << startTime << "\",\n"
+        << "  \"mode\": \"" << ( getMode ? "get" : "monitor" ) << "\",\n"
+        << "  \"duration\": " << runDuration << ",\n"
+        << "  \"warmup\": " << warmupDuration << ",\n"
+        << "  \"queueSize\": " << queueSize << ",\n";
+    if ( impairFlag )
+        out << "  \"impair\": { \"delay\": " << impairConfig.delay
+            << ", \"jitter\": " << impairConfig.jitter
+            << ", \"bandwidth\": " << impairConfig.bandwidth
+            << ", \"resetPeriod\": " << impairConfig.resetPeriod
+            << ", \"dropFraction\": " << impairConfig.dropFraction << " },\n";
+    out << "  \"runs\": [";
+    for ( size_t i = 0; i < runs.size(); i++ )
+    {
+        const BenchRun &    run = runs[i];
+        out << ( i ? ",\n" : "\n" )
+            << "    { \"nPVs\": " << run.nPVs
+            << ", \"rate\": " << run.rate
+            << ", \"type\": \"" << pvd::ScalarTypeFunc::name( run.type ) << "\""
+            << ", \"arraySize\": " << run.arraySize
+            << ", \"connected\": " << run.nConnected
+            << ", \"offeredRate\": " << run.nPVs * run.rate
+            << std::fixed << std::setprecision(3)
+            << ", \"measured\": " << run.duration
+            << ", \"serverPostRate\": " << run.serverPostRate
+            << ", \"updateRate\": " << run.updateRate
+            << ", \"updates\": " << run.nUpdates
+            << ", \"drops\": " << run.nDrops
+            << std::setprecision(6)
+            << ", \"dropRate\": " << run.dropRate
+            << ", \"latencyP50\": " << run.latencyP50
+            << ", \"latencyP99\": " << run.latencyP99
+            << ", \"latencyMax\": " << run.latencyMax
+            << std::setprecision(9)
+            << ", \"cpuPerUpdate\": " << run.cpuPerUpdate
+            << ", \"clientCpuPerUpdate\": " << run.clientCpuPerUpdate;
+        // detectionError is drops seen by the clients minus drops injected, 0 when detection is exact.
+        // Gaps ending at a server overrun are reported apart, the proxy didn't inject them.
+        if ( impairFlag )
+            out << ", \"injectedDrops\": " << run.nInjected
+                << ", \"overruns\": " << run.nOverruns
+                << ", \"overrunGaps\": " << run.nOverrunGaps
+                << ", \"detectionError\": " << static_cast<double>( run.nDrops - run.nOverrunGaps ) - static_cast<double>( run.nInjected )
+                << ", \"resets\": " << run.nResets
+                << ", \"resetLost\": " << run.nResetLost;
+        out << " }";
+        out.flags( flags );
+    }
+    out << "\n  ]\n}\n";
+    out.flags( flags );
+}
+
+/// parseList splits a comma separated option value
+std::vector<std::string> parseList( const char * optarg )
+{
+    std::vector<std::string>    list;
+    std::istringstream          optList( optarg );
+    std::string                 item;
+    while ( getline( optList, item, ',' ) )
+        if ( !item.empty() )
+            list.push_back( item );
+    return list;
+}
+
+void usage (void)
+{
+    fprintf( stdout, "\nUsage: " EXECNAME " [options]\n"
+    "\n"
+    "Client throughput benchmark.  Runs an in-process pvLoadServer on loopback\n"
+    "and pvCapture style monitors, or pvGet style closed loop gets, for every\n"
+    "combination of the swept PV counts, rates, types and array sizes.\n"
+    "Any impair option routes the clients through a pvImpairProxy and compares\n"
+    "the drops the clients detect against the drops the proxy injected, w/ gaps\n"
+    "from server queue overruns counted apart.  The clients are light stand-ins,\n"
+    "use pvImpair -C to check pvCapture's own missed counts.\n"
+    "Progress goes to stderr, results are written as JSON.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -n <list>:         PV counts to sweep, default is 10,100,1000\n"
+    "  -r <list>:         Updates per sec per PV to sweep, default is 10,100\n"
+    "  -t <list>:         Value types to sweep, ex. double,int,ubyte.  default is double\n"
+    "  -s <list>:         Array sizes to sweep, 1 for scalar counters.  default is 1\n"
+    "  -m <mode>:         Client mode, monitor or get.  default is monitor\n"
+    "  -k <rate>:         Server ticks per sec, default is the update rate\n"
+    "  -Q <size>:         Monitor queueSize, default is the server's\n"
+    "  -T <sec>:          Measured seconds per run, default is %.1f\n"
+    "  -W <sec>:          Warmup seconds per run after connect, default is %.1f\n"
+    "  -w <sec>:          Connect timeout, default is %.1f\n"
+    "  -p <port>:         Loopback TCP port, UDP search port is port+1.  default is %u\n"
+    "  -L <pct>:          Impair: Drop <pct> percent of monitor updates in a proxy on port+2\n"
+    "  -D <ms>[:<ms>]:    Impair: Delay each message, plus up to the 2nd value of random jitter\n"
+    "  -B <bytes/sec>:    Impair: Bandwidth cap per connection and direction\n"
+    "  -R <sec>:          Impair: Mean seconds between random connection resets\n"
+    "  -o <file>:         Write JSON results to <file>, default is stdout\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -n 100,1000 -r 100 -t double,int -s 1,1000 -o bench.json\n"
+    "         " EXECNAME " -n 100 -r 100 -L 1 -D 5:5 -R 10\n\n"
+             , runDuration, warmupDuration, connectTimeout, benchPort );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+    std::vector<size_t>             pvCounts;
+    std::vector<double>             rates;
+    std::vector<pvd::ScalarType>    types;
+    std::vector<size_t>             arraySizes;
+    std::string                     jsonFilename;
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVn:r:t:s:m:k:Q:T:W:w:p:L:D:B:R:o:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_BENCH_MAJOR_VERSION,
+                                PV_BENCH_MINOR_VERSION,
+                                PV_BENCH_MAINTENANCE_VERSION,
+                                PV_BENCH_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 'n':
+        case 's':
+        {
+            std::vector<std::string>    list = parseList( optarg );
+            std::vector<size_t> &       counts = ( opt == 'n' ) ? pvCounts : arraySizes;
+            for ( size_t i = 0; i < list.size(); i++ )
+            {
+                unsigned int    count;
+                if ( sscanf( list[i].c_str(), "%u", &count ) != 1 || count == 0 )
+                    fprintf(stderr, "'%s' is not a valid count for -%c "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", list[i].c_str(), opt);
+                else
+                    counts.push_back( count );
+            }
+        }
+            break;
+        case 'r':
+        {
+            std::vector<std::string>    list = parseList( optarg );
+            for ( size_t i = 0; i < list.size(); i++ )
+            {
+                double  rate;
+                if ( epicsScanDouble( list[i].c_str(), &rate ) != 1 || rate <= 0.0 )
+                    fprintf(stderr, "'%s' is not a valid rate "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", list[i].c_str());
+                else
+                    rates.push_back( rate );
+            }
+        }
+            break;
+        case 't':
+        {
+            std::vector<std::string>    list = parseList( optarg );
+            for ( size_t i = 0; i < list.size(); i++ )
+            {
+                try
+                {
+                    pvd::ScalarType type = pvd::ScalarTypeFunc::getScalarType( list[i] );
+                    if ( type == pvd::pvBoolean || type == pvd::pvString )
+                        fprintf(stderr, "'%s' is not a numeric type "
+                                "- ignored. ('" EXECNAME " -h' for help.)\n", list[i].c_str());
+                    else
+                        types.push_back( type );
+                }
+                catch ( std::exception & )
+                {
+                    fprintf(stderr, "'%s' is not a valid ScalarType "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", list[i].c_str());
+                }
+            }
+        }
+            break;
+        case 'm':
+            if ( strcmp( optarg, "get" ) == 0 )
+                getMode = true;
+            else if ( strcmp( optarg, "monitor" ) == 0 )
+                getMode = false;
+            else
+                fprintf(stderr, "'%s' is not a valid mode "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            break;
+        case 'k':
+        case 'T':
+        case 'W':
+        case 'w':
+        {
+            double  value;
+            if ( epicsScanDouble( optarg, &value ) != 1 || value < 0.0 || ( opt != 'W' && value == 0.0 ) )
+            {
+                fprintf(stderr, "'%s' is not a valid value for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 'k' )
+                tickRateOpt = value;
+            else if ( opt == 'T' )
+                runDuration = value;
+            else if ( opt == 'W' )
+                warmupDuration = value;
+            else
+                connectTimeout = value;
+        }
+            break;
+        case 'Q':
+        {
+            unsigned int    size;
+            if ( sscanf( optarg, "%u", &size ) != 1 )
+                fprintf(stderr, "'%s' is not a valid queueSize "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                queueSize = size;
+        }
+            break;
+        case 'p':
+        {
+            unsigned int    port;
+            if ( sscanf( optarg, "%u", &port ) != 1 || port == 0 || port >= 65534 )
+                fprintf(stderr, "'%s' is not a valid port "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                benchPort = port;
+        }
+            break;
+        case 'L':
+        case 'B':
+        case 'R':
+        {
+            double  value;
+            if ( epicsScanDouble( optarg, &value ) != 1 || value < 0.0 || ( opt == 'L' && value > 100.0 ) )
+            {
+                fprintf(stderr, "'%s' is not a valid value for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+                break;
+            }
+            if ( opt == 'L' )
+                impairConfig.dropFraction   = value / 100.0;
+            else if ( opt == 'B' )
+                impairConfig.bandwidth      = value;
+            else
+                impairConfig.resetPeriod    = value;
+            impairFlag = true;
+        }
+            break;
+        case 'D':
+        {
+            double  delayMs, jitterMs = 0.0;
+            int     nScanned = sscanf( optarg, "%lf:%lf", &delayMs, &jitterMs );
+            if ( nScanned < 1 || delayMs < 0.0 || jitterMs < 0.0 )
+            {
+                fprintf(stderr, "'%s' is not a valid delay "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                break;
+            }
+            impairConfig.delay  = delayMs * 1.0e-3;
+            impairConfig.jitter = jitterMs * 1.0e-3;
+            impairFlag = true;
+        }
+            break;
+        case 'o':
+            jsonFilename = optarg;
+            break;
+        case 'd':               /* Debug log level */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+    if ( pvCounts.empty() )
+    {
+        pvCounts.push_back( 10 );
+        pvCounts.push_back( 100 );
+        pvCounts.push_back( 1000 );
+    }
+    if ( rates.empty() )
+    {
+        rates.push_back( 10.0 );
+        rates.push_back( 100.0 );
+    }
+    if ( types.empty() )
+        types.push_back( pvd::pvDouble );
+    if ( arraySizes.empty() )
+        arraySizes.push_back( 1 );
+
+    SET_LOG_LEVEL(debugFlag ? pva::logLevelDebug : pva::logLevelError);
+
+    signal(SIGINT,  alldone);
+    signal(SIGTERM, alldone);
+    signal(SIGQUIT, alldone);
+
+    // ========================== Sweep
+
+    std::vector<BenchRun>   runs;
+    std::cerr << EXECNAME ": " << pvCounts.size() * rates.size() * types.size() * arraySizes.size()
+              << " runs of " << runDuration << " sec, " << ( getMode ? "get" : "monitor" ) << " mode" << std::endl;
+    showRunHeader( std::cerr );
+    for ( size_t iType = 0; iType < types.size() && !abortFlag; iType++ )
+    for ( size_t iSize = 0; iSize < arraySizes.size() && !abortFlag; iSize++ )
+    for ( size_t iCount = 0; iCount < pvCounts.size() && !abortFlag; iCount++ )
+    for ( size_t iRate = 0; iRate < rates.size() && !abortFlag; iRate++ )
+    {
+        BenchRun    run;
+        run.nPVs        = pvCounts[iCount];
+        run.rate        = rates[iRate];
+        run.type        = types[iType];
+        run.arraySize   = arraySizes[iSize];
+        runBench( run );
+        if ( abortFlag )
+            break;
+        showRun( std::cerr, run );
+        runs.push_back( run );
+    }
+
+    if ( jsonFilename.empty() )
+        writeJson( std::cout, runs );
+    else
+    {
+        std::ofstream   fout( jsonFilename.c_str() );
+        if ( !fout )
+        {
+            std::cerr << "Error: Unable to write " << jsonFilename << "\n";
+            return 1;
+        }
+        writeJson( fout, runs );
+    }
+
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -5,6 +5,7 @@
 #include <iomanip>
 #include <iostream>
 #include <vector>
+#include <map>
 #include <set>
 #include <deque>
 #include <queue>
@@ -12,11 +13,15 @@
 #include <istream>
 #include <fstream>
 #include <sstream>
+#include <list>
+#include <stdexcept>
 
+#include <ctype.h>
 #include <errno.h>
 #include <math.h>
 #include <signal.h>
 #include <stdio.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include <epicsStdlib.h>
@@ -38,6 +43,15 @@
 #include <pv/caProvider.h>
 #include <pv/logger.h>
 #include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/configuration.h>
+#include <pv/ntscalar.h>
+#include <pv/ntscalarArray.h>
+
+#include "pvHistogram.h"
+#include "pvGapScan.h"
 
 #define USE_SIGNAL
 #ifndef EXECNAME
@@ -63,6 +77,61 @@ pvd::PVStructure::Formatter::format_t outmode = pvd::PVStructure::Formatter::NT;
 int verbosity   = 0;
 std::string request("");
 std::string defaultProvider("pva");
+std::vector<std::string> providerNames;     // -p list, ex. pva,ca subscribes each PV over both
+std::vector<std::string> pathLabels;        // Tag for each capture path, provider name or direct/gw
+
+// Dual path direct vs gateway capture, see -g and -G
+std::string gatewayAddrList;                // EPICS_PVA_ADDR_LIST for the gateway path
+unsigned    gatewayStandInPort = 0;         // TCP port of the in-process gateway stand-in, UDP is port+1
+std::string serverAddress;                  // -a host:port, direct path connects here w/o searching
+
+// Managed per-PV monitor queueSize, enabled by -Q <min>:<max>
+size_t queueSizeMin     = 0;
+size_t queueSizeMax     = 0;
+double adaptPeriod      = 10.0;     // seconds between queueSize adjustments
+
+// WorkQueue overload policy, selected by -O
+enum overload_t { OverloadLossless, OverloadConflate, OverloadDropOldest };
+overload_t  overloadPolicy  = OverloadLossless;
+size_t      workQueueBound  = 10000;    // Max WorkQueue depth for drop-oldest, set by -B
+size_t      conflateMaxPoll = 1024;     // Max updates polled per conflate visit before re-queue
+
+// Paced startup, see -P and -o
+double      createRate      = 0.0;      // Channels created per sec, 0 creates them all at once
+size_t      maxSearches     = 0;        // Max PVs created but not yet connected, 0 for no limit
+double      searchTimeout   = 5.0;      // Seconds an unconnected PV counts as an outstanding search
+epicsEvent  connectEvt;                 // Signaled when a MonTracker first connects
+
+// Number of independent client provider contexts, see -K
+size_t      nContexts       = 1;
+
+// Logical clients hosted in this process, see -N, and WorkQueue threads, see -W
+size_t      nClients        = 0;        // 0 for a single client using -f and -D as given
+size_t      nWorkerThreads  = 1;
+
+// Fan-out: subscribers per PV, see -u, sharing one monitor and decode w/ -U
+size_t      nSubscribers    = 1;
+bool        sharedDecode    = false;
+
+// Network free capture pipeline benchmark, see -b, -T and -A
+size_t      synthUpdates    = 0;        // Updates per PV, 0 for a normal capture
+std::vector<pvd::ScalarType>    synthTypes; // One benchmark run per type
+size_t      synthArraySize  = 1;        // > 1 for NTScalarArray updates
+size_t      synthMaxPending = 4;        // Max updates waiting per PV, like a monitor queueSize
+
+// Gap and jitter scan of the saved values, see -J
+double      gapScanPeriod   = 0.0;      // Nominal update period, ex. $TEST_COUNTER_DELAY, 0 for no scan
+
+/// threadCpuNs returns the CPU time used by the calling thread in ns, 0 if not supported
+epicsUInt64 threadCpuNs( )
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+        return static_cast<epicsUInt64>( ts.tv_sec ) * 1000000000u + ts.tv_nsec;
+#endif
+    return 0;
+}
 
 typedef struct _tsReal
 {
@@ -158,12 +227,45 @@ void usage (void)
             "  -r <pv request>:   Request, specifies what fields to return and options, default is '%s'\n" \
             "  -w <sec>:          Wait time, specifies timeout, default is %f second(s)\n" \
             "  -p <provider>:     Set default provider name, default is '%s'\n" \
+            "                     A list, ex. -p pva,ca, subscribes to each PV over each provider\n"
+            "                     and saves each series to <dirpath>/<provider>.\n"
             "  -M <raw|nt|json>:  Output mode.  default is 'nt'\n" \
             "  -q:                Quiet mode, print only error messages\n" \
             "  -d:                Enable debug output\n"
             "  -f <input file>:   Read pvName list from file, one line per pvName.\n"
             "  -D <dirpath>:      Directory path where captured values are saved to <dirpath>/<pvname>.\n"
             "  -S:                Show each PV as it's acquired, same output options as pvmonitor.\n"
+            "  -Q <min>:<max>:    Manage record[queueSize=N,pipeline=true] per PV, starting at <min>.\n"
+            "                     Queues of PVs w/ overruns are doubled, idle PVs are halved.\n"
+            "  -O <policy>:       Overload policy: lossless, conflate, or drop-oldest.  default is 'lossless'\n"
+            "  -B <depth>:        WorkQueue bound for drop-oldest policy, default is %u\n"
+            "  -P <rate>:         Pace startup at <rate> channels/sec.  default creates all at once\n"
+            "  -o <max>:          Max PVs searching (created but not connected) during startup\n"
+            "  -K <n>:            Spread PVs by name hash over <n> provider contexts, each w/ its own sockets.\n"
+            "  -N <n>:            Host <n> logical clients, each w/ its own provider contexts, PV list and output dir.\n"
+            "                     A printf style %%d in -f and -D is replaced by the client number, ex. -D dir/pvCapture%%02d\n"
+            "  -W <n>:            Number of WorkQueue threads shared by all clients.  default is 1\n"
+            "  -u <m>:            Fan-out: <m> subscribers per PV, each w/ its own monitor and loss accounting.\n"
+            "                     Subscriber n > 0 saves to <dirpath>/subNN.\n"
+            "  -U:                Fan-out subscribers share one monitor and decoded update per PV.\n"
+            "  -g <addr list>:    Dual path: also subscribe to each PV via a gateway at <addr list>,\n"
+            "                     match samples by timestamp and report added latency and gateway-only losses.\n"
+            "                     Direct and gateway series are saved to <dirpath>/direct and <dirpath>/gw.\n"
+            "  -G <port>:         Run an in-process forwarding gateway stand-in on TCP <port>, UDP <port>+1.\n"
+            "                     Implies -g 127.0.0.1:<port>+1 if -g is not given.\n"
+            "  -a <host:port>:    Connect the direct path to the server at <host:port> w/o searching,\n"
+            "                     ex. through pvImpair, which runs pvCapture w/ -C to compare its missed\n"
+            "                     counts w/ the injected drops.\n"
+            "                     Not w/ -Q, pvImpair never acks the pipelined updates it drops.\n"
+            "  -b <n>:            Benchmark the capture pipeline alone: feed <n> synthetic updates per PV\n"
+            "                     through the WorkQueue, capture and storage w/o any network and report\n"
+            "                     ns per update for each stage.  Uses the -f or command line PVs, else 100.\n"
+            "  -T <types>:        ScalarTypes to benchmark w/ -b, ex. double,int,ubyte.  default is double\n"
+            "  -A <n>:            Array size for -b, > 1 benchmarks NTScalarArray updates.  default is 1\n"
+            "  -J <sec>:          Gap scan the saved values of each PV for counter steps other than +1,\n"
+            "                     backwards timestamps and inter-arrival times over 2x or under 0.5x the\n"
+            "                     nominal update period <sec>, ex. $TEST_COUNTER_DELAY.\n"
+            "                     Exceptions are listed in <dirpath>/<pvname>.pvCapture.gapScan.\n"
             " Output details:\n"
             "  -v:                Show entire structure (implies Raw mode)\n" \
             "  -vv:               Get in Raw mode.     Highlight  valid fields, show all fields.\n"
@@ -172,21 +274,121 @@ void usage (void)
             "\n"
             "example: " EXECNAME " double01\n\n"
 //          , request.c_str(), timeout, defaultProvider.c_str()
-            , "value", 5.0, "pva" );
+            , "value", 5.0, "pva", static_cast<unsigned int>(workQueueBound) );
+}
+
+/// clientPath expands a printf style client number in a -f or -D path template
+/// Only one %d or %u, w/ an optional width such as %02d, and %% are expanded, so the
+/// template is never used as a printf format.  Throws on any other % conversion.
+std::string clientPath( const std::string & pathTemplate, size_t iClient )
+{
+    std::string     path;
+    bool            fNumber = false;
+    for ( size_t i = 0; i < pathTemplate.size(); i++ )
+    {
+        if ( pathTemplate[i] != '%' )
+        {
+            path += pathTemplate[i];
+            continue;
+        }
+        if ( i + 1 < pathTemplate.size() && pathTemplate[i + 1] == '%' )
+        {
+            path += '%';
+            i++;
+            continue;
+        }
+        size_t  iConv   = i + 1;
+        while ( iConv < pathTemplate.size() && isdigit( static_cast<unsigned char>( pathTemplate[iConv] ) ) )
+            iConv++;
+        if (    fNumber || iConv >= pathTemplate.size() || iConv - i - 1 > 2
+            ||  ( pathTemplate[iConv] != 'd' && pathTemplate[iConv] != 'u' ) )
+            throw std::runtime_error( "Invalid client number in path template " + pathTemplate
+                                      + ", use one %d w/ an optional width, ex. %02d, and %% for a literal %" );
+        // The conversion spec is checked above, a width of at most 99 fits in number
+        char    number[128];
+        snprintf( number, sizeof(number), ( pathTemplate.substr( i, iConv - i ) + "u" ).c_str(),
+                  static_cast<unsigned int>( iClient ) );
+        path   += number;
+        fNumber = true;
+        i       = iConv;
+    }
+    return path;
+}
+
+/// Append the pvNames in pvFilename, one per line, to pvList
+void readPVList( const std::string & pvFilename, std::vector<std::string> & pvList )
+{
+    try
+    {
+        std::ifstream   fin( pvFilename.c_str() );
+        std::string     line;
+        if ( !fin.is_open() )
+            std::cout << "Unable to open " << pvFilename << std::endl;
+        else
+        {
+            while ( getline( fin, line ) )
+            {
+                pvnamewidth = std::max(pvnamewidth, line.size());
+                pvList.push_back( line );
+            }
+            fin.close();
+        }
+    }
+    catch( std::exception & e )
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+    }
+}
+
+/// FNV-1a hash of a PV name, used to pick a provider context
+/// Stable across runs and processes, so a PV always lands on the same context
+size_t pvNameHash( const std::string & pvName )
+{
+    epicsUInt32 hash = 2166136261u;
+    for ( size_t i = 0; i < pvName.size(); i++ )
+    {
+        hash ^= static_cast<unsigned char>( pvName[i] );
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// Create a pvRequest w/ the -r request plus record options for a managed monitor queue
+pvd::PVStructurePtr createQueueRequest( size_t queueSize )
+{
+    std::ostringstream  reqStr;
+    reqStr << "record[queueSize=" << queueSize << ",pipeline=true]" << request;
+    return pvd::createRequest( reqStr.str() );
 }
 
 // This could go to it's own cpp file and header
 // Borrowed from pvmonitor.cpp
 struct Worker
 {
+    Worker() : m_queued(0), m_drainPending(false) {}
     virtual ~Worker() {}
     virtual void process(const pvac::MonitorEvent& event) =0;
+    /// Discard all pending updates w/o capturing them, returns number discarded
+    virtual size_t drain() =0;
+
+    // Only access w/ WorkQueue::mutex held
+    size_t  m_queued;           // Number of entries for this worker in WorkQueue::queue
+    bool    m_drainPending;     // Worker is on WorkQueue::drainList
 };
 
 // This could go to it's own cpp file and header
 // Borrowed from pvmonitor.cpp
-// simple work queue with thread.
+// simple work queue with thread pool.
 // moves monitor queue handling off of PVA thread(s)
+// A worker may be visited by more than one thread; MonTracker::monLock serializes them.
+//
+// Overload policies:
+//  lossless:    Every event is queued and every update is captured.
+//  conflate:    At most one Data event is queued per worker.  Worker keeps only
+//               the latest update it finds on each visit.
+//  drop-oldest: Queue is bounded by workQueueBound.  When full the oldest Data event,
+//               wherever it is in the queue, is evicted and that worker's pending
+//               updates are drained w/o capture.
 struct WorkQueue : public epicsThreadRunable
 {
     typedef std::tr1::shared_ptr<Worker>    value_type;
@@ -197,16 +399,31 @@ struct WorkQueue : public epicsThreadRunable
     epicsEvent      event;
     epicsMutex      mutex;
     queue_t         queue;
+    std::deque<weak_type>   drainList;  // Workers w/ evicted events, drain before next event
+    size_t          maxDepth;   // high water mark of queue.size()
+    size_t          nConflated; // Data events not queued as worker already had one queued
+    size_t          nEvicted;   // Data events evicted by drop-oldest
+    size_t          nDrained;   // Updates discarded by Worker::drain()
     bool            running;
-    pvd::Thread     worker;
-
-    WorkQueue()
-        :running(true)
-        ,worker(pvd::Thread::Config()
-                .name("pvCapture handler")
-                .autostart(true)
-                .run(this))
-    {}
+    std::vector<std::tr1::shared_ptr<pvd::Thread> > workers;
+
+    explicit WorkQueue( size_t nThreads = 1 )
+        :maxDepth(0)
+        ,nConflated(0)
+        ,nEvicted(0)
+        ,nDrained(0)
+        ,running(true)
+    {
+        for ( size_t i = 0; i < nThreads; i++ )
+        {
+            std::ostringstream  name;
+            name << "pvCapture handler " << i;
+            workers.push_back( std::tr1::shared_ptr<pvd::Thread>( new pvd::Thread(pvd::Thread::Config()
+                                .name(name.str())
+                                .autostart(true)
+                                .run(this)) ) );
+        }
+    }
     ~WorkQueue() {close();}
 
     void close()
@@ -215,29 +432,91 @@ struct WorkQueue : public epicsThreadRunable
             epicsGuard<epicsMutex> G(mutex);
             running = false;
         }
+        // Each exiting thread signals the next
         event.signal();
-        worker.exitWait();
+        for ( size_t i = 0; i < workers.size(); i++ )
+            workers[i]->exitWait();
+        workers.clear();
     }
 
     void push(const weak_type& cb, const pvac::MonitorEvent& evt)
     {
+        value_type  pcb(cb.lock());
+        if(!pcb) return;
         bool wake;
         {
             epicsGuard<epicsMutex> G(mutex);
             if(!running) return; // silently refuse to queue during/after close()
-            wake = queue.empty();
+            if ( evt.event == pvac::MonitorEvent::Data )
+            {
+                if ( overloadPolicy == OverloadConflate && pcb->m_queued > 0 )
+                {
+                    nConflated++;
+                    return;
+                }
+                if ( overloadPolicy == OverloadDropOldest && queue.size() >= workQueueBound )
+                {
+                    // Connect and Disconnect events are never evicted, so skip any ahead
+                    // of the oldest Data event.  There are few, so the search is short.
+                    queue_t::iterator   it  = queue.begin();
+                    while ( it != queue.end() && it->second.event != pvac::MonitorEvent::Data )
+                        ++it;
+                    value_type  old;
+                    if ( it != queue.end() )
+                    {
+                        old = it->first.lock();
+                        queue.erase( it );
+                        nEvicted++;
+                    }
+                    if ( old )
+                    {
+                        old->m_queued--;
+                        if ( !old->m_drainPending )
+                        {
+                            old->m_drainPending = true;
+                            drainList.push_back( old );
+                        }
+                    }
+                }
+            }
+            wake = queue.empty() && drainList.empty();
             queue.push_back(std::make_pair(cb, evt));
+            pcb->m_queued++;
+            if ( queue.size() > maxDepth )
+                maxDepth = queue.size();
         }
         if(wake)
             event.signal();
     }
 
+    size_t getMaxDepth()
+    {
+        epicsGuard<epicsMutex> G(mutex);
+        return maxDepth;
+    }
+
     virtual void run() OVERRIDE FINAL
     {
         epicsGuard<epicsMutex> G(mutex);
 
         while(running) {
-            if(queue.empty()) {
+            if(!drainList.empty()) {
+                value_type cb(drainList.front().lock());
+                drainList.pop_front();
+                if(!cb) continue;
+                cb->m_drainPending = false;
+
+                size_t  n = 0;
+                if(!drainList.empty() || !queue.empty())
+                    event.signal();     // More work, wake another thread
+                try {
+                    epicsGuardRelease<epicsMutex> U(G);
+                    n = cb->drain();
+                }catch(std::exception& e){
+                    std::cout << "Error in monitor drain : " << e.what() << "\n";
+                }
+                nDrained += n;
+            } else if(queue.empty()) {
                 epicsGuardRelease<epicsMutex> U(G);
                 event.wait();
             } else {
@@ -245,6 +524,9 @@ struct WorkQueue : public epicsThreadRunable
                 value_type cb(ent.first.lock());
                 queue.pop_front();
                 if(!cb) continue;
+                cb->m_queued--;
+                if(!queue.empty())
+                    event.signal();     // More work, wake another thread
 
                 try {
                     epicsGuardRelease<epicsMutex> U(G);
@@ -254,30 +536,192 @@ struct WorkQueue : public epicsThreadRunable
                 }
             }
         }
+        event.signal();     // Pass close() on to the next thread
+    }
+};
+
+
+// This could go to it's own cpp file and header
+/// SynthSource
+/// Network free stand-in for pvac::Monitor used by -b.  Owns one NTScalar or
+/// NTScalarArray w/ alarm and timeStamp, and fills in the next counter value
+/// on each poll(), so MonTracker::process() sees the same shape of update as
+/// from a loadServer PV.  Also holds the per stage timing for the -b report.
+struct SynthSource
+{
+    SynthSource( pvd::ScalarType type, size_t nElements )
+        :m_pending( 0 )
+        ,m_count( 0.0 )
+        ,m_nElements( nElements )
+        ,m_generateNs( 0 )
+        ,m_processNs( 0 )
+        ,m_decodeNs( 0 )
+        ,m_recordNs( 0 )
+        ,m_nPolled( 0 )
+        ,m_nStored( 0 )
+    {
+        if ( m_nElements > 1 )
+            root = epics::nt::NTScalarArray::createBuilder()->value( type )->addAlarm()->addTimeStamp()->createPVStructure();
+        else
+            root = epics::nt::NTScalar::createBuilder()->value( type )->addAlarm()->addTimeStamp()->createPVStructure();
+        m_scalarField   = root->getSubField<pvd::PVScalar>( "value" );
+        m_arrayField    = root->getSubField<pvd::PVScalarArray>( "value" );
+        m_secField      = root->getSubFieldT<pvd::PVScalar>( "timeStamp.secondsPastEpoch" );
+        m_nsecField     = root->getSubFieldT<pvd::PVScalar>( "timeStamp.nanoseconds" );
+        changed.set( root->getSubFieldT<pvd::PVField>( "value" )->getFieldOffset() );
+        changed.set( root->getSubFieldT<pvd::PVField>( "timeStamp" )->getFieldOffset() );
+    }
+
+    /// queue one more pending update unless maxPending are already waiting.
+    /// Returns false if not queued, fWasEmpty tells the driver to push a Data event
+    bool queue( size_t maxPending, bool & fWasEmpty )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        fWasEmpty = ( m_pending == 0 );
+        if ( m_pending >= maxPending )
+            return false;
+        m_pending++;
+        return true;
+    }
+
+    size_t pending( )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        return m_pending;
+    }
+
+    /// poll makes the next update current, same contract as pvac::Monitor::poll()
+    /// Allocates a new array for each update, as deserializing one would
+    bool poll( )
+    {
+        {
+            epicsGuard<epicsMutex> G(m_lock);
+            if ( m_pending == 0 )
+                return false;
+            m_pending--;
+        }
+        epicsUInt64 tStart = epicsMonotonicGet();
+        m_count += 1.0;
+        if ( m_scalarField )
+            m_scalarField->putFrom<double>( m_count );
+        else
+        {
+            pvd::shared_vector<double>  values( m_nElements, m_count );
+            m_arrayField->putFrom<double>( pvd::freeze( values ) );
+        }
+        epicsTimeStamp  tsNow;
+        epicsTimeGetCurrent( &tsNow );
+        m_secField->putFrom<epicsUInt64>( tsNow.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH );
+        m_nsecField->putFrom<epicsUInt32>( tsNow.nsec );
+        m_generateNs += epicsMonotonicGet() - tStart;
+        m_nPolled++;
+        return true;
     }
+
+    // Current update, valid until the next poll(), same as pvac::Monitor
+    pvd::PVStructurePtr     root;
+    pvd::BitSet             changed;
+    pvd::BitSet             overrun;    // Always empty, nothing is squashed w/o a server queue
+
+    epicsMutex              m_lock;     // guards m_pending, shared w/ the -b driver thread
+    size_t                  m_pending;
+    double                  m_count;
+    size_t                  m_nElements;
+    std::tr1::shared_ptr<pvd::PVScalar>         m_scalarField;  // NULL for arrays
+    std::tr1::shared_ptr<pvd::PVScalarArray>    m_arrayField;   // NULL for scalars
+    std::tr1::shared_ptr<pvd::PVScalar>         m_secField;
+    std::tr1::shared_ptr<pvd::PVScalar>         m_nsecField;
+
+    // Stage timing in ns, only access w/ the owning MonTracker's monLock
+    epicsUInt64             m_generateNs;   // Filling in root, stands in for deserializing
+    epicsUInt64             m_processNs;    // All of MonTracker::process(), includes the stages below
+    epicsUInt64             m_decodeNs;     // MonTracker::decode()
+    epicsUInt64             m_recordNs;     // MonTracker::record(), the storage path
+    size_t                  m_nPolled;
+    size_t                  m_nStored;      // Decoded to a value and saved by record()
 };
 
 
 // This could go to it's own cpp file and header
 // Borrowed from pvmonitor.cpp
 struct MonTracker : public pvac::ClientChannel::MonitorCallback,
+                    public pvac::ClientChannel::ConnectCallback,
                     public Worker,
                     public Tracker,
                     public std::tr1::enable_shared_from_this<MonTracker>
 {
     POINTER_DEFINITIONS(MonTracker);
 
-    MonTracker(WorkQueue& monwork, pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest, const char * testDirPath, bool fShow)
+    /// Construction doesn't subscribe, call start() once a shared_ptr owns us.
+    /// A monitor event delivered before that would fail shared_from_this()
+    /// w/ bad_weak_ptr, which is what crashed multiple MonTrackers per PV.
+    MonTracker(WorkQueue& monwork, pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest, const char * testDirPath, bool fShow,
+               size_t queueSize = 0, size_t subscriber = 0, const std::string & protocol = std::string() )
         :monwork(monwork)
         ,m_QueueSizeMax( 262144 )
+        ,m_nUpdates( 0 )
+        ,m_nMissed( 0 )
+        ,m_nOverruns( 0 )
+        ,m_nConflated( 0 )
+        ,m_nDropped( 0 )
+        ,m_nSkipped( 0 )
+        ,m_queueSize( queueSize )
+        ,m_nResubscribes( 0 )
+        ,m_fResubscribed( false )
+        ,m_nAdaptUpdates( 0 )
+        ,m_nAdaptOverruns( 0 )
+        ,m_tCreate( epicsMonotonicGet() )
+        ,m_tConnect( 0 )
+        ,m_tFirstUpdate( 0 )
+        ,m_nLatency( 0 )
+        ,m_latencySum( 0.0 )
+        ,m_latencyMax( 0.0 )
+        ,m_cpuNs( 0 )
+        ,m_fRxTimes( false )
         ,valid()
+        ,overrunFields()
         ,fShow(fShow)
         ,m_testDirPath(testDirPath)
-        ,mon(channel.monitor(this, pvRequest)   )
-    {}
+        ,m_pvName(channel.name())
+        ,m_subscriber(subscriber)
+        ,m_protocol(protocol)
+        ,m_fFollower(false)
+        ,m_pvRequest(pvRequest)
+        ,m_channel(channel)
+        ,mon()
+    {
+        if ( !m_protocol.empty() )
+            m_testDirPath += "/" + m_protocol;
+        if ( m_subscriber > 0 )
+        {
+            std::ostringstream  subDir;
+            subDir << m_testDirPath << "/sub" << std::setw(2) << std::setfill('0') << m_subscriber;
+            m_testDirPath = subDir.str();
+        }
+    }
+
+    /// start subscribes, call only after a shared_ptr owns this MonTracker
+    void start( )
+    {
+        m_channel.addConnectListener( this );
+        epicsGuard<epicsMutex> G(monLock);
+        mon = m_channel.monitor( this, m_queueSize ? createQueueRequest(m_queueSize) : m_pvRequest );
+    }
+
+    /// addFollower makes follower a shared decode subscriber of this MonTracker.
+    /// The follower has no monitor of its own, it gets every update we record.
+    void addFollower( const std::tr1::shared_ptr<MonTracker> & follower )
+    {
+        epicsGuard<epicsMutex> G(monLock);
+        follower->m_fFollower = true;
+        follower->done();   // Never completes on its own
+        m_followers.push_back( follower );
+    }
     virtual ~MonTracker()
     {
         try {
+        if ( m_channel )
+            m_channel.removeConnectListener( this );
         mon.cancel();
         }
         catch(std::exception& e){
@@ -286,29 +730,85 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
     }
 
     epicsMutex      queueLock;
+    epicsMutex      monLock;    // Serializes worker access to mon w/ resubscribe()
     WorkQueue   &   monwork;
     
     size_t                  m_QueueSizeMax;
     std::deque<t_TsReal>    m_ValueQueue;
 
+    // Loss accounting, only access from process() and capture()
+    size_t                  m_nUpdates;     // Number of updates polled from mon
+    size_t                  m_nMissed;      // Cumulative missed counts from counter value diffs
+    size_t                  m_nOverruns;    // Number of updates w/ non-empty overrun BitSet
+    size_t                  m_nConflated;   // Updates polled but superseded by a later one
+    size_t                  m_nDropped;     // Updates discarded by drain()
+    size_t                  m_nSkipped;     // Conflated or dropped since last record(), not missed
+
+    // Managed queueSize, 0 if pvRequest is used as is
+    size_t                  m_queueSize;
+    size_t                  m_nResubscribes;
+    bool                    m_fResubscribed;    // Skip missed check on first value after resubscribe
+    size_t                  m_nAdaptUpdates;    // m_nUpdates  at last adaptQueueSize()
+    size_t                  m_nAdaptOverruns;   // m_nOverruns at last adaptQueueSize()
+
+    // Startup timing, epicsMonotonicGet() ns, 0 until it happens, guarded by queueLock
+    epicsUInt64             m_tCreate;
+    epicsUInt64             m_tConnect;
+    epicsUInt64             m_tFirstUpdate;
+
+    // Per update cost, only access from process() and record()
+    size_t                  m_nLatency;     // Number of latency samples
+    double                  m_latencySum;   // Sum of receive time - server timestamp, sec
+    double                  m_latencyMax;
+    epicsUInt64             m_cpuNs;        // Handler thread CPU ns spent in process() and drain()
+    std::tr1::shared_ptr<pvHistogram>   m_latencyHist;  // Optional, shared by all PVs of a protocol
+    std::tr1::shared_ptr<pvGapScan>     m_gapScan;      // Scan of the saved values w/ -J, set by saveValues()
+
+    // Dual path matching, guarded by queueLock
+    typedef std::deque<std::pair<epicsUInt64, epicsUInt64> >    rxTimes_t;
+    bool                    m_fRxTimes;     // Keep m_rxTimes, set before start()
+    rxTimes_t               m_rxTimes;      // tsKey and epicsMonotonicGet() ns when each sample was recorded
+
     pvd::BitSet valid; // only access for process()
+    pvd::BitSet overrunFields; // Cumulative OR of mon.overrun, only access for process()
     bool    fShow;
     std::string     m_testDirPath;
-
+    std::string     m_pvName;
+    size_t          m_subscriber;   // Fan-out subscriber number, 0 for the first or only one
+    std::string     m_protocol;     // Provider name when comparing providers, else empty
+    bool            m_fFollower;    // Shared decode subscriber, fed by another MonTracker
+    pvd::PVStructurePtr     m_pvRequest;
+    std::vector<std::tr1::shared_ptr<MonTracker> >  m_followers;   // only access w/ monLock
+
+    pvac::ClientChannel m_channel;  // Kept for resubscribe()
+    std::tr1::shared_ptr<SynthSource>   m_synth;    // Replaces mon for -b, NULL otherwise
     pvac::Monitor mon; // must be last data member
 
+    // The current update comes from mon, or from m_synth w/ -b
+    bool pollUpdate( )
+    {
+        return m_synth ? m_synth->poll() : mon.poll();
+    }
+    const pvd::PVStructure & updateRoot( ) const
+    {
+        return m_synth ? *m_synth->root : *mon.root;
+    }
+    const pvd::BitSet & updateChanged( ) const
+    {
+        return m_synth ? m_synth->changed : mon.changed;
+    }
+    const pvd::BitSet & updateOverrun( ) const
+    {
+        return m_synth ? m_synth->overrun : mon.overrun;
+    }
+
     /// monitorEvent is called for each new pvAccess event for specified request on this client channel
     /// The ClientChannel defines: virtual void monitorEvent() = 0;
     virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
     {
     try {
-    // TODO: Getting this error msg if I create multiple MonTracker objects for the same PV name
-    // Unhandled exception following exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
-    // or
-    // Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): tr1::bad_weak_ptr
-    // Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
-    // Unhandled exception in ClientChannel::MonitorCallback::monitorEvent(): epicsMutex::invalidMutex()
         // shared_from_this() will fail as Cancel is delivered in our dtor.
+        // Subscribing in start() rather than the ctor keeps it valid for all other events.
         if(evt.event==pvac::MonitorEvent::Cancel) return;
 
         // running on internal provider worker thread
@@ -320,12 +820,44 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
     }
     }
 
+    /// connectEvent records time-to-connect for the first connection
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+    {
+        if ( !evt.connected )
+            return;
+        {
+            epicsGuard<epicsMutex> G(queueLock);
+            if ( m_tConnect != 0 )
+                return;
+            m_tConnect = epicsMonotonicGet();
+        }
+        connectEvt.signal();
+    }
+
+    bool isConnected( )
+    {
+        epicsGuard<epicsMutex> G(queueLock);
+        return m_tConnect != 0;
+    }
+
+    /// Seconds from creation to first connect, or to first update, < 0 if it never happened
+    double timeToConnect( )
+    {
+        epicsGuard<epicsMutex> G(queueLock);
+        return m_tConnect ? ( m_tConnect - m_tCreate ) * 1.0e-9 : -1.0;
+    }
+    double timeToFirstUpdate( )
+    {
+        epicsGuard<epicsMutex> G(queueLock);
+        return m_tFirstUpdate ? ( m_tFirstUpdate - m_tCreate ) * 1.0e-9 : -1.0;
+    }
+
     /// Save the timestamped values on the queue to a file
     void saveValues( )
     {
         std::string     saveFilePath( m_testDirPath );
         saveFilePath += "/";
-        saveFilePath += mon.name();
+        saveFilePath += m_pvName;
         saveFilePath += ".pvCapture";
 
 		if ( m_ValueQueue.size() == 0 )
@@ -354,20 +886,110 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
         }
         fout << std::endl << "]" << std::endl;
 		fout.close();
+        if ( gapScanPeriod > 0.0 )
+            gapScan( saveFilePath );
     }
 
-    /// capture is called for each pvAccess MonitorEvent::Data on the WorkQueue
-    virtual void capture(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    /// Scan the saved values in arrival order for counter steps other than +1,
+    /// backwards timestamps and late or early arrivals, and list any in <saveFilePath>.gapScan
+    void gapScan( const std::string & saveFilePath )
     {
-        assert( evt.event == pvac::MonitorEvent::Data );
-        //for ( epics::pvAccess::MonitorElement::Ref    it(mon); it; ++it )
-        //  epics::pvAccess::MonitorElement &   element(*it);
-        //epics::pvAccess::Monitor::shared_pointer  pmon(&mon.root);
-        //epics::pvAccess::MonitorElement::Ref      element(pmon);
-        std::tr1::shared_ptr<const pvd::PVStructure>    pvStruct = mon.root;
-        //if ( element )
-        assert( pvStruct != 0 );
+        std::vector<epicsUInt64>    tsKeys;
+        std::vector<double>         values;
+        tsKeys.reserve( m_ValueQueue.size() );
+        values.reserve( m_ValueQueue.size() );
+        for ( std::deque<t_TsReal>::iterator it = m_ValueQueue.begin(); it != m_ValueQueue.end(); ++it )
+        {
+            tsKeys.push_back( ( static_cast<epicsUInt64>( it->ts.secPastEpoch ) << 32 ) + it->ts.nsec );
+            values.push_back( it->val );
+        }
+        pvGapScan::Config   config;
+        config.period   = gapScanPeriod;
+        m_gapScan.reset( new pvGapScan( m_pvName, config ) );
+        m_gapScan->scan( tsKeys, values );
+        if ( m_gapScan->getExceptions().empty() )
+            return;
+        std::string     scanFilePath( saveFilePath + ".gapScan" );
+        std::ofstream   fout( scanFilePath.c_str() );
+        m_gapScan->show( fout, true );
+        m_gapScan->showExceptions( fout );
+    }
+
+    /// Show loss accounting for this PV: value-diff misses vs server-side overruns
+    void showStats( std::ostream & out ) const
+    {
+        std::ostringstream  label;
+        label << m_pvName;
+        if ( !m_protocol.empty() )
+            label << "@" << m_protocol;
+        if ( nSubscribers > 1 )
+            label << "[" << m_subscriber << "]";
+        out << std::setw(pvnamewidth) << std::left << label.str()
+            << std::right
+            << " " << std::setw(10) << m_nUpdates
+            << " " << std::setw(10) << m_nMissed
+            << " " << std::setw(10) << m_nOverruns
+            << " " << std::setw(10) << overrunFields.cardinality();
+        if ( overloadPolicy != OverloadLossless )
+            out << " " << std::setw(10) << m_nConflated
+                << " " << std::setw(10) << m_nDropped;
+        if ( m_fFollower && queueSizeMax > 0 )
+            out << " " << std::setw(10) << "-"      // Followers use their leader's monitor
+                << " " << std::setw(10) << "-";
+        else if ( m_queueSize )
+            out << " " << std::setw(10) << m_queueSize
+                << " " << std::setw(10) << m_nResubscribes;
+        out << std::left << std::endl;
+    }
+
+    /// Cancel the current monitor and restart it w/ a new managed queueSize
+    /// Called from main thread, so hold monLock to keep the worker out of mon
+    void resubscribe( size_t queueSize )
+    {
+        epicsGuard<epicsMutex> G(monLock);
+        mon.cancel();
+        m_queueSize     = queueSize;
+        m_fResubscribed = true;
+        m_nResubscribes++;
+        mon = m_channel.monitor( this, createQueueRequest(queueSize) );
+    }
+
+    /// Grow the managed queueSize of PVs w/ overruns since the last call, shrink idle ones
+    /// Returns true if the queueSize was changed
+    bool adaptQueueSize( double period )
+    {
+        size_t  nUpdates;
+        size_t  nOverruns;
+        {
+            epicsGuard<epicsMutex> G(monLock);
+            nUpdates            = m_nUpdates    - m_nAdaptUpdates;
+            nOverruns           = m_nOverruns   - m_nAdaptOverruns;
+            m_nAdaptUpdates     = m_nUpdates;
+            m_nAdaptOverruns    = m_nOverruns;
+        }
+        // Followers have no monitor of their own, they see their leader's overruns
+        if ( m_queueSize == 0 || m_fFollower )
+            return false;
+
+        size_t  queueSize = m_queueSize;
+        if ( nOverruns > 0 && queueSize < queueSizeMax )
+            queueSize = std::min( queueSize * 2, queueSizeMax );
+        else if ( nOverruns == 0 && nUpdates < period && queueSize > queueSizeMin )
+            queueSize = std::max( queueSize / 2, queueSizeMin );   // Less than 1 update/sec
+        if ( queueSize == m_queueSize )
+            return false;
+
+        if ( debugFlag )
+            std::cout << m_pvName << ": queueSize " << m_queueSize << " -> " << queueSize
+                      << ", " << nUpdates << " updates, " << nOverruns << " overruns" << std::endl;
+        resubscribe( queueSize );
+        return true;
+    }
 
+    /// decode extracts the timestamped value from an update
+    /// Returns false if the update should not be captured
+    bool decode( const pvd::PVStructure & pvStruct, t_TsReal & tsValue )
+    {
         // mon.name() should be pvName
         // To see text representation
         // pvd::PVStructure::Formatter  fmt( mon.root->stream().format(outmode) );
@@ -388,14 +1010,14 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
         // template<> const ScalarType PVDouble::typeCode = pvDouble;
         try
         {
-            std::tr1::shared_ptr<const pvd::PVInt>  pStatus = pvStruct->getSubField<pvd::PVInt>("alarm.status");
-            std::tr1::shared_ptr<const pvd::PVInt>  pSeverity = pvStruct->getSubField<pvd::PVInt>("alarm.severity");
+            std::tr1::shared_ptr<const pvd::PVInt>  pStatus = pvStruct.getSubField<pvd::PVInt>("alarm.status");
+            std::tr1::shared_ptr<const pvd::PVInt>  pSeverity = pvStruct.getSubField<pvd::PVInt>("alarm.severity");
             // Only capture values w/ alarm.status NO_ALARM
             if ( pStatus == NULL || pStatus->get() != NO_ALARM )
-                return;
+                return false;
             if ( pSeverity == NULL || pSeverity->get() != 0 )
-                return;
-            std::tr1::shared_ptr<const pvd::PVDouble>   pValue  = pvStruct->getSubField<pvd::PVDouble>("value");
+                return false;
+            std::tr1::shared_ptr<const pvd::PVDouble>   pValue  = pvStruct.getSubField<pvd::PVDouble>("value");
             double          value           = NAN;
             if ( pValue )
             {
@@ -404,12 +1026,12 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
 
             epicsUInt32     secPastEpoch    = 1;
             epicsUInt32     nsec            = 2;
-            std::tr1::shared_ptr<const pvd::PVScalar>   pScalarSec  = pvStruct->getSubField<pvd::PVScalar>("timeStamp.secondsPastEpoch");
+            std::tr1::shared_ptr<const pvd::PVScalar>   pScalarSec  = pvStruct.getSubField<pvd::PVScalar>("timeStamp.secondsPastEpoch");
             if ( pScalarSec )
             {
                 secPastEpoch    = pScalarSec->getAs<pvd::uint32>();
             }
-            std::tr1::shared_ptr<const pvd::PVScalar>   pScalarNSec = pvStruct->getSubField<pvd::PVScalar>("timeStamp.nanoseconds");
+            std::tr1::shared_ptr<const pvd::PVScalar>   pScalarNSec = pvStruct.getSubField<pvd::PVScalar>("timeStamp.nanoseconds");
             if ( pScalarNSec )
             {
                 nsec    = pScalarNSec->getAs<pvd::uint32>();
@@ -418,100 +1040,252 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
             timeStamp.secPastEpoch = secPastEpoch;
             timeStamp.nsec = nsec;
             //pvd::TimeStamp    timeStamp( secPastEpoch, nsec );
-            t_TsReal    tsValue( timeStamp, value );
-            t_TsReal    tsPrior;
-            assert( isnan(tsPrior.val) );
+            tsValue = t_TsReal( timeStamp, value );
+            return true;
+        }
+        catch(std::runtime_error& e)
+        {
+            std::cout << "Bad Field Type in capture handler : " << e.what() << "\n";
+        }
+        catch(std::exception& e)
+        {
+            std::cout << "Error in capture handler : " << e.what() << "\n";
+        }
+        return false;
+    }
 
-            //if ( pStatus == NULL || pStatus->get() != NO_ALARM )
-            //  return;
-            {   // Keep guard while accessing m_ValueQueue
-            epicsGuard<epicsMutex> G(queueLock);
-            if ( !m_ValueQueue.empty() )
-                tsPrior = m_ValueQueue.back();
-            if ( ! isnan(tsValue.val) )
-            {
-                if( m_ValueQueue.size() >= m_QueueSizeMax )
-                    m_ValueQueue.pop_front();
-                m_ValueQueue.push_back( tsValue );
-            }
-            }
+    /// record saves a decoded value and checks for missed counter updates
+    /// Updates we skipped on purpose (conflated or dropped) are not counted as missed
+    void record( const t_TsReal & tsValue )
+    {
+        t_TsReal    tsPrior;
+        assert( isnan(tsPrior.val) );
+
+        // Shared decode: followers see the same update and the same skips
+        for ( size_t i = 0; i < m_followers.size(); i++ )
+        {
+            m_followers[i]->m_nSkipped      += m_nSkipped;
+            m_followers[i]->m_fResubscribed |= m_fResubscribed;
+            m_followers[i]->record( tsValue );
+        }
+
+        // Latency from the server timestamp to when our handler gets the update.
+        // Clock offset between hosts is the same for every provider, so the
+        // difference between providers for the same PV is still meaningful.
+        epicsTimeStamp  tsNow;
+        if ( epicsTimeGetCurrent( &tsNow ) == 0 && tsValue.ts.secPastEpoch > POSIX_TIME_AT_EPICS_EPOCH )
+        {
+            // pvData timeStamp.secondsPastEpoch is POSIX seconds, epicsTimeStamp is EPICS epoch
+            epicsTimeStamp  tsServer    = tsValue.ts;
+            tsServer.secPastEpoch -= POSIX_TIME_AT_EPICS_EPOCH;
+            double  latency = epicsTimeDiffInSeconds( &tsNow, &tsServer );
+            m_nLatency++;
+            m_latencySum += latency;
+            if ( latency > m_latencyMax )
+                m_latencyMax = latency;
+            if ( m_latencyHist )
+                m_latencyHist->add( latency );
+        }
+
+        {   // Keep guard while accessing m_ValueQueue
+        epicsGuard<epicsMutex> G(queueLock);
+        if ( !m_ValueQueue.empty() )
+            tsPrior = m_ValueQueue.back();
+        if ( ! isnan(tsValue.val) )
+        {
+            if( m_ValueQueue.size() >= m_QueueSizeMax )
+                m_ValueQueue.pop_front();
+            m_ValueQueue.push_back( tsValue );
+        }
+        if ( m_fRxTimes )
+        {
+            epicsUInt64 tsKey = tsValue.ts.secPastEpoch;
+            tsKey <<= 32;
+            tsKey += tsValue.ts.nsec;
+            if( m_rxTimes.size() >= m_QueueSizeMax )
+                m_rxTimes.pop_front();
+            m_rxTimes.push_back( std::make_pair( tsKey, epicsMonotonicGet() ) );
+        }
+        }
 
-            // std::cout << "tsPrior: val=" << tsPrior.val << ", ts=[" << tsPrior.ts.secPastEpoch << ", " << tsPrior.ts.nsec << "]" << "\n";
-            // std::cout << "tsValue:      val=" << tsValue.val << ", ts=[" << tsValue.ts.secPastEpoch << ", " << tsValue.ts.nsec << "]" << "\n";
-            // Check for missed counter update
-            if ( ! isnan(tsValue.val) && tsValue.val != 0 && ! isnan(tsPrior.val) )
+        // std::cout << "tsPrior: val=" << tsPrior.val << ", ts=[" << tsPrior.ts.secPastEpoch << ", " << tsPrior.ts.nsec << "]" << "\n";
+        // std::cout << "tsValue:      val=" << tsValue.val << ", ts=[" << tsValue.ts.secPastEpoch << ", " << tsValue.ts.nsec << "]" << "\n";
+        // Check for missed counter update
+        // Updates posted while resubscribing are lost by design, not counted as missed
+        bool    fResubscribed = m_fResubscribed;
+        size_t  nSkipped = m_nSkipped;
+        m_fResubscribed = false;
+        m_nSkipped = 0;
+        if ( ! isnan(tsValue.val) && tsValue.val != 0 && ! isnan(tsPrior.val) && ! fResubscribed )
+        {
+            if ( tsPrior.val + 1.0 + nSkipped != tsValue.val )
             {
-                if ( tsPrior.val + 1.0 != tsValue.val )
+                if ( debugFlag )
                 {
-                    if ( debugFlag )
-                    {
-                        std::cout   << "tsPrior:"
-                            << " val="  << tsPrior.val  
-                            << ", ts=[" << tsPrior.ts.secPastEpoch << ", " << tsPrior.ts.nsec << "]"
-                            << ", SEVR=" << *pSeverity
-                            << ", STAT=" << *pStatus << "\n";
-                        std::cout   << "tsValue:"
-                            << " val="  << tsValue.val  
-                            << ", ts=[" << tsValue.ts.secPastEpoch << ", " << tsValue.ts.nsec << "]"
-                            << ", SEVR=" << *pSeverity
-                            << ", STAT=" << *pStatus << "\n";
-                    }
-                    long int    nMissed = lround( tsValue.val - tsPrior.val - 1 );
-                    LOG( epics::pvAccess::logLevelError, "%s: Missed %ld, prior %ld, cur %ld", mon.name().c_str(),
-                        nMissed, static_cast<long int>(tsPrior.val), static_cast<long int>(tsValue.val) );
+                    std::cout   << "tsPrior:"
+                        << " val="  << tsPrior.val  
+                        << ", ts=[" << tsPrior.ts.secPastEpoch << ", " << tsPrior.ts.nsec << "]" << "\n";
+                    std::cout   << "tsValue:"
+                        << " val="  << tsValue.val  
+                        << ", ts=[" << tsValue.ts.secPastEpoch << ", " << tsValue.ts.nsec << "]"
+                        << ", skipped " << nSkipped << "\n";
                 }
+                long int    nMissed = lround( tsValue.val - tsPrior.val - 1 ) - static_cast<long int>(nSkipped);
+                if ( nMissed > 0 )
+                    m_nMissed += nMissed;
+                LOG( epics::pvAccess::logLevelError, "%s: Missed %ld, prior %ld, cur %ld", m_pvName.c_str(),
+                    nMissed, static_cast<long int>(tsPrior.val), static_cast<long int>(tsValue.val) );
             }
         }
-        catch(std::runtime_error& e)
+    }
+
+    /// capture is called for each pvAccess MonitorEvent::Data on the WorkQueue
+    void capture( const pvac::MonitorEvent& evt )
+    {
+        assert( evt.event == pvac::MonitorEvent::Data );
+        //for ( epics::pvAccess::MonitorElement::Ref    it(mon); it; ++it )
+        //  epics::pvAccess::MonitorElement &   element(*it);
+        //epics::pvAccess::Monitor::shared_pointer  pmon(&mon.root);
+        //epics::pvAccess::MonitorElement::Ref      element(pmon);
+        epicsUInt64 tStart  = m_synth ? epicsMonotonicGet() : 0;
+        t_TsReal    tsValue;
+        bool        fDecoded = decode( updateRoot(), tsValue );
+        epicsUInt64 tDecoded = m_synth ? epicsMonotonicGet() : 0;
+        if ( fDecoded )
+            record( tsValue );
+        if ( m_synth )
         {
-            std::cout << "Bad Field Type in capture handler : " << e.what() << "\n";
+            m_synth->m_decodeNs += tDecoded - tStart;
+            m_synth->m_recordNs += epicsMonotonicGet() - tDecoded;
+            if ( fDecoded && !isnan( tsValue.val ) )
+                m_synth->m_nStored++;
         }
-        catch(std::exception& e)
+    }
+
+    /// Count a polled update and check its overrun BitSet
+    void countUpdate( )
+    {
+        if ( m_nUpdates++ == 0 )
         {
-            std::cout << "Error in capture handler : " << e.what() << "\n";
+            epicsGuard<epicsMutex> G(queueLock);
+            m_tFirstUpdate = epicsMonotonicGet();
+        }
+        for ( size_t i = 0; i < m_followers.size(); i++ )
+        {
+            m_followers[i]->m_nUpdates++;
+            if ( !updateOverrun().isEmpty() )
+                m_followers[i]->m_nOverruns++;
+        }
+
+        // A non-empty overrun BitSet means the server squashed one or more
+        // updates into this one because its monitor queue was full.
+        if ( !updateOverrun().isEmpty() )
+        {
+            m_nOverruns++;
+            overrunFields |= updateOverrun();
+            LOG( epics::pvAccess::logLevelError, "%s: Overrun, %u fields", m_pvName.c_str(),
+                static_cast<unsigned int>(updateOverrun().cardinality()) );
         }
     }
 
+    /// Show the current update, same output options as pvmonitor
+    void show( )
+    {
+        pvd::PVStructure::Formatter fmt(updateRoot().stream()
+                                        .format(outmode));
+
+        if(verbosity>=3)
+            fmt.highlight(updateChanged()); // show all
+        else if(verbosity>=2)
+            fmt.highlight(updateChanged()).show(valid);
+        else
+            fmt.show(updateChanged()); // highlight none
+
+        std::cout << std::setw(pvnamewidth) << std::left << m_pvName << ' ' << fmt;
+    }
+
+    /// drain is called on the WorkQueue after drop-oldest evicts one of our events
+    virtual size_t drain( ) OVERRIDE FINAL
+    {
+        epicsGuard<epicsMutex> G(monLock);
+        epicsUInt64 cpuStart = threadCpuNs();
+        size_t  n = 0;
+        while ( pollUpdate() )
+        {
+            countUpdate();
+            n++;
+        }
+        m_nDropped += n;
+        m_nSkipped += n;
+        m_cpuNs += threadCpuNs() - cpuStart;
+        return n;
+    }
+
     /// process is called for each pvAccess event on the WorkQueue
     virtual void process(const pvac::MonitorEvent& evt) OVERRIDE FINAL
     {
     try {
         unsigned n;
+        epicsGuard<epicsMutex> G(monLock);
+        epicsUInt64 cpuStart = threadCpuNs();
+        epicsUInt64 tStart   = m_synth ? epicsMonotonicGet() : 0;
         // running on our worker thread
         switch(evt.event)
         {
         case pvac::MonitorEvent::Fail:
-            std::cerr << std::setw(pvnamewidth) << std::left << mon.name() << " Error " << evt.message << "\n";
+            std::cerr << std::setw(pvnamewidth) << std::left << m_pvName << " Error " << evt.message << "\n";
             haderror = 1;
             done();
             break;
         case pvac::MonitorEvent::Cancel:
             break;
         case pvac::MonitorEvent::Disconnect:
-            std::cout << std::setw(pvnamewidth) << std::left << mon.name() << " <Disconnect>\n";
+            std::cout << std::setw(pvnamewidth) << std::left << m_pvName << " <Disconnect>\n";
             valid.clear();
             break;
         case pvac::MonitorEvent::Data:
-            for(n=0; n<2 && mon.poll(); n++)
+            if ( overloadPolicy == OverloadConflate )
+            {
+                // Decode everything pending but only record the latest.
+                // Elements are recycled after the next poll(), so keep the decoded value, not mon.root
+                // An update that doesn't decode leaves the last good one in place.
+                t_TsReal    tsLatest;
+                t_TsReal    tsNext;
+                bool        fLatest = false;
+                for(n=0; n<conflateMaxPoll && pollUpdate(); n++)
+                {
+                    valid |= updateChanged();
+                    countUpdate();
+                    if ( decode( updateRoot(), tsNext ) )
+                    {
+                        if ( fLatest )
+                        {
+                            m_nConflated++;
+                            m_nSkipped++;
+                        }
+                        tsLatest    = tsNext;
+                        fLatest     = true;
+                    }
+                    if ( fShow )
+                        show();
+                }
+                if ( fLatest )
+                    record( tsLatest );
+                if(n==conflateMaxPoll)
+                    monwork.push(shared_from_this(), evt);
+                else if(n > 0 && !m_synth && mon.complete())
+                    done();
+                break;
+            }
+            for(n=0; n<2 && pollUpdate(); n++)
             {
-                valid |= mon.changed;
+                valid |= updateChanged();
+                countUpdate();
 
                 // Capture the new value
                 capture( evt );
                 if ( fShow )
-                {
-                    pvd::PVStructure::Formatter fmt(mon.root->stream()
-                                                    .format(outmode));
-
-                    if(verbosity>=3)
-                        fmt.highlight(mon.changed); // show all
-                    else if(verbosity>=2)
-                        fmt.highlight(mon.changed).show(valid);
-                    else
-                        fmt.show(mon.changed); // highlight none
-
-                    std::cout << std::setw(pvnamewidth) << std::left << mon.name() << ' ' << fmt;
-                }
+                    show();
             }
             if(n==2)
             {
@@ -520,15 +1294,18 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
             }
             else if(n==0)
             {
-                LOG(epics::pvAccess::logLevelDebug, "%s Spurious Data event on channel", mon.name().c_str());
+                LOG(epics::pvAccess::logLevelDebug, "%s Spurious Data event on channel", m_pvName.c_str());
             }
             else
             {
-                if(mon.complete())
+                if(!m_synth && mon.complete())
                     done();
             }
             break;
         }
+        m_cpuNs += threadCpuNs() - cpuStart;
+        if ( m_synth )
+            m_synth->m_processNs += epicsMonotonicGet() - tStart;
         std::cout.flush();
     }
         catch(std::exception& e)
@@ -538,6 +1315,230 @@ struct MonTracker : public pvac::ClientChannel::MonitorCallback,
     }
 };
 
+// This could go to it's own cpp file and header
+/// GwForwarder
+/// One PV of the in-process gateway stand-in: monitors the PV directly and
+/// re-posts every update to a read only SharedPV served by GwStandIn.
+struct GwForwarder : public pvac::ClientChannel::MonitorCallback
+{
+    GwForwarder( pvac::ClientChannel & channel, const pvd::PVStructurePtr & pvRequest )
+        :m_pv( pvas::SharedPV::buildReadOnly() )
+        ,m_nForwarded( 0 )
+    {
+        // Hold m_lock so an early monitorEvent() waits for mon
+        epicsGuard<epicsMutex> G(m_lock);
+        mon = channel.monitor( this, pvRequest );
+    }
+    virtual ~GwForwarder()
+    {
+        mon.cancel();
+    }
+
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+    try {
+        epicsGuard<epicsMutex> G(m_lock);
+        switch(evt.event)
+        {
+        case pvac::MonitorEvent::Data:
+            while ( mon.poll() )
+            {
+                if ( !m_pv->isOpen() )
+                    m_pv->open( *mon.root );
+                else
+                    m_pv->post( *mon.root, mon.changed );
+                m_nForwarded++;
+            }
+            break;
+        case pvac::MonitorEvent::Disconnect:
+            // Gateway clients see a disconnect too, reopened w/ the next update
+            m_pv->close();
+            break;
+        default:
+            break;
+        }
+    }
+    catch(std::exception& e){
+        std::cout << "Error in GwForwarder : " << e.what() << "\n";
+    }
+    }
+
+    epicsMutex                      m_lock;
+    pvas::SharedPV::shared_pointer  m_pv;
+    size_t                          m_nForwarded;
+    pvac::Monitor mon; // must be last data member
+};
+
+// This could go to it's own cpp file and header
+/// GwStandIn
+/// Minimal forwarding gateway for local dual path tests, not a real gateway:
+/// one upstream monitor per PV, no access security, no caching beyond the SharedPV.
+/// Serves on loopback only, TCP port and UDP port+1, so it never answers
+/// searches from the direct path.
+struct GwStandIn
+{
+    GwStandIn( unsigned port, const std::vector<std::string> & pvList, const pvd::PVStructurePtr & pvRequest )
+        :m_upstream( providerNames[0] )
+        ,m_provider( "gwStandIn" )
+    {
+        std::set<std::string>   pvNames( pvList.begin(), pvList.end() );
+        for ( std::set<std::string>::const_iterator it = pvNames.begin(); it != pvNames.end(); ++it )
+        {
+            pvac::ClientChannel chan( m_upstream.connect( *it ) );
+            std::tr1::shared_ptr<GwForwarder>   fwd( new GwForwarder( chan, pvRequest ) );
+            m_provider.add( *it, fwd->m_pv );
+            m_forwarders.push_back( fwd );
+        }
+        std::ostringstream  tcpPort, udpPort;
+        tcpPort << port;
+        udpPort << port + 1;
+        m_server = epics::pvAccess::ServerContext::create(
+                        epics::pvAccess::ServerContext::Config()
+                        .config( epics::pvAccess::ConfigurationBuilder()
+                                    .push_env()
+                                    .add( "EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1" )
+                                    .add( "EPICS_PVAS_SERVER_PORT", tcpPort.str() )
+                                    .add( "EPICS_PVAS_BROADCAST_PORT", udpPort.str() )
+                                    .push_map()
+                                    .build() )
+                        .provider( m_provider.provider() ) );
+        std::cout << "pvCapture: Gateway stand-in serving " << pvNames.size() << " PVs on TCP port "
+                  << m_server->getServerPort() << ", UDP port " << port + 1 << std::endl;
+    }
+    ~GwStandIn()
+    {
+        if ( m_server )
+            m_server->shutdown();
+        m_forwarders.clear();
+    }
+
+    size_t numForwarded( )
+    {
+        size_t  n = 0;
+        for ( size_t i = 0; i < m_forwarders.size(); i++ )
+        {
+            epicsGuard<epicsMutex> G(m_forwarders[i]->m_lock);
+            n += m_forwarders[i]->m_nForwarded;
+        }
+        return n;
+    }
+
+    pvac::ClientProvider                                m_upstream;
+    pvas::StaticProvider                                m_provider;
+    std::vector<std::tr1::shared_ptr<GwForwarder> >     m_forwarders;
+    epics::pvAccess::ServerContext::shared_pointer      m_server;
+};
+
+/// runSynthetic feeds synthetic updates for each PV in pvList through the
+/// WorkQueue, MonTracker::process(), capture() and storage w/o any network,
+/// once per ScalarType in synthTypes, and reports ns per update for each stage.
+void runSynthetic( std::vector<std::string> pvList, const pvd::PVStructurePtr & pvRequest )
+{
+    if ( pvList.empty() )
+    {
+        char    pvName[64];
+        for ( size_t i = 0; i < 100; i++ )
+        {
+            snprintf( pvName, sizeof(pvName), "SYNTH:Count%02u", static_cast<unsigned int>(i) );
+            pvList.push_back( pvName );
+        }
+    }
+    if ( synthTypes.empty() )
+        synthTypes.push_back( pvd::pvDouble );
+
+    std::cout << "Synthetic capture: " << pvList.size() << " PVs x " << synthUpdates << " updates, "
+              << ( synthArraySize > 1 ? "NTScalarArray" : "NTScalar" );
+    if ( synthArraySize > 1 )
+        std::cout << "[" << synthArraySize << "]";
+    std::cout << ", " << nWorkerThreads << " WorkQueue thread(s)" << std::endl;
+    std::cout   << std::left << std::setw(8) << "Type" << std::right
+                << " " << std::setw(10) << "Updates"
+                << " " << std::setw(10) << "Stored"
+                << " " << std::setw(10) << "Total(ns)"
+                << " " << std::setw(10) << "Dispatch"
+                << " " << std::setw(10) << "Process"
+                << " " << std::setw(10) << "Generate"
+                << " " << std::setw(10) << "Decode"
+                << " " << std::setw(10) << "Record" << std::endl;
+
+    pvac::MonitorEvent  dataEvt;
+    dataEvt.event = pvac::MonitorEvent::Data;
+    for ( size_t iType = 0; iType < synthTypes.size() && !Tracker::abort; iType++ )
+    {
+        WorkQueue   monwork( nWorkerThreads );
+        std::vector<std::tr1::shared_ptr<MonTracker> >  tracked;
+        std::vector<size_t>                             nQueued( pvList.size(), 0 );
+        pvac::ClientChannel noChannel;
+        for ( size_t i = 0; i < pvList.size(); i++ )
+        {
+            std::tr1::shared_ptr<MonTracker>    tracker( new MonTracker( monwork, noChannel, pvRequest, "", false ) );
+            tracker->m_pvName   = pvList[i];
+            tracker->m_synth.reset( new SynthSource( synthTypes[iType], synthArraySize ) );
+            tracked.push_back( tracker );
+        }
+
+        // Round robin one update per PV, as a server posting all PVs each tick would
+        epicsUInt64 tStart  = epicsMonotonicGet();
+        size_t      nLeft   = pvList.size() * synthUpdates;
+        while ( nLeft > 0 && !Tracker::abort )
+        {
+            size_t  nRound = 0;
+            for ( size_t i = 0; i < tracked.size(); i++ )
+            {
+                bool    fWasEmpty;
+                if ( nQueued[i] >= synthUpdates || !tracked[i]->m_synth->queue( synthMaxPending, fWasEmpty ) )
+                    continue;
+                nQueued[i]++;
+                nRound++;
+                if ( fWasEmpty )
+                    monwork.push( tracked[i], dataEvt );
+            }
+            nLeft -= nRound;
+            if ( nRound == 0 )
+                epicsThreadSleep( 0.0 );   // Every PV is at synthMaxPending, let the WorkQueue catch up
+        }
+        for ( size_t i = 0; i < tracked.size() && !Tracker::abort; i++ )
+            while ( tracked[i]->m_synth->pending() > 0 && !Tracker::abort )
+                epicsThreadSleep( 0.0 );
+        monwork.close();
+        double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+
+        // Worker threads are gone, no more monLock needed
+        size_t      nUpdates    = 0;
+        size_t      nStored     = 0;
+        epicsUInt64 generateNs  = 0;
+        epicsUInt64 processNs   = 0;
+        epicsUInt64 decodeNs    = 0;
+        epicsUInt64 recordNs    = 0;
+        for ( size_t i = 0; i < tracked.size(); i++ )
+        {
+            const SynthSource & synth = *tracked[i]->m_synth;
+            nUpdates    += synth.m_nPolled;
+            nStored     += synth.m_nStored;
+            generateNs  += synth.m_generateNs;
+            processNs   += synth.m_processNs;
+            decodeNs    += synth.m_decodeNs;
+            recordNs    += synth.m_recordNs;
+        }
+        double  perUpdate   = nUpdates ? 1.0 / nUpdates : 0.0;
+        double  totalNs     = elapsed * 1.0e9 * perUpdate;
+        // Wall time per update not spent in process(), i.e. WorkQueue and driver overhead
+        double  dispatchNs  = totalNs - processNs * perUpdate / nWorkerThreads;
+        std::cout   << std::left << std::setw(8) << pvd::ScalarTypeFunc::name( synthTypes[iType] ) << std::right
+                    << std::fixed << std::setprecision(1)
+                    << " " << std::setw(10) << nUpdates
+                    << " " << std::setw(10) << nStored
+                    << " " << std::setw(10) << totalNs
+                    << " " << std::setw(10) << std::max( dispatchNs, 0.0 )
+                    << " " << std::setw(10) << processNs  * perUpdate
+                    << " " << std::setw(10) << generateNs * perUpdate
+                    << " " << std::setw(10) << decodeNs   * perUpdate
+                    << " " << std::setw(10) << recordNs   * perUpdate << std::endl;
+        std::cout.unsetf( std::ios::fixed );
+    }
+    std::cout << "Generate is included in Process, Decode and Record only cover the lossless capture() path." << std::endl;
+}
+
 } // namespace
 
 #ifndef MAIN
@@ -556,13 +1557,14 @@ int MAIN (int argc, char *argv[])
         bool fShow      = false;
         std::string         pvFilename("");
         std::vector<std::string>    pvList;
+        std::vector<size_t>         pvClient;   // Logical client for each pvList entry
 
         epics::RefMonitor refmon;
         std::string     testDirPath( "/tmp/pvCaptureTest1" );
 
         // ================ Parse Arguments
 
-        while ((opt = getopt(argc, argv, ":hvVSRD:M:r:w:tmp:qdcF:f:ni")) != -1) {
+        while ((opt = getopt(argc, argv, ":hvVSRD:M:r:w:tmp:qdcF:f:niQ:O:B:P:o:K:N:W:u:Ug:G:a:b:T:A:J:")) != -1) {
             switch (opt) {
             case 'h':               /* Print usage */
                 usage();
@@ -626,6 +1628,187 @@ int MAIN (int argc, char *argv[])
             case 'f':               /* Use input stream as input */
                 pvFilename = optarg;
                 break;
+            case 'Q':               /* Managed per-PV queueSize */
+            {
+                unsigned int    qMin, qMax;
+                if ( sscanf( optarg, "%u:%u", &qMin, &qMax ) != 2 || qMin == 0 || qMax < qMin )
+                {
+                    fprintf(stderr, "'%s' is not a valid <min>:<max> queueSize range "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    queueSizeMin = qMin;
+                    queueSizeMax = qMax;
+                }
+            }
+                break;
+            case 'O':               /* Overload policy */
+                if(strcmp(optarg, "lossless")==0) {
+                    overloadPolicy = OverloadLossless;
+                } else if(strcmp(optarg, "conflate")==0) {
+                    overloadPolicy = OverloadConflate;
+                } else if(strcmp(optarg, "drop-oldest")==0) {
+                    overloadPolicy = OverloadDropOldest;
+                } else {
+                    fprintf(stderr, "Unknown overload policy '%s' - ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                }
+                break;
+            case 'B':               /* WorkQueue bound for drop-oldest */
+            {
+                unsigned int    bound;
+                if ( sscanf( optarg, "%u", &bound ) != 1 || bound == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid WorkQueue bound "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    workQueueBound = bound;
+                }
+            }
+                break;
+            case 'P':               /* Paced startup rate */
+            {
+                double temp;
+                if((epicsScanDouble(optarg, &temp)) != 1 || temp <= 0.0)
+                {
+                    fprintf(stderr, "'%s' is not a valid channel creation rate "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    createRate = temp;
+                }
+            }
+                break;
+            case 'o':               /* Max outstanding searches */
+            {
+                unsigned int    nMax;
+                if ( sscanf( optarg, "%u", &nMax ) != 1 )
+                {
+                    fprintf(stderr, "'%s' is not a valid max outstanding searches "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    maxSearches = nMax;
+                }
+            }
+                break;
+            case 'K':               /* Number of provider contexts */
+            {
+                unsigned int    nK;
+                if ( sscanf( optarg, "%u", &nK ) != 1 || nK == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid number of provider contexts "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    nContexts = nK;
+                }
+            }
+                break;
+            case 'N':               /* Number of logical clients */
+            {
+                unsigned int    nN;
+                if ( sscanf( optarg, "%u", &nN ) != 1 || nN == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid number of clients "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    nClients = nN;
+                }
+            }
+                break;
+            case 'W':               /* Number of WorkQueue threads */
+            {
+                unsigned int    nW;
+                if ( sscanf( optarg, "%u", &nW ) != 1 || nW == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid number of WorkQueue threads "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    nWorkerThreads = nW;
+                }
+            }
+                break;
+            case 'u':               /* Fan-out subscribers per PV */
+            {
+                unsigned int    nU;
+                if ( sscanf( optarg, "%u", &nU ) != 1 || nU == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid number of subscribers "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    nSubscribers = nU;
+                }
+            }
+                break;
+            case 'U':               /* Fan-out w/ shared decode */
+                sharedDecode = true;
+                break;
+            case 'g':               /* Dual path via gateway */
+                gatewayAddrList = optarg;
+                break;
+            case 'a':               /* Direct path server address */
+                serverAddress = optarg;
+                break;
+            case 'G':               /* In-process gateway stand-in */
+            {
+                unsigned int    port;
+                if ( sscanf( optarg, "%u", &port ) != 1 || port == 0 || port >= 65535 )
+                {
+                    fprintf(stderr, "'%s' is not a valid gateway stand-in port "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                }
+                else
+                    gatewayStandInPort = port;
+            }
+                break;
+            case 'b':               /* Synthetic capture pipeline benchmark */
+            case 'A':
+            {
+                unsigned int    count;
+                if ( sscanf( optarg, "%u", &count ) != 1 || count == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid count for -%c "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+                }
+                else if ( opt == 'b' )
+                    synthUpdates = count;
+                else
+                    synthArraySize = count;
+            }
+                break;
+            case 'T':               /* ScalarTypes for -b */
+            {
+                std::istringstream  typeList( optarg );
+                std::string         name;
+                while ( getline( typeList, name, ',' ) )
+                {
+                    if ( name.empty() )
+                        continue;
+                    try
+                    {
+                        pvd::ScalarType type = pvd::ScalarTypeFunc::getScalarType( name );
+                        if ( type == pvd::pvBoolean || type == pvd::pvString )
+                            fprintf(stderr, "'%s' is not a numeric type "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", name.c_str());
+                        else
+                            synthTypes.push_back( type );
+                    }
+                    catch ( std::exception & )
+                    {
+                        fprintf(stderr, "'%s' is not a valid ScalarType "
+                                "- ignored. ('" EXECNAME " -h' for help.)\n", name.c_str());
+                    }
+                }
+            }
+                break;
+            case 'J':               /* Gap scan at save time */
+            {
+                double  period;
+                if ( epicsScanDouble( optarg, &period ) != 1 || period <= 0.0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid update period "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                }
+                else
+                    gapScanPeriod = period;
+            }
+                break;
             case 'm':               /* Monitor mode */
                 monitor = true;
                 break;
@@ -653,6 +1836,22 @@ int MAIN (int argc, char *argv[])
             }
         }
 
+        if ( !serverAddress.empty() && queueSizeMin > 0 )
+        {
+            // pvImpair never acks the pipelined updates it drops, so the -Q pipeline would stall
+            fprintf(stderr,
+                    "Option '-a' can't be used w/ '-Q'. ('" EXECNAME " -h' for help.)\n");
+            return 1;
+        }
+
+        try {
+            (void) clientPath( pvFilename, 0 );
+            (void) clientPath( testDirPath, 0 );
+        } catch(std::runtime_error& e) {
+            fprintf(stderr, "%s. ('" EXECNAME " -h' for help.)\n", e.what());
+            return 1;
+        }
+
         if(monitor)
             timeout = -1;
 
@@ -667,37 +1866,76 @@ int MAIN (int argc, char *argv[])
             return 1;
         }
 
-        if ( pvFilename.size() > 0 )
+        // Each logical client gets its own PV list and output dir
+        // Command line pvNames go to every client
+        size_t  nClient = nClients ? nClients : 1;
+        std::vector<std::string>    clientDirs;
+        for ( size_t iClient = 0; iClient < nClient; iClient++ )
         {
-            try
+            std::vector<std::string>    clientPVs;
+            if ( pvFilename.size() > 0 )
+                readPVList( clientPath( pvFilename, iClient ), clientPVs );
+            for(int i = optind; i < argc; i++)
             {
-                std::ifstream   fin( pvFilename.c_str() );
-                std::string     line;
-                if ( !fin.is_open() )
-                    std::cout << "Unable to open " << pvFilename << std::endl;
-                else
-                {
-                    while ( getline( fin, line ) )
-                    {
-                        pvnamewidth = std::max(pvnamewidth, line.size());
-                        pvList.push_back( line );
-                    }
-                    fin.close();
-                }
+                pvnamewidth = std::max(pvnamewidth, strlen(argv[i]));
+                clientPVs.push_back( argv[i] );
             }
-            catch( std::exception & e )
+            clientDirs.push_back( clientPath( testDirPath, iClient ) );
+            for ( size_t i = 0; i < clientPVs.size(); i++ )
             {
-                std::cerr << "Error: " << e.what() << "\n";
+                pvList.push_back( clientPVs[i] );
+                pvClient.push_back( iClient );
             }
         }
 
-        for(int i = optind; i < argc; i++)
+        if ( nSubscribers > 1 )
+            pvnamewidth += 5;   // Room for [n] subscriber tag in reports
+
+        // -p pva,ca compares providers, each PV is subscribed once per provider
         {
-            pvnamewidth = std::max(pvnamewidth, strlen(argv[i]));
-            pvList.push_back( argv[i] );
+            std::istringstream  providerList( defaultProvider );
+            std::string         name;
+            size_t              nameWidth = 0;
+            while ( getline( providerList, name, ',' ) )
+            {
+                if ( name.empty() )
+                    continue;
+                providerNames.push_back( name );
+                nameWidth = std::max( nameWidth, name.size() );
+            }
+            if ( providerNames.empty() )
+                providerNames.push_back( "pva" );
+            pathLabels = providerNames;
+
+            // -g adds a gateway path for the same provider
+            if ( gatewayStandInPort && gatewayAddrList.empty() )
+            {
+                std::ostringstream  addr;
+                addr << "127.0.0.1:" << gatewayStandInPort + 1;
+                gatewayAddrList = addr.str();
+            }
+            if ( !gatewayAddrList.empty() )
+            {
+                if ( providerNames.size() > 1 )
+                    std::cerr << "Dual path (-g) uses only provider " << providerNames[0] << std::endl;
+                providerNames.assign( 2, providerNames[0] );
+                pathLabels.clear();
+                pathLabels.push_back( "direct" );
+                pathLabels.push_back( "gw" );
+                nameWidth = 6;
+            }
+            if ( providerNames.size() > 1 )
+                pvnamewidth += nameWidth + 1;   // Room for @provider tag in reports
         }
+        const size_t    nProtocols  = providerNames.size();
 
         // Everything up to here is just related to handling cmd line arguments
+        if ( synthUpdates )
+        {
+            Tracker::prepare(); // install signal handler
+            runSynthetic( pvList, pvRequest );
+            return 0;
+        }
     {   // Create and run PVA clients for pvNames in argv[argc]
         // Configure logging
         SET_LOG_LEVEL(debugFlag ? epics::pvAccess::logLevelDebug : epics::pvAccess::logLevelError);
@@ -706,23 +1944,128 @@ int MAIN (int argc, char *argv[])
 
         {
 		std::vector<std::tr1::shared_ptr<MonTracker> > tracked;
-		pvac::ClientProvider provider(defaultProvider);
+		// Each ClientProvider is its own client context w/ its own TCP connections
+		// and receive threads, so PVs hashed to different contexts decode in parallel
+		// Each logical client gets nContexts of them per provider name,
+		// client i, provider p uses [(i*nProtocols+p)*nContexts, (i*nProtocols+p+1)*nContexts)
+		// The gateway path only searches the gateway address list
+		std::vector<epics::pvAccess::Configuration::shared_pointer>	pathConfs( nProtocols );
+		if ( !gatewayAddrList.empty() )
+			pathConfs[1] = epics::pvAccess::ConfigurationBuilder()
+							.push_env()
+							.add( "EPICS_PVA_ADDR_LIST", gatewayAddrList )
+							.add( "EPICS_PVA_AUTO_ADDR_LIST", "NO" )
+							.push_map()
+							.build();
+		std::vector<pvac::ClientProvider>	providers;
+		for ( size_t k = 0; k < nClient * nProtocols * nContexts; k++ )
+		{
+			size_t	iPath	= ( k / nContexts ) % nProtocols;
+			providers.push_back( pvac::ClientProvider( providerNames[iPath], pathConfs[iPath] ) );
+		}
+		std::vector<size_t>	contextOf;	// provider context index for each tracked PV
+		std::vector<size_t>	clientOf;	// logical client for each tracked PV
+		std::vector<size_t>	protocolOf;	// providerNames index for each tracked PV
+
+		// Latency across all PVs, per provider
+		std::vector<std::tr1::shared_ptr<pvHistogram> >	protocolLatency;
+		for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+			protocolLatency.push_back( std::tr1::shared_ptr<pvHistogram>( new pvHistogram( pathLabels[iProto] + " latency" ) ) );
 
 		epics::auto_ptr<WorkQueue> Q;
-		Q.reset(new WorkQueue);
+		Q.reset(new WorkQueue( nWorkerThreads ));
+
+		epics::auto_ptr<GwStandIn> gwStandIn;
+		if ( gatewayStandInPort )
+			gwStandIn.reset( new GwStandIn( gatewayStandInPort, pvList, pvRequest ) );
 
-		for ( std::vector<std::string>::const_iterator it = pvList.begin(); it != pvList.end(); ++it )
+		Tracker::prepare(); // install signal handler
+
+		// Paced startup: at most createRate channels/sec and maxSearches unconnected PVs
+		// Absolute schedule, so a wait on maxSearches doesn't lower the rate afterwards
+		const epicsUInt64	tStartup	= epicsMonotonicGet();
+		double				tNext		= 0.0;
+		std::list<std::tr1::shared_ptr<MonTracker> >	searching;
+		std::cout << "pvCapture: Launching MonTrackers for " << pvList.size() << " PVs";
+		if ( nClients )
+			std::cout << " in " << nClients << " clients";
+		if ( nProtocols > 1 )
+			std::cout << " over " << ( gatewayAddrList.empty() ? defaultProvider : "direct and gateway paths" );
+		std::cout << std::endl;
+		for ( std::vector<std::string>::const_iterator it = pvList.begin(); it != pvList.end() && !Tracker::abort; ++it )
 		{
-			std::cout << "pvCapture: Launching MonTracker for " << *it << std::endl;
-			pvac::ClientChannel chan( provider.connect(*it) );
+			size_t	iClient	= pvClient[ it - pvList.begin() ];
+			while ( !Tracker::abort )
+			{
+				double	tNow	= ( epicsMonotonicGet() - tStartup ) * 1.0e-9;
+				for ( std::list<std::tr1::shared_ptr<MonTracker> >::iterator itS = searching.begin(); itS != searching.end(); )
+				{
+					if ( (*itS)->isConnected() || tNow - ( (*itS)->m_tCreate - tStartup ) * 1.0e-9 > searchTimeout )
+						itS = searching.erase( itS );
+					else
+						++itS;
+				}
+				if ( maxSearches && searching.size() >= maxSearches )
+				{
+					connectEvt.wait( 0.1 );
+					continue;
+				}
+				if ( createRate > 0.0 && tNext > tNow )
+				{
+					epicsThreadSleep( tNext - tNow );
+					continue;
+				}
+				break;
+			}
+			if ( Tracker::abort )
+				break;
 
-			std::tr1::shared_ptr<MonTracker> mon(new MonTracker(*Q, chan, pvRequest, testDirPath.c_str(), fShow));
+			if ( debugFlag )
+				std::cout << "pvCapture: Launching MonTracker for " << *it << std::endl;
+			for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+			{
+			size_t	context	= ( iClient * nProtocols + iProto ) * nContexts + pvNameHash( *it ) % nContexts;
+			pvac::ClientChannel::Options	chanOptions;
+			if ( iProto == 0 )
+				chanOptions.address = serverAddress;
+			pvac::ClientChannel chan( providers[context].connect( *it, chanOptions ) );
+			std::string	protocol( nProtocols > 1 ? pathLabels[iProto] : std::string() );
+
+			std::tr1::shared_ptr<MonTracker> mon(new MonTracker(*Q, chan, pvRequest, clientDirs[iClient].c_str(), fShow, queueSizeMin, 0, protocol));
+			if ( nProtocols > 1 )
+				mon->m_latencyHist = protocolLatency[iProto];
+			mon->m_fRxTimes = !gatewayAddrList.empty();
+			mon->start();
 
 			tracked.push_back(mon);
+			contextOf.push_back(context);
+			clientOf.push_back(iClient);
+			protocolOf.push_back(iProto);
+			if ( maxSearches )
+				searching.push_back(mon);
+
+			// Fan-out subscribers, each w/ its own monitor or fed by mon's decode
+			for ( size_t iSub = 1; iSub < nSubscribers; iSub++ )
+			{
+				std::tr1::shared_ptr<MonTracker> sub(new MonTracker(*Q, chan, pvRequest, clientDirs[iClient].c_str(), false,
+																	sharedDecode ? 0 : queueSizeMin, iSub, protocol));
+				if ( sharedDecode )
+					mon->addFollower( sub );
+				else
+					sub->start();
+				tracked.push_back(sub);
+				contextOf.push_back(context);
+				clientOf.push_back(iClient);
+				protocolOf.push_back(iProto);
+			}
+			}
+			if ( createRate > 0.0 )
+				tNext += 1.0 / createRate;
 		}
-
-
-		Tracker::prepare(); // install signal handler
+		searching.clear();
+		const epicsUInt64	tRunning	= epicsMonotonicGet();
+		std::cout << "pvCapture: Launched " << tracked.size() << " MonTrackers in "
+				  << ( tRunning - tStartup ) * 1.0e-9 << " sec" << std::endl;
         {
 			{
 
@@ -736,7 +2079,21 @@ int MAIN (int argc, char *argv[])
                 while(Tracker::inprog.size() && !Tracker::abort)
                 {
                     epicsGuardRelease<epicsMutex> U(G);
-                    if(timeout<=0)
+                    if(queueSizeMax > 0)
+                    {
+                        if(!Tracker::doneEvt.wait(adaptPeriod))
+                        {
+                            size_t  nChanged = 0;
+                            for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+                            {
+                                if ( (*it)->adaptQueueSize( adaptPeriod ) )
+                                    nChanged++;
+                            }
+                            if ( nChanged )
+                                std::cout << "Adjusted queueSize for " << nChanged << " PVs" << std::endl;
+                        }
+                    }
+                    else if(timeout<=0)
                     {
                         Tracker::doneEvt.wait();
                     }
@@ -756,11 +2113,305 @@ int MAIN (int argc, char *argv[])
                 // show final counts
                 refmon.current();
             }
+            // Loss report: Missed is from counter value diffs (loadServer counters only),
+            // Overruns are updates the server squashed due to a full monitor queue.
+            size_t  totalUpdates    = 0;
+            size_t  totalMissed     = 0;
+            size_t  totalOverruns   = 0;
+            size_t  totalConflated  = 0;
+            size_t  totalDropped    = 0;
+            std::cout << std::setw(pvnamewidth) << std::left << "PV"
+                      << std::right
+                      << " " << std::setw(10) << "Updates"
+                      << " " << std::setw(10) << "Missed"
+                      << " " << std::setw(10) << "Overruns"
+                      << " " << std::setw(10) << "OvrFields";
+            if ( overloadPolicy != OverloadLossless )
+                std::cout << " " << std::setw(10) << "Conflated"
+                          << " " << std::setw(10) << "Dropped";
+            if ( queueSizeMax > 0 )
+                std::cout << " " << std::setw(10) << "QueueSize"
+                          << " " << std::setw(10) << "Resubs";
+            std::cout << std::left << std::endl;
+            std::map<size_t, size_t>    queueSizeCounts;    // PV count for each final queueSize
+            for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+            {
+                (*it)->showStats( std::cout );
+                totalUpdates    += (*it)->m_nUpdates;
+                totalMissed     += (*it)->m_nMissed;
+                totalOverruns   += (*it)->m_nOverruns;
+                totalConflated  += (*it)->m_nConflated;
+                totalDropped    += (*it)->m_nDropped;
+                if ( (*it)->m_queueSize )
+                    queueSizeCounts[(*it)->m_queueSize]++;
+            }
+            for ( std::map<size_t, size_t>::iterator it = queueSizeCounts.begin(); it != queueSizeCounts.end(); ++it )
+                std::cout << "Final queueSize " << it->first << ": " << it->second << " PVs" << std::endl;
+
+            // Startup report: time from channel creation to connect and to first update
+            pvHistogram     connectTimes( "time to connect" );
+            pvHistogram     firstUpdateTimes( "time to first update" );
+            size_t          nNeverConnected = 0;
+            size_t          nNoUpdate       = 0;
+            for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+            {
+                if ( (*it)->m_fFollower )
+                    continue;
+                double  tConnect    = (*it)->timeToConnect();
+                double  tFirst      = (*it)->timeToFirstUpdate();
+                if ( tConnect < 0 )
+                {
+                    nNeverConnected++;
+                    if ( debugFlag )
+                        std::cout << (*it)->m_channel.name() << " never connected" << std::endl;
+                }
+                else
+                    connectTimes.add( tConnect );
+                if ( tFirst < 0 )
+                    nNoUpdate++;
+                else
+                    firstUpdateTimes.add( tFirst );
+            }
+            std::cout << "Startup: " << nNeverConnected << " PVs never connected, "
+                      << nNoUpdate << " PVs w/o updates" << std::endl;
+            connectTimes.show( std::cout, true );
+            firstUpdateTimes.show( std::cout );
+            if ( providers.size() > 1 )
+            {
+                // Per context throughput, to check receive load is spread evenly
+                double  elapsed = ( epicsMonotonicGet() - tRunning ) * 1.0e-9;
+                std::vector<size_t> contextPVs( providers.size(), 0 );
+                std::vector<size_t> contextUpdates( providers.size(), 0 );
+                for ( size_t i = 0; i < tracked.size(); i++ )
+                {
+                    contextPVs[contextOf[i]]++;
+                    contextUpdates[contextOf[i]] += tracked[i]->m_nUpdates;
+                }
+                std::cout << std::right << std::setw(10) << "Context"
+                          << " " << std::setw(10) << "PVs"
+                          << " " << std::setw(10) << "Updates"
+                          << " " << std::setw(12) << "Updates/sec" << std::left << std::endl;
+                for ( size_t k = 0; k < providers.size(); k++ )
+                    std::cout << std::right << std::setw(10) << k
+                              << " " << std::setw(10) << contextPVs[k]
+                              << " " << std::setw(10) << contextUpdates[k]
+                              << " " << std::setw(12) << std::fixed << std::setprecision(1)
+                              << ( elapsed > 0.0 ? contextUpdates[k] / elapsed : 0.0 ) << std::left << std::endl;
+            }
+            if ( nClients )
+            {
+                // Per client summary, same totals a separate pvCapture process would report
+                std::vector<size_t> clientPVs( nClient, 0 );
+                std::vector<size_t> clientUpdates( nClient, 0 );
+                std::vector<size_t> clientMissed( nClient, 0 );
+                std::vector<size_t> clientOverruns( nClient, 0 );
+                for ( size_t i = 0; i < tracked.size(); i++ )
+                {
+                    size_t  iClient = clientOf[i];
+                    clientPVs[iClient]++;
+                    clientUpdates[iClient]  += tracked[i]->m_nUpdates;
+                    clientMissed[iClient]   += tracked[i]->m_nMissed;
+                    clientOverruns[iClient] += tracked[i]->m_nOverruns;
+                }
+                std::cout << std::right << std::setw(10) << "Client"
+                          << " " << std::setw(10) << "PVs"
+                          << " " << std::setw(10) << "Updates"
+                          << " " << std::setw(10) << "Missed"
+                          << " " << std::setw(10) << "Overruns"
+                          << " " << std::left << "Dir" << std::endl;
+                for ( size_t iClient = 0; iClient < nClient; iClient++ )
+                    std::cout << std::right << std::setw(10) << iClient
+                              << " " << std::setw(10) << clientPVs[iClient]
+                              << " " << std::setw(10) << clientUpdates[iClient]
+                              << " " << std::setw(10) << clientMissed[iClient]
+                              << " " << std::setw(10) << clientOverruns[iClient]
+                              << " " << std::left << clientDirs[iClient] << std::endl;
+            }
+            if ( nProtocols > 1 )
+            {
+                // Provider comparison, one row per PV w/ each provider's series side by side.
+                // Missed counter values and server side overruns stay separate, the same
+                // squashed update of a counter PV shows in both.
+                // CPU is handler thread time per update, provider receive threads not included.
+                typedef std::map<std::pair<size_t, std::string>, std::vector<MonTracker *> >  compare_t;
+                compare_t   compare;
+                for ( size_t i = 0; i < tracked.size(); i++ )
+                {
+                    if ( tracked[i]->m_subscriber != 0 )
+                        continue;
+                    std::vector<MonTracker *> & row = compare[ std::make_pair( clientOf[i], tracked[i]->m_pvName ) ];
+                    row.resize( nProtocols, NULL );
+                    row[protocolOf[i]] = tracked[i].get();
+                }
+                std::cout << std::setw(pvnamewidth) << std::left << "PV" << std::right;
+                for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+                    std::cout << " " << std::setw(10) << ( pathLabels[iProto] + " Upd" )
+                              << " " << std::setw(10) << "Missed"
+                              << " " << std::setw(10) << "Overruns"
+                              << " " << std::setw(10) << "Lat(ms)"
+                              << " " << std::setw(10) << "CPU(us)";
+                for ( size_t iProto = 1; iProto < nProtocols; iProto++ )
+                    std::cout << " " << std::setw(10) << ( "d" + pathLabels[iProto] + " Miss" )
+                              << " " << std::setw(10) << "dOverruns"
+                              << " " << std::setw(10) << "dLat(ms)"
+                              << " " << std::setw(10) << "dCPU(us)";
+                std::cout << std::left << std::endl;
+
+                std::vector<size_t>         protoUpdates( nProtocols, 0 );
+                std::vector<size_t>         protoMissed( nProtocols, 0 );
+                std::vector<size_t>         protoOverruns( nProtocols, 0 );
+                std::vector<epicsUInt64>    protoCpuNs( nProtocols, 0 );
+                for ( compare_t::iterator it = compare.begin(); it != compare.end(); ++it )
+                {
+                    std::vector<double> missed( nProtocols, 0.0 );
+                    std::vector<double> overruns( nProtocols, 0.0 );
+                    std::vector<double> latency( nProtocols, 0.0 );
+                    std::vector<double> cpu( nProtocols, 0.0 );
+                    std::cout << std::setw(pvnamewidth) << std::left << it->first.second << std::right
+                              << std::fixed << std::setprecision(3);
+                    for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+                    {
+                        MonTracker  *   pMon    = it->second[iProto];
+                        if ( pMon == NULL )
+                        {
+                            std::cout << " " << std::setw(10) << "-" << " " << std::setw(10) << "-" << " " << std::setw(10) << "-"
+                                      << " " << std::setw(10) << "-" << " " << std::setw(10) << "-";
+                            continue;
+                        }
+                        missed[iProto]   = static_cast<double>( pMon->m_nMissed );
+                        overruns[iProto] = static_cast<double>( pMon->m_nOverruns );
+                        latency[iProto]  = pMon->m_nLatency ? pMon->m_latencySum / pMon->m_nLatency * 1e3 : 0.0;
+                        cpu[iProto]      = pMon->m_nUpdates ? pMon->m_cpuNs * 1e-3 / pMon->m_nUpdates : 0.0;
+                        protoUpdates[iProto]    += pMon->m_nUpdates;
+                        protoMissed[iProto]     += pMon->m_nMissed;
+                        protoOverruns[iProto]   += pMon->m_nOverruns;
+                        protoCpuNs[iProto]      += pMon->m_cpuNs;
+                        std::cout << " " << std::setw(10) << pMon->m_nUpdates
+                                  << " " << std::setw(10) << pMon->m_nMissed
+                                  << " " << std::setw(10) << pMon->m_nOverruns
+                                  << " " << std::setw(10) << latency[iProto]
+                                  << " " << std::setw(10) << cpu[iProto];
+                    }
+                    for ( size_t iProto = 1; iProto < nProtocols; iProto++ )
+                        std::cout << " " << std::setw(10) << std::setprecision(0) << missed[iProto] - missed[0]
+                                  << " " << std::setw(10) << overruns[iProto] - overruns[0]
+                                  << " " << std::setw(10) << std::setprecision(3) << latency[iProto] - latency[0]
+                                  << " " << std::setw(10) << cpu[iProto] - cpu[0];
+                    std::cout.unsetf( std::ios::fixed );
+                    std::cout << std::setprecision(6) << std::left << std::endl;
+                }
+                for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+                    std::cout << pathLabels[iProto] << ": " << protoUpdates[iProto] << " updates, "
+                              << protoMissed[iProto] << " missed, " << protoOverruns[iProto] << " overruns, "
+                              << ( protoUpdates[iProto] ? protoCpuNs[iProto] * 1e-3 / protoUpdates[iProto] : 0.0 )
+                              << " us CPU/update" << std::endl;
+                for ( size_t iProto = 0; iProto < nProtocols; iProto++ )
+                    protocolLatency[iProto]->show( std::cout, iProto == 0 );
+
+                if ( !gatewayAddrList.empty() )
+                {
+                    // Dual path: match gateway samples to direct samples by server timestamp.
+                    // Added latency is gateway minus direct receive time, both on our monotonic clock.
+                    // Losses only count samples w/in the timestamp range both paths cover.
+                    pvHistogram     addedLatency( "gw added latency" );
+                    size_t          totalMatched    = 0;
+                    size_t          totalGwLost     = 0;
+                    size_t          totalDirectLost = 0;
+                    std::cout << std::setw(pvnamewidth) << std::left << "PV" << std::right
+                              << " " << std::setw(10) << "Matched"
+                              << " " << std::setw(10) << "GwLost"
+                              << " " << std::setw(10) << "DirectLost"
+                              << " " << std::setw(10) << "p50(ms)"
+                              << " " << std::setw(10) << "p99(ms)"
+                              << " " << std::setw(10) << "Max(ms)" << std::left << std::endl;
+                    for ( compare_t::iterator it = compare.begin(); it != compare.end(); ++it )
+                    {
+                        if ( it->second[0] == NULL || it->second[1] == NULL )
+                            continue;
+                        MonTracker::rxTimes_t   direct;
+                        MonTracker::rxTimes_t   gw;
+                        {
+                            epicsGuard<epicsMutex> G(it->second[0]->queueLock);
+                            direct = it->second[0]->m_rxTimes;
+                        }
+                        {
+                            epicsGuard<epicsMutex> G(it->second[1]->queueLock);
+                            gw = it->second[1]->m_rxTimes;
+                        }
+                        size_t      nMatched    = 0;
+                        size_t      nGwLost     = 0;
+                        size_t      nDirectLost = 0;
+                        pvHistogram pvAdded;
+                        if ( !direct.empty() && !gw.empty() )
+                        {
+                            epicsUInt64 tsFrom  = std::max( direct.front().first, gw.front().first );
+                            epicsUInt64 tsTo    = std::min( direct.back().first,  gw.back().first );
+                            std::map<epicsUInt64, epicsUInt64>  directRx( direct.begin(), direct.end() );
+                            std::set<epicsUInt64>               gwKeys;
+                            for ( MonTracker::rxTimes_t::iterator itG = gw.begin(); itG != gw.end(); ++itG )
+                            {
+                                gwKeys.insert( itG->first );
+                                std::map<epicsUInt64, epicsUInt64>::iterator    itD = directRx.find( itG->first );
+                                if ( itD != directRx.end() )
+                                {
+                                    double  added   = ( static_cast<double>( itG->second ) - static_cast<double>( itD->second ) ) * 1.0e-9;
+                                    pvAdded.add( added );
+                                    addedLatency.add( added );
+                                    nMatched++;
+                                }
+                                else if ( itG->first >= tsFrom && itG->first <= tsTo )
+                                    nDirectLost++;
+                            }
+                            for ( MonTracker::rxTimes_t::iterator itD = direct.begin(); itD != direct.end(); ++itD )
+                            {
+                                if ( itD->first >= tsFrom && itD->first <= tsTo && gwKeys.count( itD->first ) == 0 )
+                                    nGwLost++;
+                            }
+                        }
+                        totalMatched    += nMatched;
+                        totalGwLost     += nGwLost;
+                        totalDirectLost += nDirectLost;
+                        std::cout << std::setw(pvnamewidth) << std::left << it->first.second << std::right
+                                  << " " << std::setw(10) << nMatched
+                                  << " " << std::setw(10) << nGwLost
+                                  << " " << std::setw(10) << nDirectLost
+                                  << std::fixed << std::setprecision(3)
+                                  << " " << std::setw(10) << pvAdded.percentile( 50.0 ) * 1e3
+                                  << " " << std::setw(10) << pvAdded.percentile( 99.0 ) * 1e3
+                                  << " " << std::setw(10) << pvAdded.max() * 1e3 << std::left << std::endl;
+                        std::cout.unsetf( std::ios::fixed );
+                        std::cout << std::setprecision(6);
+                    }
+                    std::cout << "Dual path: " << totalMatched << " matched, " << totalGwLost << " lost only on gateway path, "
+                              << totalDirectLost << " lost only on direct path" << std::endl;
+                    if ( gwStandIn.get() )
+                        std::cout << "Gateway stand-in forwarded " << gwStandIn->numForwarded() << " updates" << std::endl;
+                    addedLatency.show( std::cout, true );
+                }
+            }
+            std::cout << "Total: " << totalUpdates << " updates, " << totalMissed << " missed, "
+                      << totalOverruns << " overruns, WorkQueue max depth " << Q->getMaxDepth() << std::endl;
+            if ( overloadPolicy != OverloadLossless )
+            {
+                epicsGuard<epicsMutex> G(Q->mutex);
+                std::cout << "Overload: " << totalConflated << " updates conflated, " << totalDropped << " updates dropped, "
+                          << Q->nConflated << " events conflated, " << Q->nEvicted << " events evicted" << std::endl;
+            }
+
             std::cout << "Saving values for " << tracked.size() << " PVs" << std::endl;
             for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
             {
                 (*it)->saveValues();
             }
+            if ( gapScanPeriod > 0.0 )
+            {
+                // Only the PVs w/ exceptions, then the totals
+                std::vector<const pvGapScan *>  gapScans;
+                for ( std::vector<std::tr1::shared_ptr<MonTracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
+                    if ( (*it)->m_gapScan )
+                        gapScans.push_back( (*it)->m_gapScan.get() );
+                pvGapScan::showTotals( std::cout, gapScans, gapScanPeriod );
+            }
 
         }
         }
@@ -0,0 +1,337 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <epicsGetopt.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <pv/thread.h>
+#include <pv/pvAccess.h>
+
+#include "pvCaptureFile.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvCaptureConvert"
+#endif
+
+#define PV_CAPTURE_CONVERT_MAJOR_VERSION		0
+#define PV_CAPTURE_CONVERT_MINOR_VERSION		1
+#define PV_CAPTURE_CONVERT_MAINTENANCE_VERSION	0
+#define PV_CAPTURE_CONVERT_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool        debugFlag       = false;
+bool        toText          = false;    // Binary to text, -t, instead of text to binary
+bool        checkOnly       = false;    // Parse only, -c, write nothing
+bool        removeSource    = false;    // Remove the source once its copy reads back the same
+bool        overwrite       = false;    // Replace existing output files
+size_t      nThreads        = 0;        // Conversion threads, 0 for one per CPU
+
+/// One file to convert and how it went
+struct ConvertFile
+{
+    std::string     filePath;
+    size_t          numBytesIn;
+    size_t          numBytesOut;
+    size_t          numSamples;
+    bool            fSkipped;   // Output already exists
+    bool            fOk;
+
+    ConvertFile() : numBytesIn( 0 ), numBytesOut( 0 ), numSamples( 0 ), fSkipped( false ), fOk( false ) {}
+};
+
+std::vector<ConvertFile>    convertFiles;
+
+size_t fileSize( const std::string & filePath )
+{
+    struct stat     fileStat;
+    if ( stat( filePath.c_str(), &fileStat ) != 0 )
+        return 0;
+    return fileStat.st_size;
+}
+
+/// addFiles adds path, or the capture files under it if it's a directory
+void addFiles( const std::string & path )
+{
+    struct stat     fileStat;
+    if ( stat( path.c_str(), &fileStat ) != 0 || !S_ISDIR( fileStat.st_mode ) )
+    {
+        ConvertFile convertFile;
+        convertFile.filePath = path;
+        convertFiles.push_back( convertFile );
+        return;
+    }
+    DIR *   dir = opendir( path.c_str() );
+    if ( dir == NULL )
+    {
+        std::cerr << EXECNAME ": Unable to read directory " << path << std::endl;
+        return;
+    }
+    std::vector<std::string>    names;
+    for ( struct dirent * entry = readdir( dir ); entry != NULL; entry = readdir( dir ) )
+        if ( strcmp( entry->d_name, "." ) != 0 && strcmp( entry->d_name, ".." ) != 0 )
+            names.push_back( entry->d_name );
+    closedir( dir );
+    std::sort( names.begin(), names.end() );
+    for ( size_t i = 0; i < names.size(); i++ )
+    {
+        std::string     filePath( path + "/" + names[i] );
+        if ( stat( filePath.c_str(), &fileStat ) == 0 && S_ISDIR( fileStat.st_mode ) )
+            addFiles( filePath );
+        else if ( toText ? pvCaptureFile::isBinaryFileName( names[i] ) : pvCaptureFile::isCaptureFileName( names[i] ) )
+            addFiles( filePath );
+    }
+}
+
+/// convert reads one file and writes its copy in the other format
+void convert( ConvertFile & convertFile )
+{
+    pvCaptureFile   captureFile;
+    convertFile.numBytesIn  = fileSize( convertFile.filePath );
+    if ( captureFile.read( convertFile.filePath ) != 0 )
+        return;
+    convertFile.numSamples  = captureFile.getNumSamples();
+    if ( checkOnly )
+    {
+        convertFile.fOk = true;
+        return;
+    }
+
+    std::string     outPath( toText ? pvCaptureFile::textFileName( convertFile.filePath )
+                                    : pvCaptureFile::binaryFileName( convertFile.filePath ) );
+    if ( !overwrite && access( outPath.c_str(), F_OK ) == 0 )
+    {
+        if ( debugFlag )
+            std::cerr << EXECNAME ": " << outPath << " exists, skipped" << std::endl;
+        convertFile.fSkipped = true;
+        return;
+    }
+    int     status  = toText ? captureFile.writeText( outPath ) : captureFile.writeBinary( outPath );
+    if ( status != 0 )
+        return;
+    convertFile.numBytesOut = fileSize( outPath );
+    convertFile.fOk         = true;
+    if ( debugFlag )
+        std::cerr << EXECNAME ": " << convertFile.filePath << ": " << convertFile.numSamples << " samples to " << outPath << std::endl;
+
+    if ( removeSource )
+    {
+        pvCaptureFile   copyFile;
+        // Compare values bit for bit, nan != nan
+        if (    copyFile.read( outPath ) != 0
+            ||  copyFile.getTsKeys() != captureFile.getTsKeys()
+            ||  (   convertFile.numSamples
+                &&  memcmp( &copyFile.getValues()[0], &captureFile.getValues()[0], convertFile.numSamples * sizeof(double) ) != 0 ) )
+        {
+            std::cerr << EXECNAME ": " << outPath << " doesn't read back the same, kept " << convertFile.filePath << std::endl;
+            return;
+        }
+        if ( unlink( convertFile.filePath.c_str() ) != 0 )
+            std::cerr << EXECNAME ": Unable to remove " << convertFile.filePath << ", " << strerror( errno ) << std::endl;
+    }
+}
+
+// This could go to it's own cpp file and header
+/// ConvertWorker
+/// One thread of the pool, converts files until none are left
+struct ConvertWorker : public epicsThreadRunable
+{
+    static epicsMutex   c_lock;
+    static size_t       c_nextFile; // guarded by c_lock
+
+    virtual void run()
+    {
+        for ( ;; )
+        {
+            size_t  iFile;
+            {
+                epicsGuard<epicsMutex> G(c_lock);
+                if ( c_nextFile >= convertFiles.size() )
+                    break;
+                iFile = c_nextFile++;
+            }
+            convert( convertFiles[iFile] );
+        }
+    }
+};
+
+epicsMutex  ConvertWorker::c_lock;
+size_t      ConvertWorker::c_nextFile = 0;
+
+void usage (void)
+{
+    fprintf( stdout, "\nUsage: " EXECNAME " [options] <file or dir>...\n"
+    "\n"
+    "Converts the [ [ sec, nsec], value ] text files of pvCapture, caCapture and pvGet\n"
+    "to a compact binary form, about 16 bytes per sample, that pvCaptureFile readers such\n"
+    "as pvAnalyze and pvReplay load w/o parsing.  X.pvCapture is written to X.pvCaptureBin,\n"
+    "X.caCapture to X.caCaptureBin.  Directories are searched recursively.\n"
+    "Trailing commas, missing close brackets and cut off last lines are tolerated, so -t\n"
+    "also gives repaired, json compatible text files.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -t:                Convert binary files back to text\n"
+    "  -c:                Check: parse and count samples, write nothing\n"
+    "  -f:                Overwrite existing output files, default skips them\n"
+    "  -r:                Remove each source file once its copy reads back the same\n"
+    "  -j <n>:            Conversion threads, default is one per CPU\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -r /data/stressTests/2019\n\n" );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVtcfrj:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_CAPTURE_CONVERT_MAJOR_VERSION,
+                                PV_CAPTURE_CONVERT_MINOR_VERSION,
+                                PV_CAPTURE_CONVERT_MAINTENANCE_VERSION,
+                                PV_CAPTURE_CONVERT_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 't':
+            toText = true;
+            break;
+        case 'c':
+            checkOnly = true;
+            break;
+        case 'f':
+            overwrite = true;
+            break;
+        case 'r':
+            removeSource = true;
+            break;
+        case 'j':
+        {
+            unsigned int    count;
+            if ( sscanf( optarg, "%u", &count ) != 1 || count == 0 )
+                fprintf(stderr, "'%s' is not a valid thread count "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                nThreads = count;
+        }
+            break;
+        case 'd':               /* Debug output */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+    if ( optind >= argc )
+    {
+        fprintf(stderr, "No files to convert. ('" EXECNAME " -h' for help.)\n");
+        return 1;
+    }
+    for ( int i = optind; i < argc; i++ )
+        addFiles( argv[i] );
+    if ( nThreads == 0 )
+        nThreads = epicsThreadGetCPUs();
+    if ( nThreads > convertFiles.size() )
+        nThreads = std::max( convertFiles.size(), static_cast<size_t>( 1 ) );
+
+    // ========================== Convert on the pool
+
+    const epicsUInt64   tStart  = epicsMonotonicGet();
+    std::vector<ConvertWorker>  workers( nThreads );
+    std::vector<std::tr1::shared_ptr<pvd::Thread> >   threads;
+    for ( size_t i = 0; i < nThreads; i++ )
+        threads.push_back( std::tr1::shared_ptr<pvd::Thread>( new pvd::Thread( pvd::Thread::Config()
+                                                                .name( "pvCaptureConvert" )
+                                                                .autostart( true )
+                                                                .run( &workers[i] ) ) ) );
+    for ( size_t i = 0; i < threads.size(); i++ )
+        threads[i]->exitWait();
+    threads.clear();
+    const epicsUInt64   tEnd    = epicsMonotonicGet();
+
+    size_t  numOk = 0, numSkipped = 0, numFailed = 0, numSamples = 0, numBytesIn = 0, numBytesOut = 0;
+    for ( size_t i = 0; i < convertFiles.size(); i++ )
+    {
+        const ConvertFile & convertFile = convertFiles[i];
+        if ( convertFile.fSkipped )
+        {
+            numSkipped++;
+            continue;
+        }
+        if ( !convertFile.fOk )
+        {
+            numFailed++;
+            continue;
+        }
+        numOk++;
+        numSamples  += convertFile.numSamples;
+        numBytesIn  += convertFile.numBytesIn;
+        numBytesOut += convertFile.numBytesOut;
+    }
+    double  sec = ( tEnd - tStart ) * 1.0e-9;
+    std::cout << EXECNAME ": " << ( checkOnly ? "Checked " : "Converted " ) << numOk << " files, "
+              << numSamples << " samples, " << numBytesIn / 1.0e6 << " MB";
+    if ( !checkOnly )
+        std::cout << " to " << numBytesOut / 1.0e6 << " MB";
+    std::cout << " in " << sec << " sec, " << ( sec > 0.0 ? numBytesIn / 1.0e6 / sec : 0.0 ) << " MB/s on "
+              << nThreads << " threads";
+    if ( numSkipped )
+        std::cout << ", " << numSkipped << " skipped";
+    if ( numFailed )
+        std::cout << ", " << numFailed << " failed";
+    std::cout << std::endl;
+
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return numFailed ? 1 : 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,456 @@
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pvCaptureFile.h"
+
+namespace {
+
+const char *	captureExtensions[]	= { ".pvCaptureBin", ".caCaptureBin", ".pvCapture", ".caCapture", ".pvGet" };
+const size_t	nCaptureExtensions	= sizeof(captureExtensions) / sizeof(captureExtensions[0]);
+
+const char			binaryMagic[8]		= { 'p', 'v', 'C', 'a', 'p', 'B', 'i', 'n' };
+const epicsUInt32	binaryVersion		= 1;
+const epicsUInt32	binaryByteOrder		= 0x01020304;
+const size_t		binaryHeaderSize	= 24;
+
+/// Exact powers of ten, a decimal w/ up to 15 digits divided by one of these
+/// rounds the same as strtod
+const double	pow10[]	=
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const size_t	nPow10	= sizeof(pow10) / sizeof(pow10[0]);
+
+bool endsWith( const std::string & str, const std::string & suffix )
+{
+	return str.size() >= suffix.size() && str.compare( str.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+/// isBlank is isspace w/o the locale lookup, capture files are plain ASCII
+inline bool isBlank( char c )
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline void skipBlanks( const char *& p, const char * pEnd )
+{
+	while ( p < pEnd && isBlank( *p ) )
+		p++;
+}
+
+/// skipTo advances p past blanks and returns true if *p is c
+/// Mapped files aren't NUL terminated, so every scan stops at pEnd
+inline bool skipTo( const char *& p, const char * pEnd, char c )
+{
+	skipBlanks( p, pEnd );
+	if ( p == pEnd || *p != c )
+		return false;
+	p++;
+	return true;
+}
+
+/// parseUInt parses an unsigned decimal integer
+inline bool parseUInt( const char *& p, const char * pEnd, epicsUInt32 & value )
+{
+	skipBlanks( p, pEnd );
+	const char *	pStart	= p;
+	epicsUInt64		result	= 0;
+	while ( p < pEnd && *p >= '0' && *p <= '9' )
+		result = result * 10 + ( *p++ - '0' );
+	value = static_cast<epicsUInt32>( result );
+	return p != pStart;
+}
+
+/// parseDoubleSlow copies one number token to a NUL terminated buffer for strtod
+bool parseDoubleSlow( const char *& p, const char * pEnd, double & value )
+{
+	char	token[64];
+	size_t	nToken	= 0;
+	while ( p + nToken < pEnd && nToken < sizeof(token) - 1 && strchr( "0123456789+-.eEnNaAiIfFtTyY", p[nToken] ) != NULL )
+	{
+		token[nToken] = p[nToken];
+		nToken++;
+	}
+	token[nToken] = '\0';
+	char	*	pTokenEnd;
+	value = strtod( token, &pTokenEnd );
+	if ( pTokenEnd == token )
+		return false;
+	p += pTokenEnd - token;
+	return true;
+}
+
+/// parseDouble parses the plain and fixed point decimals nearly all capture
+/// files hold in one pass.  Exponents, nan, inf and more than 15 significant
+/// digits go to strtod.
+inline bool parseDouble( const char *& p, const char * pEnd, double & value )
+{
+	skipBlanks( p, pEnd );
+	const char *	q			= p;
+	bool			fNegative	= false;
+	if ( q < pEnd && ( *q == '-' || *q == '+' ) )
+		fNegative = ( *q++ == '-' );
+	epicsUInt64		mantissa	= 0;
+	size_t			nDigits		= 0;	// Significant digits
+	size_t			nFraction	= 0;	// Digits after the decimal point
+	bool			fDigits		= false;
+	for ( ; q < pEnd && *q >= '0' && *q <= '9'; q++ )
+	{
+		mantissa = mantissa * 10 + ( *q - '0' );
+		nDigits += ( mantissa != 0 );
+		fDigits = true;
+	}
+	if ( q < pEnd && *q == '.' )
+	{
+		// Trailing zeros, as in the std::fixed values of pvStorage, don't count
+		size_t		nZeros	= 0;
+		for ( q++; q < pEnd && *q >= '0' && *q <= '9'; q++ )
+		{
+			fDigits = true;
+			if ( *q == '0' )
+			{
+				nZeros++;
+				continue;
+			}
+			for ( ; nZeros; nZeros-- )
+			{
+				mantissa *= 10;
+				nDigits += ( mantissa != 0 );
+				nFraction++;
+			}
+			mantissa = mantissa * 10 + ( *q - '0' );
+			nDigits += ( mantissa != 0 );
+			nFraction++;
+		}
+	}
+	if (	!fDigits || nDigits > 15 || nFraction >= nPow10
+		||	( q < pEnd && !isBlank( *q ) && *q != ']' && *q != ',' ) )
+		return parseDoubleSlow( p, pEnd, value );
+	value = static_cast<double>( mantissa ) / pow10[nFraction];
+	if ( fNegative )
+		value = -value;
+	p = q;
+	return true;
+}
+
+/// parseSample parses the rest of one sample, [ sec, nsec], value ], after its open bracket
+inline bool parseSample( const char *& p, const char * pEnd, epicsUInt64 & tsKey, double & value )
+{
+	epicsUInt32	sec;
+	epicsUInt32	nsec;
+	if (	skipTo( p, pEnd, '[' )
+		&&	parseUInt( p, pEnd, sec )
+		&&	skipTo( p, pEnd, ',' )
+		&&	parseUInt( p, pEnd, nsec )
+		&&	skipTo( p, pEnd, ']' )
+		&&	skipTo( p, pEnd, ',' )
+		&&	parseDouble( p, pEnd, value )
+		&&	skipTo( p, pEnd, ']' ) )
+	{
+		tsKey = ( static_cast<epicsUInt64>( sec ) << 32 ) + nsec;
+		return true;
+	}
+	return false;
+}
+
+/// countLines counts newlines w/ memchr, which libc vectorizes
+size_t countLines( const char * p, const char * pEnd )
+{
+	size_t	numLines	= 0;
+	while ( p < pEnd && ( p = static_cast<const char *>( memchr( p, '\n', pEnd - p ) ) ) != NULL )
+	{
+		numLines++;
+		p++;
+	}
+	return numLines;
+}
+
+/// replaceFile renames tmpPath over filePath, so readers never see a partial file
+int replaceFile( const std::string & tmpPath, const std::string & filePath )
+{
+	if ( rename( tmpPath.c_str(), filePath.c_str() ) != 0 )
+	{
+		std::cerr << "pvCaptureFile: Unable to write " << filePath << ", " << strerror( errno ) << std::endl;
+		unlink( tmpPath.c_str() );
+		return 1;
+	}
+	return 0;
+}
+
+} // namespace
+
+int pvMappedFile::open( const std::string & filePath )
+{
+	close();
+	int		fd	= ::open( filePath.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return 1;
+	struct stat	fileStat;
+	if ( fstat( fd, &fileStat ) != 0 )
+	{
+		::close( fd );
+		return 1;
+	}
+	if ( fileStat.st_size > 0 )
+	{
+		void	*	pMap	= mmap( NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( pMap == MAP_FAILED )
+		{
+			::close( fd );
+			return 1;
+		}
+		// Parsers read front to back once
+		madvise( pMap, fileStat.st_size, MADV_SEQUENTIAL );
+		m_data	= static_cast<const char *>( pMap );
+		m_size	= fileStat.st_size;
+	}
+	// The mapping stays valid after the fd is closed
+	::close( fd );
+	return 0;
+}
+
+void pvMappedFile::close( )
+{
+	if ( m_data )
+		munmap( const_cast<char *>( m_data ), m_size );
+	m_data	= NULL;
+	m_size	= 0;
+}
+
+std::string pvCaptureFile::pvNameFromPath( const std::string & filePath )
+{
+	std::string		pvName( filePath );
+	size_t			slash	= pvName.rfind( '/' );
+	if ( slash != std::string::npos )
+		pvName.erase( 0, slash + 1 );
+	for ( size_t i = 0; i < nCaptureExtensions; i++ )
+	{
+		if ( endsWith( pvName, captureExtensions[i] ) )
+		{
+			pvName.erase( pvName.size() - std::string( captureExtensions[i] ).size() );
+			break;
+		}
+	}
+	return pvName;
+}
+
+bool pvCaptureFile::isCaptureFileName( const std::string & fileName )
+{
+	return endsWith( fileName, ".pvCapture" ) || endsWith( fileName, ".caCapture" );
+}
+
+bool pvCaptureFile::isBinaryFileName( const std::string & fileName )
+{
+	return endsWith( fileName, ".pvCaptureBin" ) || endsWith( fileName, ".caCaptureBin" );
+}
+
+std::string pvCaptureFile::binaryFileName( const std::string & filePath )
+{
+	if ( isCaptureFileName( filePath ) )
+		return filePath + "Bin";
+	// pvGet and pvCollector files have no extension
+	std::string		binaryPath( filePath );
+	if ( endsWith( binaryPath, ".pvGet" ) )
+		binaryPath.erase( binaryPath.size() - 6 );
+	return binaryPath + ".pvCaptureBin";
+}
+
+std::string pvCaptureFile::textFileName( const std::string & filePath )
+{
+	if ( isBinaryFileName( filePath ) )
+		return filePath.substr( 0, filePath.size() - 3 );
+	return filePath + ".pvCapture";
+}
+
+int pvCaptureFile::read( const std::string & filePath )
+{
+	m_filePath	= filePath;
+	m_pvName	= pvNameFromPath( filePath );
+	m_tsKeys.clear();
+	m_values.clear();
+	m_numLines	= 0;
+
+	pvMappedFile	mappedFile;
+	if ( mappedFile.open( filePath ) != 0 )
+	{
+		std::cerr << "pvCaptureFile: Unable to open " << filePath << ", " << strerror( errno ) << std::endl;
+		return 1;
+	}
+	return parse( mappedFile.begin(), mappedFile.end(), filePath );
+}
+
+int pvCaptureFile::parse( const char * pBegin, const char * pEnd, const std::string & filePath )
+{
+	if ( !filePath.empty() )
+	{
+		m_filePath	= filePath;
+		m_pvName	= pvNameFromPath( filePath );
+	}
+	m_tsKeys.clear();
+	m_values.clear();
+	m_numLines	= 0;
+	if ( static_cast<size_t>( pEnd - pBegin ) >= sizeof(binaryMagic) && memcmp( pBegin, binaryMagic, sizeof(binaryMagic) ) == 0 )
+		return parseBinary( pBegin, pEnd );
+	return parseText( pBegin, pEnd );
+}
+
+int pvCaptureFile::parseText( const char * pBegin, const char * pEnd )
+{
+	m_numLines	= countLines( pBegin, pEnd );
+	// One sample per line, minus the brackets
+	if ( m_numLines > 2 )
+	{
+		m_tsKeys.reserve( m_numLines - 2 );
+		m_values.reserve( m_numLines - 2 );
+	}
+
+	const char	*	p	= pBegin;
+	if ( !skipTo( p, pEnd, '[' ) )
+	{
+		std::cerr << "pvCaptureFile: " << m_filePath << " is not a capture file" << std::endl;
+		return 1;
+	}
+	for ( ;; )
+	{
+		// A close bracket, or the end of a truncated file, ends the list
+		if ( !skipTo( p, pEnd, '[' ) )
+			break;
+		epicsUInt64	tsKey;
+		double		value;
+		if ( !parseSample( p, pEnd, tsKey, value ) )
+		{
+			if ( p == pEnd )
+			{
+				// Cut off mid sample by a crash or a full disk
+				std::cerr << "pvCaptureFile: " << m_filePath << ": Ignored the partial last sample after "
+						  << m_tsKeys.size() << " samples" << std::endl;
+				return 0;
+			}
+			std::cerr << "pvCaptureFile: " << m_filePath << ": Parse error after " << m_tsKeys.size()
+					  << " samples at offset " << ( p - pBegin ) << std::endl;
+			return 1;
+		}
+		m_tsKeys.push_back( tsKey );
+		m_values.push_back( value );
+		if ( !skipTo( p, pEnd, ',' ) )
+			break;
+	}
+	skipBlanks( p, pEnd );
+	if ( p < pEnd && *p != ']' )
+	{
+		std::cerr << "pvCaptureFile: " << m_filePath << ": Unexpected text after " << m_tsKeys.size()
+				  << " samples at offset " << ( p - pBegin ) << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int pvCaptureFile::parseBinary( const char * pBegin, const char * pEnd )
+{
+	size_t		size		= pEnd - pBegin;
+	epicsUInt32	version		= 0;
+	epicsUInt32	byteOrder	= 0;
+	epicsUInt64	numSamples	= 0;
+	if ( size >= binaryHeaderSize )
+	{
+		memcpy( &version,		pBegin + 8,  sizeof(version) );
+		memcpy( &byteOrder,		pBegin + 12, sizeof(byteOrder) );
+		memcpy( &numSamples,	pBegin + 16, sizeof(numSamples) );
+	}
+	if ( size < binaryHeaderSize || version != binaryVersion || byteOrder != binaryByteOrder )
+	{
+		std::cerr << "pvCaptureFile: " << m_filePath << ": Unsupported binary capture file version or byte order" << std::endl;
+		return 1;
+	}
+	size_t		sampleSize	= sizeof(epicsUInt64) + sizeof(double);
+	if ( numSamples > ( size - binaryHeaderSize ) / sampleSize )
+	{
+		std::cerr << "pvCaptureFile: " << m_filePath << ": Binary capture file cut off, "
+				  << numSamples << " samples expected" << std::endl;
+		return 1;
+	}
+	const char	*	pTsKeys	= pBegin + binaryHeaderSize;
+	const char	*	pValues	= pTsKeys + numSamples * sizeof(epicsUInt64);
+	m_tsKeys.resize( numSamples );
+	m_values.resize( numSamples );
+	if ( numSamples )
+	{
+		memcpy( &m_tsKeys[0], pTsKeys, numSamples * sizeof(epicsUInt64) );
+		memcpy( &m_values[0], pValues, numSamples * sizeof(double) );
+	}
+	return 0;
+}
+
+int pvCaptureFile::writeText( const std::string & filePath ) const
+{
+	std::string		tmpPath( filePath + ".tmp" );
+	std::ofstream	fout( tmpPath.c_str() );
+	// Same layout as MonTracker::saveValues, w/o a trailing comma so the file parses as json
+	fout << "[";
+	char	line[128];
+	char	number[32];
+	for ( size_t i = 0; i < m_tsKeys.size(); i++ )
+	{
+		// Shortest of %.15g or %.17g that reads back the same value
+		snprintf( number, sizeof(number), "%.15g", m_values[i] );
+		if ( strtod( number, NULL ) != m_values[i] && m_values[i] == m_values[i] )
+			snprintf( number, sizeof(number), "%.17g", m_values[i] );
+		int		nLine	= snprintf( line, sizeof(line), "%s\n    [ [ %u, %u], %s ]", ( i ? "," : "" ),
+									static_cast<unsigned>( m_tsKeys[i] >> 32 ),
+									static_cast<unsigned>( m_tsKeys[i] & 0xFFFFFFFF ), number );
+		fout.write( line, nLine );
+	}
+	fout << std::endl << "]" << std::endl;
+	fout.close();
+	if ( !fout )
+	{
+		std::cerr << "pvCaptureFile: Unable to write " << tmpPath << ", " << strerror( errno ) << std::endl;
+		unlink( tmpPath.c_str() );
+		return 1;
+	}
+	return replaceFile( tmpPath, filePath );
+}
+
+int pvCaptureFile::writeBinary( const std::string & filePath ) const
+{
+	std::string		tmpPath( filePath + ".tmp" );
+	std::ofstream	fout( tmpPath.c_str(), std::ios::out | std::ios::binary );
+	epicsUInt64		numSamples	= m_tsKeys.size();
+	fout.write( binaryMagic, sizeof(binaryMagic) );
+	fout.write( reinterpret_cast<const char *>( &binaryVersion ), sizeof(binaryVersion) );
+	fout.write( reinterpret_cast<const char *>( &binaryByteOrder ), sizeof(binaryByteOrder) );
+	fout.write( reinterpret_cast<const char *>( &numSamples ), sizeof(numSamples) );
+	if ( numSamples )
+	{
+		fout.write( reinterpret_cast<const char *>( &m_tsKeys[0] ), numSamples * sizeof(epicsUInt64) );
+		fout.write( reinterpret_cast<const char *>( &m_values[0] ), numSamples * sizeof(double) );
+	}
+	fout.close();
+	if ( !fout )
+	{
+		std::cerr << "pvCaptureFile: Unable to write " << tmpPath << ", " << strerror( errno ) << std::endl;
+		unlink( tmpPath.c_str() );
+		return 1;
+	}
+	return replaceFile( tmpPath, filePath );
+}
+
+void pvCaptureFile::getSamples( std::vector<pvCaptureSample> & samples ) const
+{
+	samples.resize( m_tsKeys.size() );
+	for ( size_t i = 0; i < m_tsKeys.size(); i++ )
+	{
+		samples[i].sec		= static_cast<epicsUInt32>( m_tsKeys[i] >> 32 );
+		samples[i].nsec		= static_cast<epicsUInt32>( m_tsKeys[i] );
+		samples[i].value	= m_values[i];
+	}
+}
@@ -0,0 +1,169 @@
+#ifndef PVCAPTUREFILE_H
+#define PVCAPTUREFILE_H
+
+#include <vector>
+#include <string>
+
+#include <epicsTypes.h>
+
+/// pvCaptureSample
+/// One timestamped value from a capture file
+struct pvCaptureSample
+{
+	epicsUInt32		sec;		// POSIX seconds, as in a pvData timeStamp.secondsPastEpoch
+	epicsUInt32		nsec;
+	double			value;
+
+	/// tsKey packs the timestamp in one sortable integer, same as pvGet's tsKey
+	epicsUInt64 tsKey( ) const
+	{
+		return ( static_cast<epicsUInt64>( sec ) << 32 ) + nsec;
+	}
+	bool operator<( const pvCaptureSample & other ) const
+	{
+		return tsKey() < other.tsKey();
+	}
+};
+
+/// pvMappedFile
+/// Read only memory map of a whole file, unmapped when destroyed
+class pvMappedFile
+{
+public:		// Public member functions
+	pvMappedFile( )
+		:	m_data( NULL )
+		,	m_size( 0 )
+	{
+	}
+	~pvMappedFile( )
+	{
+		close();
+	}
+
+	/// open maps filePath, returns 0 on success.  An empty file maps to an empty range.
+	int open( const std::string & filePath );
+	void close( );
+
+	const char * begin( ) const
+	{
+		return m_data;
+	}
+	const char * end( ) const
+	{
+		return m_data + m_size;
+	}
+	size_t size( ) const
+	{
+		return m_size;
+	}
+
+private:	// Private member variables
+	const char *	m_data;
+	size_t			m_size;
+
+	pvMappedFile( const pvMappedFile & );
+	pvMappedFile & operator=( const pvMappedFile & );
+};
+
+/// pvCaptureFile
+/// Reads the text files saved by pvCapture, caCapture and pvGet:
+///	[
+///	    [ [ sec, nsec], value ],
+///	    ...
+///	]
+/// Also accepts the trailing comma, missing close bracket and cut off last
+/// line of files written by older pvGet versions or cut short by a crash,
+/// the padded fixed point values of pvStorage::writeValues and the
+/// exponents of MonTracker::saveValues.
+///
+/// Samples are kept as two columns, tsKeys and values, in file order.
+/// writeBinary saves them in a compact binary form that read() and parse()
+/// recognize by its magic, 16 bytes per sample instead of ~40 as text:
+///	char		magic[8];		// "pvCapBin"
+///	epicsUInt32	version;		// 1
+///	epicsUInt32	byteOrder;		// 0x01020304 in the writer's byte order
+///	epicsUInt64	numSamples;
+///	epicsUInt64	tsKeys[numSamples];
+///	double		values[numSamples];
+///
+/// Timestamps are POSIX seconds in every file type, as in pvData timeStamps.
+/// caCapture converts its EPICS epoch DBR stamps before saving them.
+class pvCaptureFile
+{
+public:		// Public member functions
+	pvCaptureFile( )
+		:	m_numLines( 0 )
+	{
+	}
+
+	/// read all samples from filePath, text or binary, returns 0 on success
+	int read( const std::string & filePath );
+
+	/// parse all samples from the text or binary file contents in [pBegin, pEnd), returns 0 on success
+	/// filePath, if given, names the file for messages as for read()
+	int parse( const char * pBegin, const char * pEnd, const std::string & filePath = std::string() );
+
+	/// writeText writes the samples as a json compatible text capture file, returns 0 on success
+	int writeText( const std::string & filePath ) const;
+
+	/// writeBinary writes the samples as a binary capture file, returns 0 on success
+	int writeBinary( const std::string & filePath ) const;
+
+	const std::string & getPVName( ) const
+	{
+		return m_pvName;
+	}
+	const std::string & getFilePath( ) const
+	{
+		return m_filePath;
+	}
+	size_t getNumSamples( ) const
+	{
+		return m_tsKeys.size();
+	}
+	const std::vector<epicsUInt64> & getTsKeys( ) const
+	{
+		return m_tsKeys;
+	}
+	const std::vector<double> & getValues( ) const
+	{
+		return m_values;
+	}
+	/// getSamples copies the columns to samples, for callers that sort or merge rows
+	void getSamples( std::vector<pvCaptureSample> & samples ) const;
+
+	/// getNumLines returns the number of text lines in the last file read, 0 for binary files
+	size_t getNumLines( ) const
+	{
+		return m_numLines;
+	}
+
+public:		// Public class functions
+	/// pvNameFromPath strips the directory and any capture file extension
+	static std::string pvNameFromPath( const std::string & filePath );
+
+	/// isCaptureFileName is true for names ending in .pvCapture or .caCapture
+	static bool isCaptureFileName( const std::string & fileName );
+
+	/// isBinaryFileName is true for names ending in .pvCaptureBin or .caCaptureBin
+	static bool isBinaryFileName( const std::string & fileName );
+
+	/// binaryFileName returns the binary file name for a text capture file, ex. X.pvCapture to X.pvCaptureBin
+	static std::string binaryFileName( const std::string & filePath );
+
+	/// textFileName returns the text file name for a binary capture file, ex. X.pvCaptureBin to X.pvCapture
+	static std::string textFileName( const std::string & filePath );
+
+private:	// Private member functions
+	int		parseText( const char * pBegin, const char * pEnd );
+	int		parseBinary( const char * pBegin, const char * pEnd );
+
+private:	// Private member variables
+	std::string					m_filePath;
+	std::string					m_pvName;
+	std::vector<epicsUInt64>	m_tsKeys;
+	std::vector<double>			m_values;
+	size_t						m_numLines;
+};
+
+#endif // PVCAPTUREFILE_H
@@ -45,10 +45,20 @@ public:		// Public member functions
 		return 0;
 	}
 
-#if 0
-	/// getEvents
-	int getEvents( std::map< epicsUInt64, T > & events, epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() ) const;
-#endif
+	/// getNumEvents returns the number of saved values w/ tsKey in [from, to]
+	virtual size_t getNumEvents( epicsUInt64 /*from*/ = 0, epicsUInt64 /*to*/ = std::numeric_limits<epicsUInt64>::max() )
+	{
+		return 0;
+	}
+
+	/// getTsKeyRange gets the first and last tsKey in [from, to]
+	/// Returns false if there are none.
+	/// Typed access to the values is via pvStorage<T>::View and pvStorage<T>::getEvents
+	virtual bool getTsKeyRange( epicsUInt64 & /*first*/, epicsUInt64 & /*last*/,
+								epicsUInt64 /*from*/ = 0, epicsUInt64 /*to*/ = std::numeric_limits<epicsUInt64>::max() )
+	{
+		return false;
+	}
 
 public:	// Public class functions
     static size_t	getMaxEvents();
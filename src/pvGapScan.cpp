@@ -0,0 +1,221 @@
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+#include "pvGapScan.h"
+
+namespace {
+
+/// Inter-arrival times go to the histogram in batches, one lock per batch
+const size_t	c_batchSize	= 256;
+
+} // namespace
+
+pvGapScan::pvGapScan( const std::string & name, const Config & config )
+	:	m_name( name )
+	,	m_config( config )
+	,	m_lateNs( std::numeric_limits<epicsInt64>::max() )
+	,	m_earlyNs( -1 )
+	,	m_fPrior( false )
+	,	m_priorNs( 0 )
+	,	m_priorValue( 0.0 )
+	,	m_numSamples( 0 )
+	,	m_numSteps( 0 )
+	,	m_numMissed( 0 )
+	,	m_numBackwards( 0 )
+	,	m_numLate( 0 )
+	,	m_numEarly( 0 )
+	,	m_numJitter( 0 )
+	,	m_sumJitter2( 0.0 )
+	,	m_maxJitter( 0.0 )
+	,	m_interArrival( name )
+{
+	if ( m_config.period > 0.0 )
+	{
+		m_lateNs	= static_cast<epicsInt64>( m_config.late  * m_config.period * 1.0e9 );
+		m_earlyNs	= static_cast<epicsInt64>( m_config.early * m_config.period * 1.0e9 );
+	}
+}
+
+void pvGapScan::scan( const epicsUInt64 * tsKeys, const double * values, size_t count )
+{
+	// The per sample state lives in locals, so the loop keeps it in registers
+	double			dts[c_batchSize];
+	size_t			nDts		= 0;
+	const double	period		= m_config.period;
+	const epicsInt64	lateNs	= m_lateNs;
+	const epicsInt64	earlyNs	= m_earlyNs;
+	bool			fPrior		= m_fPrior;
+	epicsUInt64		priorNs		= m_priorNs;
+	double			priorValue	= m_priorValue;
+	epicsUInt64		numJitter	= 0;
+	double			sumJitter2	= 0.0;
+	double			maxJitter	= m_maxJitter;
+	for ( size_t i = 0; i < count; i++ )
+	{
+		epicsUInt64	ns		= ( tsKeys[i] >> 32 ) * 1000000000u + ( tsKeys[i] & 0xFFFFFFFF );
+		double		value	= values[i];
+		if ( fPrior )
+		{
+			epicsInt64	dtNs	= static_cast<epicsInt64>( ns - priorNs );
+			double		step	= value - priorValue;
+			// One combined test per sample, the exception paths are rare
+			if ( step != 1.0 || dtNs < 0 || dtNs > lateNs || dtNs < earlyNs )
+			{
+				size_t	index	= static_cast<size_t>( m_numSamples ) + i;
+				// nan steps, from a disconnect, are neither a step nor a miss
+				if ( step != 1.0 && step == step )
+				{
+					m_numSteps++;
+					if ( step > 1.0 )
+						m_numMissed += static_cast<epicsUInt64>( step - 1.0 );
+					m_steps[step]++;
+					addException( index, CounterStep, tsKeys[i], step );
+				}
+				if ( dtNs < 0 )
+				{
+					m_numBackwards++;
+					addException( index, TimeBackwards, tsKeys[i], dtNs * 1.0e-9 );
+				}
+				else if ( dtNs > lateNs )
+				{
+					m_numLate++;
+					addException( index, LateArrival, tsKeys[i], dtNs * 1.0e-9 );
+				}
+				else if ( dtNs < earlyNs )
+				{
+					m_numEarly++;
+					addException( index, EarlyArrival, tsKeys[i], dtNs * 1.0e-9 );
+				}
+			}
+			if ( dtNs >= 0 )
+			{
+				double	dt	= dtNs * 1.0e-9;
+				dts[nDts++]	= dt;
+				if ( period > 0.0 )
+				{
+					double	jitter	= std::fabs( dt - period );
+					sumJitter2	+= jitter * jitter;
+					numJitter++;
+					if ( jitter > maxJitter )
+						maxJitter = jitter;
+				}
+				if ( nDts == c_batchSize )
+				{
+					m_interArrival.add( dts, nDts );
+					nDts = 0;
+				}
+			}
+		}
+		fPrior		= true;
+		priorNs		= ns;
+		priorValue	= value;
+	}
+	if ( nDts )
+		m_interArrival.add( dts, nDts );
+	m_fPrior		= fPrior;
+	m_priorNs		= priorNs;
+	m_priorValue	= priorValue;
+	m_numSamples	+= count;
+	m_numJitter		+= numJitter;
+	m_sumJitter2	+= sumJitter2;
+	m_maxJitter		= maxJitter;
+}
+
+void pvGapScan::addException( size_t index, ExceptionType type, epicsUInt64 tsKey, double delta )
+{
+	if ( m_exceptions.size() >= m_config.maxExceptions )
+		return;
+	Exception	exception;
+	exception.index	= index;
+	exception.type	= type;
+	exception.tsKey	= tsKey;
+	exception.delta	= delta;
+	m_exceptions.push_back( exception );
+}
+
+double pvGapScan::getJitter( ) const
+{
+	return m_numJitter ? std::sqrt( m_sumJitter2 / m_numJitter ) : 0.0;
+}
+
+const char * pvGapScan::exceptionName( ExceptionType type )
+{
+	switch ( type )
+	{
+	case CounterStep:	return "step";
+	case TimeBackwards:	return "backwards";
+	case LateArrival:	return "late";
+	case EarlyArrival:	return "early";
+	}
+	return "unknown";
+}
+
+void pvGapScan::show( std::ostream & out, bool fHeader ) const
+{
+	if ( fHeader )
+		out	<< std::left << std::setw(24) << "Gap scan" << std::right
+			<< " " << std::setw(10) << "Samples"
+			<< " " << std::setw(8) << "Steps"
+			<< " " << std::setw(8) << "Missed"
+			<< " " << std::setw(9) << "Backwards"
+			<< " " << std::setw(8) << "Late"
+			<< " " << std::setw(8) << "Early"
+			<< " " << std::setw(10) << "Jitter ms"
+			<< " " << std::setw(10) << "p50 ms"
+			<< " " << std::setw(10) << "p99 ms"
+			<< " " << std::setw(10) << "Max ms" << std::endl;
+	std::ios::fmtflags	flags( out.flags() );
+	out	<< std::left << std::setw(24) << m_name << std::right
+		<< " " << std::setw(10) << m_numSamples
+		<< " " << std::setw(8) << m_numSteps
+		<< " " << std::setw(8) << m_numMissed
+		<< " " << std::setw(9) << m_numBackwards
+		<< " " << std::setw(8) << m_numLate
+		<< " " << std::setw(8) << m_numEarly
+		<< std::fixed << std::setprecision(3)
+		<< " " << std::setw(10) << getJitter() * 1e3
+		<< " " << std::setw(10) << m_interArrival.percentile( 50.0 ) * 1e3
+		<< " " << std::setw(10) << m_interArrival.percentile( 99.0 ) * 1e3
+		<< " " << std::setw(10) << m_interArrival.max() * 1e3 << std::endl;
+	out.flags( flags );
+}
+
+void pvGapScan::showExceptions( std::ostream & out ) const
+{
+	std::ios::fmtflags	flags( out.flags() );
+	for ( size_t i = 0; i < m_exceptions.size(); i++ )
+	{
+		const Exception &	exception	= m_exceptions[i];
+		out	<< std::setw(10) << exception.index
+			<< " " << std::setw(9) << exceptionName( exception.type )
+			<< " [ " << ( exception.tsKey >> 32 ) << ", " << std::setw(9) << ( exception.tsKey & 0xFFFFFFFF ) << "]"
+			<< " " << exception.delta << std::endl;
+	}
+	epicsUInt64	numExceptions	= getNumExceptions();
+	if ( numExceptions > m_exceptions.size() )
+		out << "First " << m_exceptions.size() << " of " << numExceptions << " exceptions listed" << std::endl;
+	out.flags( flags );
+}
+
+void pvGapScan::showTotals( std::ostream & out, const std::vector<const pvGapScan *> & scans,
+							double period, bool fShowAll )
+{
+	epicsUInt64	numSteps = 0, numMissed = 0, numBackwards = 0, numLate = 0, numEarly = 0;
+	bool		fHeader	= true;
+	for ( size_t i = 0; i < scans.size(); i++ )
+	{
+		const pvGapScan	*	scan	= scans[i];
+		numSteps		+= scan->getNumSteps();
+		numMissed		+= scan->getNumMissed();
+		numBackwards	+= scan->getNumBackwards();
+		numLate			+= scan->getNumLate();
+		numEarly		+= scan->getNumEarly();
+		if ( scan->getNumExceptions() == 0 && !fShowAll )
+			continue;
+		scan->show( out, fHeader );
+		fHeader = false;
+	}
+	out	<< "Gap scan: " << numSteps << " counter steps, " << numMissed << " missed, " << numBackwards << " backwards, "
+		<< numLate << " late, " << numEarly << " early vs a " << period * 1e3 << " ms period" << std::endl;
+}
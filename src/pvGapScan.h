@@ -0,0 +1,176 @@
+#ifndef PVGAPSCAN_H
+#define PVGAPSCAN_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include <epicsTypes.h>
+
+#include "pvHistogram.h"
+
+/// pvGapScan
+/// Batch scan of one PV's captured counter series, in arrival order, over
+/// contiguous tsKey and value columns.  One pass finds:
+///	Counter steps other than +1: missed updates, repeats and resets
+///	Timestamps earlier than the prior one
+///	Inter-arrival times over late or under early times the nominal update
+///	period, ex. $TEST_COUNTER_DELAY
+/// All are counted and the first maxExceptions are listed w/ their sample index.
+/// Inter-arrival times go to a pvHistogram and non unit counter steps to a
+/// step histogram.  Scanning a series in several calls gives the same result
+/// as one call.  Not thread safe, one scan per PV.
+class pvGapScan
+{
+public:		// Public types
+	enum ExceptionType
+	{
+		CounterStep,		// Counter changed by other than +1
+		TimeBackwards,		// Timestamp earlier than the prior one
+		LateArrival,		// Inter-arrival time over late * period
+		EarlyArrival		// Inter-arrival time under early * period
+	};
+
+	struct Exception
+	{
+		size_t			index;		// Sample index in the series
+		ExceptionType	type;
+		epicsUInt64		tsKey;
+		double			delta;		// Counter step, or inter-arrival seconds
+	};
+
+	struct Config
+	{
+		double			period;			// Nominal seconds between updates, 0 skips the arrival checks
+		double			late;			// Late threshold, multiple of period
+		double			early;			// Early threshold, multiple of period
+		size_t			maxExceptions;	// Exceptions listed, all are counted
+
+		Config()
+			:	period( 0.0 )
+			,	late( 2.0 )
+			,	early( 0.5 )
+			,	maxExceptions( 1000 )
+		{
+		}
+	};
+
+public:		// Public member functions
+	explicit pvGapScan( const std::string & name, const Config & config = Config() );
+
+	/// scan the next count samples of the series
+	void scan( const epicsUInt64 * tsKeys, const double * values, size_t count );
+	void scan( const std::vector<epicsUInt64> & tsKeys, const std::vector<double> & values )
+	{
+		if ( !tsKeys.empty() )
+			scan( &tsKeys[0], &values[0], tsKeys.size() );
+	}
+
+	/// endSeries forgets the last sample, so the next scan starts a new series
+	/// w/o a step or inter-arrival time across the break
+	void endSeries( )
+	{
+		m_fPrior = false;
+	}
+
+	const std::string & getName( ) const
+	{
+		return m_name;
+	}
+	epicsUInt64 getNumSamples( ) const
+	{
+		return m_numSamples;
+	}
+	/// getNumSteps returns the number of counter steps other than +1
+	epicsUInt64 getNumSteps( ) const
+	{
+		return m_numSteps;
+	}
+	/// getNumMissed returns the counter values skipped by steps over +1
+	epicsUInt64 getNumMissed( ) const
+	{
+		return m_numMissed;
+	}
+	epicsUInt64 getNumBackwards( ) const
+	{
+		return m_numBackwards;
+	}
+	epicsUInt64 getNumLate( ) const
+	{
+		return m_numLate;
+	}
+	epicsUInt64 getNumEarly( ) const
+	{
+		return m_numEarly;
+	}
+	/// getNumExceptions returns the number of exceptions of all types, listed or not
+	epicsUInt64 getNumExceptions( ) const
+	{
+		return m_numSteps + m_numBackwards + m_numLate + m_numEarly;
+	}
+	/// getJitter returns the rms difference between inter-arrival times and the period, in seconds
+	double getJitter( ) const;
+
+	/// getMaxJitter returns the largest difference between an inter-arrival time and the period, in seconds
+	double getMaxJitter( ) const
+	{
+		return m_maxJitter;
+	}
+	const pvHistogram & getInterArrival( ) const
+	{
+		return m_interArrival;
+	}
+	/// getSteps returns the count of each counter step other than +1
+	const std::map<double, epicsUInt64> & getSteps( ) const
+	{
+		return m_steps;
+	}
+	const std::vector<Exception> & getExceptions( ) const
+	{
+		return m_exceptions;
+	}
+
+	/// show one line of counts, w/ optional header
+	void show( std::ostream & out, bool fHeader = false ) const;
+
+	/// showExceptions lists the exceptions, one per line
+	void showExceptions( std::ostream & out ) const;
+
+public:		// Public class functions
+	static const char * exceptionName( ExceptionType type );
+
+	/// showTotals shows the scans w/ exceptions, or all w/ fShowAll, one line each,
+	/// then one line of totals over all scans vs the nominal period
+	static void showTotals( std::ostream & out, const std::vector<const pvGapScan *> & scans,
+							double period, bool fShowAll = false );
+
+private:	// Private member functions
+	void	addException( size_t index, ExceptionType type, epicsUInt64 tsKey, double delta );
+
+private:	// Private member variables
+	std::string						m_name;
+	Config							m_config;
+	epicsInt64						m_lateNs;		// Thresholds in ns, so the scan compares integers
+	epicsInt64						m_earlyNs;
+	bool							m_fPrior;
+	epicsUInt64						m_priorNs;
+	double							m_priorValue;
+	epicsUInt64						m_numSamples;
+	epicsUInt64						m_numSteps;
+	epicsUInt64						m_numMissed;
+	epicsUInt64						m_numBackwards;
+	epicsUInt64						m_numLate;
+	epicsUInt64						m_numEarly;
+	epicsUInt64						m_numJitter;
+	double							m_sumJitter2;
+	double							m_maxJitter;
+	pvHistogram						m_interArrival;
+	std::map<double, epicsUInt64>	m_steps;
+	std::vector<Exception>			m_exceptions;
+
+	pvGapScan( const pvGapScan & );
+	pvGapScan & operator=( const pvGapScan & );
+};
+
+#endif // PVGAPSCAN_H
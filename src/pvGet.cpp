@@ -16,6 +16,8 @@
 #include <math.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include <epicsStdlib.h>
@@ -43,6 +45,7 @@
 
 #include "pvCollector.h"
 #include "pvStorage.h"
+#include "pvHistogram.h"
 
 #define USE_SIGNAL
 #ifndef EXECNAME
@@ -70,6 +73,29 @@ int verbosity   = 0;
 std::string request("");
 std::string defaultProvider("pva");
 
+// Open-loop load generator settings, see -L, -A, -I and -T
+double      loadRate        = 0.0;      // Aggregate gets/sec, 0 selects the closed-loop -R mode
+bool        loadPoisson     = false;    // Poisson inter-arrival times instead of fixed
+size_t      maxInFlightPV   = 1;        // Max outstanding gets per PV
+size_t      maxInFlight     = 1000;     // Max outstanding gets for this process
+double      loadDuration    = 10.0;     // Seconds of offered load, <= 0 runs until SIGINT
+
+// Capacity search settings, see -K and -Y
+double      searchStartRate = 0.0;      // First gets/sec tried, 0 to disable
+double      searchMaxRate   = 1.0e6;    // Highest gets/sec tried
+double      searchResolution = 0.05;    // Stop bisecting within this fraction of the failing rate
+size_t      searchMaxSteps  = 30;
+double      sloLoss         = 0.001;    // Max fraction of gets lost or timed out
+double      sloP99          = 0.1;      // Max p99 get latency, sec
+double      kneeFactor      = 2.0;      // Knee is where p99 reaches this times its low load value
+
+// Keep channels connected across -R cycles, see -k
+bool        keepChannels    = false;
+
+// Channel churn generator settings, see -X and -J
+double      churnRate       = 0.0;      // Channels created and destroyed per sec, 0 to disable
+size_t      maxConnects     = 1000;     // Max churn channels in flight
+
 inline epicsUInt64	secNsec2tsKey( epicsUInt32	secPastEpoch, epicsUInt32	nsec )
 {
 	return (epicsUInt64(secPastEpoch) << 32) + nsec;
@@ -153,8 +179,17 @@ struct Tracker
         epicsGuard<epicsMutex> G(doneLock);
         inprog.insert(this);
     }
+
+    bool isInProgress()
+    {
+        epicsGuard<epicsMutex> G(doneLock);
+        return inprog.find(this) != inprog.end();
+    }
 	virtual void restart( pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest ) = 0;
 
+	/// cycle tears down the channel, then connects and gets again
+	virtual void cycle( pvac::ClientProvider& provider, const pvd::PVStructurePtr& pvRequest ) = 0;
+
     virtual void writeValues( const std::string & testDirPath ) = 0;
 
 	/// getName( const std::string & name )
@@ -217,8 +252,20 @@ void usage (void)
             "  -f <input file>:   Read pvName list from file, one line per pvName.\n"
             "  -D <dirpath>:      Directory path where captured values are saved to <dirpath>/<pvname>.\n"
             "  -S:                Show each PV as it's acquired, same output options as pvmonitor.\n"
-            "  -R <delay>:        Repeat w/ delay.  Not applicable for monitor mode.\n"
+            "  -R <period>:       Repeat each PV's get every <period> seconds, PV phases spread over the period.\n"
+            "                     Each cycle disconnects, reconnects and gets, timing each phase.\n"
+            "  -k:                Keep channels connected across -R cycles, reissuing gets on warm channels.\n"
             "  -C:                Capture each PV and save to a test file.\n"
+            "  -L <rate>:         Open-loop mode: offer <rate> gets/sec over all PVs, regardless of replies.\n"
+            "  -A <fixed|poisson>: Open-loop inter-arrival schedule.  default is 'fixed'\n"
+            "  -I <pv>[:<total>]: Open-loop max gets in flight per PV and per process.  default is 1:1000\n"
+            "  -X <rate>:         Churn mode: create, get and destroy <rate> channels/sec over all PVs.\n"
+            "  -J <max>:          Churn mode max channels in flight.  default is 1000\n"
+            "  -T <sec>:          Open-loop or churn duration, 0 runs until SIGINT.  default is 10 seconds\n"
+            "  -K <start>[:<max>]: Capacity search: step the open-loop rate from <start> gets/sec, doubling\n"
+            "                     until the SLO fails, then bisecting, for -T seconds per step.\n"
+            "                     Reports the max sustainable rate and the latency knee.\n"
+            "  -Y <loss%%>[:<p99 ms>]: Capacity search SLO.  default is 0.1:100\n"
             " Output details:\n"
             "  -v:                Show entire structure (implies Raw mode)\n" \
             "  -vv:               Get in Raw mode.     Highlight  valid fields, show all fields.\n"
@@ -312,6 +359,7 @@ struct WorkQueue : public epicsThreadRunable
 
 // From pvAccessCPP/pvtoolsSrc/pvget.cpp
 struct Getter : public pvac::ClientChannel::GetCallback,
+				public pvac::ClientChannel::ConnectCallback,
 #ifdef GETTER_BLOCK
 				public Worker,
 #endif
@@ -329,7 +377,24 @@ struct Getter : public pvac::ClientChannel::GetCallback,
     std::deque<t_TsReal>   	 	m_ValueQueue;
     epicsMutex      			m_QueueLock;
 	pvStorage<double>		*	m_pvCollector;
-	//pvac::ClientChannel			m_clientChannel;
+	pvac::ClientChannel			m_channel;
+
+	// Per cycle phase timing, epicsMonotonicGet() ns, guarded by m_timeLock
+	epicsMutex					m_timeLock;
+	epicsUInt64					m_tConnectStart;
+	epicsUInt64					m_tConnected;
+	epicsUInt64					m_tGetStart;
+	bool						m_connected;
+	size_t						m_nCycles;		// Cycles w/ a successful get
+	double						m_connectSum;
+	double						m_getSum;
+	double						m_teardownSum;
+	size_t						m_nConnects;
+	size_t						m_nTeardowns;
+
+	static pvHistogram			c_connectTime;
+	static pvHistogram			c_getTime;
+	static pvHistogram			c_teardownTime;
 
     Getter(WorkQueue& monwork, pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest, bool fCapture, bool fShow, double repeat )
 		:monwork(monwork)
@@ -339,8 +404,21 @@ struct Getter : public pvac::ClientChannel::GetCallback,
 		,m_Repeat( repeat )
         ,m_QueueSizeMax( 262144 )
 		,m_ValueQueue()
+		,m_pvCollector( NULL )
+		,m_channel( channel )
+		,m_tConnectStart( epicsMonotonicGet() )
+		,m_tConnected( 0 )
+		,m_tGetStart( m_tConnectStart )
+		,m_connected( false )
+		,m_nCycles( 0 )
+		,m_connectSum( 0.0 )
+		,m_getSum( 0.0 )
+		,m_teardownSum( 0.0 )
+		,m_nConnects( 0 )
+		,m_nTeardowns( 0 )
     {
 		setName( channel.name() );
+		m_channel.addConnectListener( this );
 #ifdef GETTER_BLOCK
 		monwork.push( shared_from_this(), pvRequest );
 #else
@@ -353,6 +431,7 @@ struct Getter : public pvac::ClientChannel::GetCallback,
         try {
 		std::cout << "~Getter: Cancel monitor of " << getName() << std::endl; 
         op.cancel();
+		m_channel.removeConnectListener( this );
         }
         catch(std::exception& e){
             std::cout << "Error in ~Getter: " << e.what() << "\n";
@@ -362,9 +441,99 @@ struct Getter : public pvac::ClientChannel::GetCallback,
 	void restart( pvac::ClientChannel& channel, const pvd::PVStructurePtr& pvRequest )
 	{
 		op.cancel();
+		{
+			epicsGuard<epicsMutex> G(m_timeLock);
+			m_tGetStart = epicsMonotonicGet();
+		}
+		restartTracker();
         op = channel.get(this, pvRequest);
 		setName( channel.name() );
-		restartTracker();
+	}
+
+	/// cycle times each phase of a connect, get, disconnect cycle
+	/// teardown: cancel the get, drop our channel and the provider's cached one
+	/// connect:  provider.connect() until our connectEvent(connected)
+	/// get:      channel.get(), or connect if later, until getDone(Success)
+	/// With keepChannels the get is reissued on the warm channel, no search or connect
+	void cycle( pvac::ClientProvider& provider, const pvd::PVStructurePtr& pvRequest )
+	{
+		if ( keepChannels )
+		{
+			restart( m_channel, pvRequest );
+			return;
+		}
+
+		epicsUInt64	tTeardown	= epicsMonotonicGet();
+		op.cancel();
+		m_channel.removeConnectListener( this );
+		m_channel = pvac::ClientChannel();
+		provider.disconnect( getName() );
+		epicsUInt64	tConnect	= epicsMonotonicGet();
+		double		teardown	= ( tConnect - tTeardown ) * 1.0e-9;
+		c_teardownTime.add( teardown );
+		{
+			epicsGuard<epicsMutex> G(m_timeLock);
+			m_teardownSum += teardown;
+			m_nTeardowns++;
+			m_tConnectStart	= tConnect;
+			m_connected		= false;
+		}
+
+		m_channel = provider.connect( getName() );
+		m_channel.addConnectListener( this );
+		restart( m_channel, pvRequest );
+	}
+
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+	{
+		epicsUInt64	tNow	= epicsMonotonicGet();
+		double		connect	= 0.0;
+		{
+			epicsGuard<epicsMutex> G(m_timeLock);
+			if ( !evt.connected )
+			{
+				m_connected = false;
+				return;
+			}
+			if ( m_connected )
+				return;
+			m_connected		= true;
+			m_tConnected	= tNow;
+			connect			= ( tNow - m_tConnectStart ) * 1.0e-9;
+			m_connectSum	+= connect;
+			m_nConnects++;
+		}
+		c_connectTime.add( connect );
+	}
+
+	/// Record the get round trip for a successful cycle
+	void getCompleted( )
+	{
+		epicsUInt64	tNow	= epicsMonotonicGet();
+		double		get		= 0.0;
+		{
+			epicsGuard<epicsMutex> G(m_timeLock);
+			// Gets issued before connect wait in pvac, time from whichever came last
+			epicsUInt64	tStart	= m_tGetStart;
+			if ( m_connected && m_tConnected > tStart )
+				tStart = m_tConnected;
+			get			= ( tNow - tStart ) * 1.0e-9;
+			m_getSum	+= get;
+			m_nCycles++;
+		}
+		c_getTime.add( get );
+	}
+
+	void showTiming( std::ostream & out )
+	{
+		epicsGuard<epicsMutex> G(m_timeLock);
+		out << std::setw(pvnamewidth) << std::left << getName() << std::right
+			<< " " << std::setw(10) << m_nCycles
+			<< std::fixed << std::setprecision(3)
+			<< " " << std::setw(10) << ( m_nConnects   ? m_connectSum  / m_nConnects   * 1e3 : 0.0 )
+			<< " " << std::setw(10) << ( m_nCycles     ? m_getSum      / m_nCycles     * 1e3 : 0.0 )
+			<< " " << std::setw(10) << ( m_nTeardowns  ? m_teardownSum / m_nTeardowns  * 1e3 : 0.0 )
+			<< std::endl;
 	}
 
 #ifdef GETTER_BLOCK
@@ -728,6 +897,7 @@ struct Getter : public pvac::ClientChannel::GetCallback,
         case pvac::GetEvent::Cancel:
             break;
         case pvac::GetEvent::Success: {
+			getCompleted();
 			if ( fCapture )
 			{
 				// Capture the new value
@@ -757,6 +927,890 @@ struct Getter : public pvac::ClientChannel::GetCallback,
 
 };
 
+pvHistogram	Getter::c_connectTime( "connect" );
+pvHistogram	Getter::c_getTime( "get RTT" );
+pvHistogram	Getter::c_teardownTime( "teardown" );
+
+/// LoadGetter issues gets on one channel for the open-loop load generator.
+/// Each outstanding get has its own Slot so a PV can have several in flight.
+/// Arrivals that find no free slot, or the process at maxInFlight, are
+/// counted as skipped rather than delayed, so the offered load stays fixed.
+struct LoadGetter
+{
+    struct Slot : public pvac::ClientChannel::GetCallback
+    {
+        LoadGetter      *   m_owner;
+        pvac::Operation     op;
+        epicsUInt64         m_tIssue;   // epicsMonotonicGet() when issued
+        bool                m_busy;     // guarded by c_lock
+
+        Slot() : m_owner(NULL), op(), m_tIssue(0), m_busy(false) {}
+        virtual ~Slot() {}
+        virtual void getDone(const pvac::GetEvent& event) OVERRIDE FINAL
+        {
+            m_owner->getDone( *this, event );
+        }
+    };
+
+    static epicsMutex       c_lock;     // guards slot state, counters and c_inFlight
+    static size_t           c_inFlight;
+    static size_t           c_nSkippedTotalCap;
+    static pvHistogram      c_latency;
+
+    pvac::ClientChannel     m_channel;
+    pvd::PVStructurePtr     m_pvRequest;
+    std::vector<Slot>       m_slots;    // Sized once, Slot addresses must not move
+    size_t                  m_nIssued;
+    size_t                  m_nSuccess;
+    size_t                  m_nFail;
+    size_t                  m_nTimeout;
+    size_t                  m_nSkipped; // Arrivals w/ all of this PV's slots busy
+    double                  m_maxLatency;
+
+    LoadGetter( const pvac::ClientChannel & channel, const pvd::PVStructurePtr & pvRequest, size_t nSlots )
+        :   m_channel( channel )
+        ,   m_pvRequest( pvRequest )
+        ,   m_slots( nSlots )
+        ,   m_nIssued( 0 )
+        ,   m_nSuccess( 0 )
+        ,   m_nFail( 0 )
+        ,   m_nTimeout( 0 )
+        ,   m_nSkipped( 0 )
+        ,   m_maxLatency( 0.0 )
+    {
+        for ( size_t i = 0; i < m_slots.size(); i++ )
+            m_slots[i].m_owner = this;
+    }
+
+    ~LoadGetter()
+    {
+        cancelAll();
+    }
+
+    /// issue starts a get in a free slot, returns false if the arrival was skipped
+    bool issue( )
+    {
+        Slot    *   pSlot   = NULL;
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( c_inFlight >= maxInFlight )
+            {
+                c_nSkippedTotalCap++;
+                return false;
+            }
+            for ( size_t i = 0; i < m_slots.size(); i++ )
+            {
+                if ( !m_slots[i].m_busy )
+                {
+                    pSlot = &m_slots[i];
+                    break;
+                }
+            }
+            if ( pSlot == NULL )
+            {
+                m_nSkipped++;
+                return false;
+            }
+            pSlot->m_busy   = true;
+            pSlot->m_tIssue = epicsMonotonicGet();
+            c_inFlight++;
+            m_nIssued++;
+        }
+
+        try {
+            pSlot->op = m_channel.get( pSlot, m_pvRequest );
+        }
+        catch(std::exception& e){
+            std::cerr << "Error issuing get on " << m_channel.name() << ": " << e.what() << "\n";
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( pSlot->m_busy )
+            {
+                pSlot->m_busy = false;
+                c_inFlight--;
+                m_nFail++;
+            }
+        }
+        return true;
+    }
+
+    /// getDone is called on a PVA thread when a slot's get completes
+    void getDone( Slot & slot, const pvac::GetEvent & event )
+    {
+        double  latency = ( epicsMonotonicGet() - slot.m_tIssue ) * 1.0e-9;
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( !slot.m_busy )
+                return;     // Already released by reap()
+            slot.m_busy = false;
+            c_inFlight--;
+            switch(event.event) {
+            case pvac::GetEvent::Success:
+                m_nSuccess++;
+                if ( latency > m_maxLatency )
+                    m_maxLatency = latency;
+                break;
+            case pvac::GetEvent::Fail:
+                m_nFail++;
+                break;
+            case pvac::GetEvent::Cancel:
+                m_nTimeout++;
+                break;
+            }
+        }
+        if ( event.event == pvac::GetEvent::Success )
+            c_latency.add( latency );
+        else if ( event.event == pvac::GetEvent::Fail )
+            LOG( epics::pvAccess::logLevelError, "%s: get failed, %s", m_channel.name().c_str(), event.message.c_str() );
+    }
+
+    /// reap cancels gets outstanding longer than maxAge seconds
+    void reap( double maxAge )
+    {
+        epicsUInt64 tNow    = epicsMonotonicGet();
+        for ( size_t i = 0; i < m_slots.size(); i++ )
+        {
+            Slot    &   slot    = m_slots[i];
+            {
+                epicsGuard<epicsMutex> G(c_lock);
+                if ( !slot.m_busy || ( tNow - slot.m_tIssue ) * 1.0e-9 < maxAge )
+                    continue;
+                slot.m_busy = false;
+                c_inFlight--;
+                m_nTimeout++;
+            }
+            // getDone ignores the Cancel event as the slot is no longer busy
+            slot.op.cancel();
+        }
+    }
+
+    void cancelAll( )
+    {
+        reap( 0.0 );
+    }
+
+    void showStats( std::ostream & out )
+    {
+        epicsGuard<epicsMutex> G(c_lock);
+        out << std::setw(pvnamewidth) << std::left << m_channel.name() << std::right
+            << " " << std::setw(10) << m_nIssued
+            << " " << std::setw(10) << m_nSuccess
+            << " " << std::setw(10) << m_nFail
+            << " " << std::setw(10) << m_nTimeout
+            << " " << std::setw(10) << m_nSkipped
+            << " " << std::setw(10) << std::fixed << std::setprecision(3) << m_maxLatency * 1e3
+            << std::endl;
+    }
+
+    EPICS_NOT_COPYABLE(LoadGetter)
+};
+
+epicsMutex  LoadGetter::c_lock;
+size_t      LoadGetter::c_inFlight          = 0;
+size_t      LoadGetter::c_nSkippedTotalCap  = 0;
+pvHistogram LoadGetter::c_latency( "get latency" );
+
+/// TimerWheel is a hashed timer wheel of absolute due times in ns.
+/// Entries hash by due tick into one of nSlots buckets, so scheduling
+/// and expiring are O(1) per entry regardless of how many PVs are tracked.
+/// Entries more than one revolution out stay in their bucket until their tick.
+struct TimerWheel
+{
+    struct Entry
+    {
+        size_t          id;
+        epicsUInt64     due;    // epicsMonotonicGet() ns
+    };
+    typedef std::vector<Entry>  bucket_t;
+
+    epicsUInt64             m_tickNs;
+    std::vector<bucket_t>   m_buckets;
+    epicsUInt64             m_curTick;  // Next tick to expire
+
+    TimerWheel( epicsUInt64 tickNs, size_t nSlots, epicsUInt64 tStart )
+        :   m_tickNs( tickNs )
+        ,   m_buckets( nSlots )
+        ,   m_curTick( tStart / tickNs )
+    {
+    }
+
+    void schedule( size_t id, epicsUInt64 due )
+    {
+        epicsUInt64 tick    = due / m_tickNs;
+        if ( tick < m_curTick )
+            tick = m_curTick;
+        Entry   entry;
+        entry.id    = id;
+        entry.due   = due;
+        m_buckets[ tick % m_buckets.size() ].push_back( entry );
+    }
+
+    /// Time in ns when the current tick has fully elapsed
+    epicsUInt64 nextExpiry( ) const
+    {
+        return ( m_curTick + 1 ) * m_tickNs;
+    }
+
+    /// expire appends all entries from ticks that ended by tNow and advances the wheel
+    void expire( epicsUInt64 tNow, std::vector<Entry> & expired )
+    {
+        while ( nextExpiry() <= tNow )
+        {
+            bucket_t    &   bucket  = m_buckets[ m_curTick % m_buckets.size() ];
+            for ( size_t i = 0; i < bucket.size(); )
+            {
+                if ( bucket[i].due / m_tickNs <= m_curTick )
+                {
+                    expired.push_back( bucket[i] );
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                }
+                else
+                    i++;
+            }
+            m_curTick++;
+        }
+    }
+};
+
+/// runRepeatSchedule restarts each Tracker every period seconds.
+/// Due times are absolute, tStart + phase + k * period, so cycle time never
+/// accumulates as drift, and PV phases are spread evenly across the period
+/// so the gets don't all hit the server in the same instant.
+/// A PV whose previous get is still in progress skips that cycle unless it
+/// has been outstanding longer than the timeout, in which case it is restarted.
+void runRepeatSchedule( pvac::ClientProvider & provider, std::vector<std::tr1::shared_ptr<Tracker> > & tracked,
+                        const pvd::PVStructurePtr & pvRequest, double period )
+{
+    const epicsUInt64   tickNs      = 1000000;  // 1ms
+    const size_t        nSlots      = 1024;
+    epicsUInt64         periodNs    = static_cast<epicsUInt64>( period * 1.0e9 );
+    if ( periodNs < tickNs )
+        periodNs = tickNs;
+    const epicsUInt64   tStart      = epicsMonotonicGet();
+    TimerWheel          wheel( tickNs, nSlots, tStart );
+    std::vector<epicsUInt64>    tIssued( tracked.size(), tStart );
+
+    for ( size_t i = 0; i < tracked.size(); i++ )
+        wheel.schedule( i, tStart + periodNs + i * periodNs / tracked.size() );
+
+    pvHistogram         lag( "schedule lag" );
+    size_t              nIssued     = 0;
+    size_t              nBusy       = 0;
+    size_t              nTimeout    = 0;
+    std::vector<TimerWheel::Entry>  expired;
+    while ( !Tracker::abort )
+    {
+        epicsUInt64 tNow    = epicsMonotonicGet();
+        if ( tNow < wheel.nextExpiry() )
+        {
+            epicsThreadSleep( ( wheel.nextExpiry() - tNow ) * 1.0e-9 );
+            continue;
+        }
+        expired.clear();
+        wheel.expire( tNow, expired );
+        for ( size_t i = 0; i < expired.size(); i++ )
+        {
+            size_t      id      = expired[i].id;
+            Tracker *   pTracker = tracked[id].get();
+            tNow = epicsMonotonicGet();
+            lag.add( ( tNow - expired[i].due ) * 1.0e-9 );
+            wheel.schedule( id, expired[i].due + periodNs );
+            if ( pTracker->isInProgress() )
+            {
+                if ( timeout <= 0 || ( tNow - tIssued[id] ) * 1.0e-9 < timeout )
+                {
+                    nBusy++;
+                    continue;
+                }
+                nTimeout++;
+                haderror = 1;
+                std::cerr << pTracker->getName() << " timed out after " << timeout << " sec, restarting" << std::endl;
+            }
+            pTracker->cycle( provider, pvRequest );
+            tIssued[id] = tNow;
+            nIssued++;
+        }
+    }
+
+    double  elapsed     = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+    size_t  nCycles     = 0;
+    if ( verbosity > 0 )
+        std::cout   << std::setw(pvnamewidth) << std::left << "PV" << std::right
+                    << " " << std::setw(10) << "Cycles"
+                    << " " << std::setw(10) << "ConnectMs"
+                    << " " << std::setw(10) << "GetMs"
+                    << " " << std::setw(10) << "TeardownMs" << std::endl;
+    for ( size_t i = 0; i < tracked.size(); i++ )
+    {
+        Getter  *   pGetter = dynamic_cast<Getter *>( tracked[i].get() );
+        if ( pGetter == NULL )
+            continue;
+        if ( verbosity > 0 )
+            pGetter->showTiming( std::cout );
+        epicsGuard<epicsMutex> G(pGetter->m_timeLock);
+        nCycles += pGetter->m_nCycles;
+    }
+
+    std::cout   << "Repeat: " << nIssued << " gets issued, " << nBusy << " cycles skipped w/ get in progress, "
+                << nTimeout << " timed out" << std::endl;
+    std::cout   << "Repeat: " << nCycles << " cycles in " << elapsed << " sec, "
+                << ( elapsed > 0.0 ? nCycles / elapsed : 0.0 ) << " cycles/sec on " << tracked.size()
+                << ( keepChannels ? " persistent" : " churned" ) << " channels" << std::endl;
+    lag.show( std::cout, true );
+    Getter::c_connectTime.show( std::cout );
+    Getter::c_getTime.show( std::cout );
+    Getter::c_teardownTime.show( std::cout );
+}
+
+/// ChurnSlot runs one connect, get, destroy churn operation at a time.
+/// Callbacks only update state and hand the slot back to the main thread,
+/// which owns all ClientChannel and Operation calls, so a slot can be
+/// cancelled or reused without racing a PVA thread.
+struct ChurnSlot : public pvac::ClientChannel::ConnectCallback,
+                   public pvac::ClientChannel::GetCallback
+{
+    enum state_t { Idle, Connecting, Connected, Getting, Finished };
+
+    static epicsMutex               c_lock;         // guards slot state and the lists below
+    static epicsEvent               c_wakeup;       // signaled when a slot changes state
+    static std::vector<ChurnSlot*>  c_connected;    // Connected, ready for a get
+    static std::vector<ChurnSlot*>  c_finished;     // Finished, ready for teardown
+    static pvHistogram              c_connectTime;
+    static pvHistogram              c_getTime;
+
+    state_t                 m_state;
+    bool                    m_success;
+    pvac::ClientChannel     m_channel;
+    pvac::Operation         op;
+    epicsUInt64             m_tStart;       // epicsMonotonicGet() ns
+    epicsUInt64             m_tGet;
+
+    ChurnSlot()
+        :   m_state( Idle )
+        ,   m_success( false )
+        ,   m_tStart( 0 )
+        ,   m_tGet( 0 )
+    {
+    }
+    virtual ~ChurnSlot() {}
+
+    /// start creates a new channel for pvName, main thread only
+    void start( pvac::ClientProvider & provider, const std::string & pvName )
+    {
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            m_state     = Connecting;
+            m_success   = false;
+            m_tStart    = epicsMonotonicGet();
+        }
+        m_channel = provider.connect( pvName );
+        // Drop it from the provider cache so the next connect searches again
+        provider.disconnect( pvName );
+        m_channel.addConnectListener( this );
+    }
+
+    /// issueGet on a connected channel, main thread only
+    void issueGet( const pvd::PVStructurePtr & pvRequest )
+    {
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( m_state != Connected )
+                return;
+            m_state = Getting;
+            m_tGet  = epicsMonotonicGet();
+        }
+        op = m_channel.get( this, pvRequest );
+    }
+
+    /// teardown cancels and destroys the channel, main thread only
+    void teardown( )
+    {
+        op.cancel();
+        if ( m_channel )
+            m_channel.removeConnectListener( this );
+        op          = pvac::Operation();
+        m_channel   = pvac::ClientChannel();
+        epicsGuard<epicsMutex> G(c_lock);
+        m_state = Idle;
+    }
+
+    /// finish marks the slot done and queues it for teardown, c_lock must be held
+    void finish( bool success )
+    {
+        m_state     = Finished;
+        m_success   = success;
+        c_finished.push_back( this );
+    }
+
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+    {
+        double  connect = 0.0;
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( m_state != Connecting || !evt.connected )
+                return;
+            m_state = Connected;
+            connect = ( epicsMonotonicGet() - m_tStart ) * 1.0e-9;
+            c_connected.push_back( this );
+        }
+        c_connectTime.add( connect );
+        c_wakeup.signal();
+    }
+
+    virtual void getDone(const pvac::GetEvent& event) OVERRIDE FINAL
+    {
+        double  get     = 0.0;
+        {
+            epicsGuard<epicsMutex> G(c_lock);
+            if ( m_state != Getting )
+                return;
+            get = ( epicsMonotonicGet() - m_tGet ) * 1.0e-9;
+            finish( event.event == pvac::GetEvent::Success );
+        }
+        if ( event.event == pvac::GetEvent::Success )
+            c_getTime.add( get );
+        else if ( event.event == pvac::GetEvent::Fail )
+            LOG( epics::pvAccess::logLevelError, "%s: churn get failed, %s", m_channel.name().c_str(), event.message.c_str() );
+        c_wakeup.signal();
+    }
+};
+
+epicsMutex              ChurnSlot::c_lock;
+epicsEvent              ChurnSlot::c_wakeup;
+std::vector<ChurnSlot*> ChurnSlot::c_connected;
+std::vector<ChurnSlot*> ChurnSlot::c_finished;
+pvHistogram             ChurnSlot::c_connectTime( "churn connect" );
+pvHistogram             ChurnSlot::c_getTime( "churn get" );
+
+/// runChurn creates, gets and destroys churnRate channels/sec round robin over pvList,
+/// w/ at most maxConnects in flight.  Replaces a shell loop forking pvget per PV.
+int runChurn( pvac::ClientProvider & provider, const std::vector<std::string> & pvList,
+              const pvd::PVStructurePtr & pvRequest )
+{
+    std::vector<ChurnSlot>  slots( maxConnects );   // Sized once, slot addresses must not move
+    std::vector<ChurnSlot*> idle;
+    for ( size_t i = 0; i < slots.size(); i++ )
+        idle.push_back( &slots[i] );
+
+    Tracker::prepare(); // install signal handler
+
+    std::cout   << "Churn: " << churnRate << " channels/sec over " << pvList.size() << " PVs, "
+                << maxConnects << " in flight max" << std::endl;
+
+    const epicsUInt64   tStart      = epicsMonotonicGet();
+    const double        interval    = 1.0 / churnRate;
+    double              tNext       = 0.0;      // Seconds from tStart of next channel
+    double              tReap       = 0.1;
+    double              tNow        = 0.0;
+    size_t              iPV         = 0;
+    size_t              nStarted    = 0;
+    size_t              nSkipped    = 0;
+    size_t              nSuccess    = 0;
+    size_t              nFail       = 0;
+    size_t              nConnectTimeout = 0;
+    size_t              nGetTimeout = 0;
+    std::vector<ChurnSlot*> connected;
+    std::vector<ChurnSlot*> finished;
+    bool                fOffering   = true;
+    while ( !Tracker::abort )
+    {
+        tNow = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+        if ( fOffering && loadDuration > 0.0 && tNext >= loadDuration )
+            fOffering = false;
+        if ( !fOffering && idle.size() == slots.size() )
+            break;
+        if ( !fOffering && tNow >= loadDuration + ( timeout > 0.0 ? timeout : 1.0 ) )
+            break;
+
+        {
+            epicsGuard<epicsMutex> G(ChurnSlot::c_lock);
+            connected.swap( ChurnSlot::c_connected );
+            finished.swap( ChurnSlot::c_finished );
+        }
+        for ( size_t i = 0; i < connected.size(); i++ )
+            connected[i]->issueGet( pvRequest );
+        connected.clear();
+        for ( size_t i = 0; i < finished.size(); i++ )
+        {
+            if ( finished[i]->m_success )
+                nSuccess++;
+            else
+                nFail++;
+            finished[i]->teardown();
+            idle.push_back( finished[i] );
+        }
+        finished.clear();
+
+        if ( tNow >= tReap && timeout > 0.0 )
+        {
+            // Destroy channels that didn't connect or reply in time
+            epicsUInt64 tNs = epicsMonotonicGet();
+            for ( size_t i = 0; i < slots.size(); i++ )
+            {
+                ChurnSlot   &   slot    = slots[i];
+                {
+                    epicsGuard<epicsMutex> G(ChurnSlot::c_lock);
+                    if ( slot.m_state == ChurnSlot::Idle || slot.m_state == ChurnSlot::Finished )
+                        continue;
+                    // A get times out from when it was issued, so a slow connect doesn't count against it
+                    epicsUInt64 tSince  = slot.m_state == ChurnSlot::Getting ? slot.m_tGet : slot.m_tStart;
+                    if ( ( tNs - tSince ) * 1.0e-9 < timeout )
+                        continue;
+                    if ( slot.m_state == ChurnSlot::Getting )
+                        nGetTimeout++;
+                    else
+                        nConnectTimeout++;
+                    // Connected slots are still on the connected list, leave them for issueGet to skip
+                    slot.m_state = ChurnSlot::Finished;
+                }
+                slot.teardown();
+                idle.push_back( &slot );
+            }
+            tReap = tNow + 0.1;
+        }
+
+        if ( fOffering && tNext <= tNow )
+        {
+            if ( idle.empty() )
+                nSkipped++;
+            else
+            {
+                ChurnSlot   *   pSlot   = idle.back();
+                idle.pop_back();
+                pSlot->start( provider, pvList[iPV] );
+                nStarted++;
+            }
+            iPV = ( iPV + 1 ) % pvList.size();
+            tNext += interval;
+            continue;
+        }
+
+        double  tWait = fOffering ? tNext - tNow : 0.01;
+        if ( tWait > 0.1 )
+            tWait = 0.1;
+        ChurnSlot::c_wakeup.wait( tWait );
+    }
+    double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+
+    for ( size_t i = 0; i < slots.size(); i++ )
+        slots[i].teardown();
+
+    std::cout   << "Churn: " << nStarted << " channels in " << elapsed << " sec, "
+                << ( elapsed > 0.0 ? nSuccess / elapsed : 0.0 ) << " successful cycles/sec" << std::endl;
+    std::cout   << "Churn: " << nSuccess << " success, " << nFail << " failed, "
+                << nConnectTimeout << " connect timeouts, " << nGetTimeout << " get timeouts, "
+                << nSkipped << " skipped at in-flight cap" << std::endl;
+    ChurnSlot::c_connectTime.show( std::cout, true );
+    ChurnSlot::c_getTime.show( std::cout );
+
+    return ( nFail || nConnectTimeout || nGetTimeout ) ? 1 : 0;
+}
+
+/// Seconds until the next open-loop arrival at rate gets/sec
+double nextInterArrival( double rate )
+{
+    if ( !loadPoisson )
+        return 1.0 / rate;
+    // u in (0,1] so log(u) is finite
+    double  u   = ( rand() + 1.0 ) / ( RAND_MAX + 1.0 );
+    return -log( u ) / rate;
+}
+
+/// Counts for one open-loop run at a fixed offered rate
+struct LoadStep
+{
+    double      rate;       // Requested gets/sec
+    double      tOffered;   // Seconds of offered load
+    size_t      nArrivals;
+    size_t      nSkipped;   // Arrivals w/ no free slot or at the process in-flight cap
+    size_t      nSkippedCap;// Of those, skipped at the process in-flight cap
+    size_t      nIssued;
+    size_t      nSuccess;
+    size_t      nFail;
+    size_t      nTimeout;
+    double      p50;        // Get latency, sec
+    double      p99;
+
+    LoadStep()
+        :   rate( 0.0 ), tOffered( 0.0 ), nArrivals( 0 ), nSkipped( 0 ), nSkippedCap( 0 )
+        ,   nIssued( 0 ), nSuccess( 0 ), nFail( 0 ), nTimeout( 0 ), p50( 0.0 ), p99( 0.0 )
+    {
+    }
+
+    double offered( ) const
+    {
+        return tOffered > 0.0 ? nArrivals / tOffered : 0.0;
+    }
+    double achieved( ) const
+    {
+        return tOffered > 0.0 ? nSuccess / tOffered : 0.0;
+    }
+    /// loss is the fraction of arrivals that did not get a successful reply
+    double loss( ) const
+    {
+        return nArrivals ? 1.0 - static_cast<double>( nSuccess ) / nArrivals : 0.0;
+    }
+
+    /// addCounts adds the cumulative get counts of getters, LoadGetter::c_lock must be held
+    void addCounts( const std::vector<std::tr1::shared_ptr<LoadGetter> > & getters )
+    {
+        nSkippedCap += LoadGetter::c_nSkippedTotalCap;
+        for ( size_t i = 0; i < getters.size(); i++ )
+        {
+            nIssued     += getters[i]->m_nIssued;
+            nSuccess    += getters[i]->m_nSuccess;
+            nFail       += getters[i]->m_nFail;
+            nTimeout    += getters[i]->m_nTimeout;
+        }
+    }
+};
+
+/// offerLoad offers rate gets/sec round robin over getters for duration seconds,
+/// duration <= 0 runs until SIGINT, and returns the counts for just this run.
+/// Arrival times are absolute from the start of the run, so a late wakeup
+/// is followed by a burst that catches up instead of lowering the offered load.
+LoadStep offerLoad( std::vector<std::tr1::shared_ptr<LoadGetter> > & getters, double rate, double duration )
+{
+    LoadStep    prior;
+    {
+        epicsGuard<epicsMutex> G(LoadGetter::c_lock);
+        prior.addCounts( getters );
+    }
+    LoadStep    step;
+    step.rate   = rate;
+    LoadGetter::c_latency.clear();
+
+    const epicsUInt64   tStart      = epicsMonotonicGet();
+    double              tNext       = 0.0;      // Seconds from tStart of next arrival
+    double              tReap       = 1.0;
+    double              tNow        = 0.0;
+    size_t              iPV         = 0;
+    while ( !Tracker::abort )
+    {
+        if ( duration > 0.0 && tNext >= duration )
+            break;
+        tNow = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+        if ( tNow >= tReap && timeout > 0.0 )
+        {
+            for ( size_t i = 0; i < getters.size(); i++ )
+                getters[i]->reap( timeout );
+            tReap = tNow + 1.0;
+        }
+        if ( tNext > tNow )
+        {
+            epicsThreadSleep( tNext - tNow );
+            continue;
+        }
+        if ( !getters[iPV]->issue() )
+            step.nSkipped++;
+        iPV = ( iPV + 1 ) % getters.size();
+        step.nArrivals++;
+        tNext += nextInterArrival( rate );
+    }
+    step.tOffered   = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+
+    // Give outstanding gets a chance to finish, then cancel the rest
+    double  tDrainEnd   = step.tOffered + ( timeout > 0.0 ? timeout : 1.0 );
+    for (;;)
+    {
+        {
+            epicsGuard<epicsMutex> G(LoadGetter::c_lock);
+            if ( LoadGetter::c_inFlight == 0 )
+                break;
+        }
+        if ( Tracker::abort || ( epicsMonotonicGet() - tStart ) * 1.0e-9 >= tDrainEnd )
+            break;
+        epicsThreadSleep( 0.01 );
+    }
+    for ( size_t i = 0; i < getters.size(); i++ )
+        getters[i]->cancelAll();
+
+    {
+        epicsGuard<epicsMutex> G(LoadGetter::c_lock);
+        step.addCounts( getters );
+    }
+    step.nSkippedCap    -= prior.nSkippedCap;
+    step.nIssued        -= prior.nIssued;
+    step.nSuccess       -= prior.nSuccess;
+    step.nFail          -= prior.nFail;
+    step.nTimeout       -= prior.nTimeout;
+    step.p50    = LoadGetter::c_latency.percentile( 50.0 );
+    step.p99    = LoadGetter::c_latency.percentile( 99.0 );
+    return step;
+}
+
+/// runOpenLoop offers loadRate gets/sec spread round robin over pvList.
+int runOpenLoop( pvac::ClientProvider & provider, const std::vector<std::string> & pvList,
+                 const pvd::PVStructurePtr & pvRequest )
+{
+    std::vector<std::tr1::shared_ptr<LoadGetter> >  getters;
+    for ( std::vector<std::string>::const_iterator it = pvList.begin(); it != pvList.end(); ++it )
+    {
+        std::tr1::shared_ptr<LoadGetter> getter( new LoadGetter( provider.connect(*it), pvRequest, maxInFlightPV ) );
+        getters.push_back( getter );
+    }
+
+    Tracker::prepare(); // install signal handler
+    srand( static_cast<unsigned int>( time(NULL) ) );
+
+    std::cout   << "Open-loop: " << loadRate << " gets/sec, " << ( loadPoisson ? "poisson" : "fixed" )
+                << " arrivals over " << getters.size() << " PVs, in flight max " << maxInFlightPV
+                << " per PV, " << maxInFlight << " total" << std::endl;
+
+    LoadStep    step    = offerLoad( getters, loadRate, loadDuration );
+
+    if ( verbosity > 0 )
+    {
+        std::cout   << std::setw(pvnamewidth) << std::left << "PV" << std::right
+                    << " " << std::setw(10) << "Issued"
+                    << " " << std::setw(10) << "Success"
+                    << " " << std::setw(10) << "Fail"
+                    << " " << std::setw(10) << "Timeout"
+                    << " " << std::setw(10) << "Skipped"
+                    << " " << std::setw(10) << "MaxMs" << std::endl;
+        for ( size_t i = 0; i < getters.size(); i++ )
+            getters[i]->showStats( std::cout );
+    }
+
+    std::cout   << "Open-loop: " << step.nArrivals << " arrivals in " << step.tOffered << " sec, offered "
+                << step.offered() << " gets/sec, achieved "
+                << step.achieved() << " gets/sec" << std::endl;
+    std::cout   << "Open-loop: " << step.nIssued << " issued, " << step.nSuccess << " success, " << step.nFail << " failed, "
+                << step.nTimeout << " timed out or cancelled, " << step.nSkipped << " skipped ("
+                << step.nSkippedCap << " at process in-flight cap)" << std::endl;
+    LoadGetter::c_latency.show( std::cout, true );
+
+    return ( step.nFail || step.nTimeout ) ? 1 : 0;
+}
+
+/// sloPass checks one capacity search step against the -Y thresholds
+bool sloPass( const LoadStep & step )
+{
+    return step.nArrivals > 0 && step.loss() <= sloLoss && step.p99 <= sloP99;
+}
+
+void showLoadStep( std::ostream & out, const LoadStep & step )
+{
+    std::ios::fmtflags  flags( out.flags() );
+    out << std::right << std::fixed << std::setprecision(1)
+        << std::setw(12) << step.rate
+        << " " << std::setw(12) << step.offered()
+        << " " << std::setw(12) << step.achieved()
+        << std::setprecision(3)
+        << " " << std::setw(8) << step.loss() * 100.0
+        << " " << std::setw(10) << step.p50 * 1e3
+        << " " << std::setw(10) << step.p99 * 1e3
+        << " " << std::setw(5) << ( sloPass( step ) ? "pass" : "FAIL" ) << std::endl;
+    out.flags( flags );
+}
+
+/// runCapacitySearch finds the highest open-loop get rate over pvList that meets the SLO.
+/// Doubles the rate from searchStartRate until a step fails or searchMaxRate passes,
+/// then bisects between the last pass and the first failure to searchResolution.
+/// Stops after one step if searchStartRate already fails the SLO.
+/// Channels stay connected across steps, so each step measures only the load.
+/// The knee is the lowest rate tried whose p99 latency is kneeFactor times the
+/// p99 at the lowest rate tried, where queueing starts to dominate.
+int runCapacitySearch( pvac::ClientProvider & provider, const std::vector<std::string> & pvList,
+                       const pvd::PVStructurePtr & pvRequest )
+{
+    std::vector<std::tr1::shared_ptr<LoadGetter> >  getters;
+    for ( std::vector<std::string>::const_iterator it = pvList.begin(); it != pvList.end(); ++it )
+    {
+        std::tr1::shared_ptr<LoadGetter> getter( new LoadGetter( provider.connect(*it), pvRequest, maxInFlightPV ) );
+        getters.push_back( getter );
+    }
+
+    Tracker::prepare(); // install signal handler
+    srand( static_cast<unsigned int>( time(NULL) ) );
+
+    double  stepDuration = loadDuration > 0.0 ? loadDuration : 10.0;
+    std::cout   << "Capacity search: " << searchStartRate << " to " << searchMaxRate << " gets/sec over "
+                << getters.size() << " PVs, " << stepDuration << " sec per step, SLO loss <= "
+                << sloLoss * 100.0 << "%, p99 <= " << sloP99 * 1e3 << " ms" << std::endl;
+
+    // Connect and warm up at the start rate, not counted
+    offerLoad( getters, searchStartRate, 1.0 );
+
+    std::cout   << std::right
+                << std::setw(12) << "Rate"
+                << " " << std::setw(12) << "Offered"
+                << " " << std::setw(12) << "Achieved"
+                << " " << std::setw(8) << "Loss%"
+                << " " << std::setw(10) << "p50(ms)"
+                << " " << std::setw(10) << "p99(ms)"
+                << " " << std::setw(5) << "SLO" << std::left << std::endl;
+
+    std::vector<LoadStep>   steps;
+    double  passRate    = 0.0;  // Highest rate that met the SLO
+    double  failRate    = 0.0;  // Lowest rate that failed, 0 if none did
+    double  rate        = searchStartRate;
+    while ( !Tracker::abort && steps.size() < searchMaxSteps )
+    {
+        LoadStep    step    = offerLoad( getters, rate, stepDuration );
+        if ( Tracker::abort )
+            break;
+        steps.push_back( step );
+        showLoadStep( std::cout, step );
+        if ( sloPass( step ) )
+            passRate = std::max( passRate, rate );
+        else if ( failRate == 0.0 || rate < failRate )
+            failRate = rate;
+
+        if ( passRate == 0.0 )
+        {
+            // The start rate fails, lower rates are outside the search
+            break;
+        }
+        if ( failRate == 0.0 )
+        {
+            // Exponential phase
+            if ( rate >= searchMaxRate )
+                break;
+            rate = std::min( rate * 2.0, searchMaxRate );
+        }
+        else
+        {
+            // Binary phase
+            if ( failRate - passRate <= searchResolution * failRate )
+                break;
+            rate = ( passRate + failRate ) / 2.0;
+        }
+    }
+
+    // Knee: first rate, in rate order, w/ p99 kneeFactor over the lowest rate's
+    double  kneeRate    = 0.0;
+    if ( !steps.empty() )
+    {
+        size_t  iLowest = 0;
+        for ( size_t i = 1; i < steps.size(); i++ )
+            if ( steps[i].rate < steps[iLowest].rate )
+                iLowest = i;
+        double  baseP99 = steps[iLowest].p99;
+        for ( size_t i = 0; i < steps.size(); i++ )
+            if ( baseP99 > 0.0 && steps[i].p99 >= kneeFactor * baseP99
+                && ( kneeRate == 0.0 || steps[i].rate < kneeRate ) )
+                kneeRate = steps[i].rate;
+    }
+
+    std::cout << "Capacity: ";
+    if ( steps.empty() )
+        std::cout << "no step completed" << std::endl;
+    else if ( passRate == 0.0 )
+        std::cout << "start rate " << searchStartRate << " gets/sec fails the SLO, try a lower -K start" << std::endl;
+    else if ( failRate > 0.0 )
+        std::cout << "max sustainable " << passRate << " gets/sec, first failure at " << failRate << " gets/sec" << std::endl;
+    else
+        std::cout << "max sustainable " << passRate << " gets/sec, no failure up to " << searchMaxRate << " gets/sec" << std::endl;
+    std::cout << "Knee: ";
+    if ( kneeRate > 0.0 )
+        std::cout << "p99 latency " << kneeFactor << "x its low load value at " << kneeRate << " gets/sec" << std::endl;
+    else
+        std::cout << "none found, p99 latency stayed within " << kneeFactor << "x its low load value" << std::endl;
+
+    return passRate > 0.0 ? 0 : 1;
+}
+
 } // namespace
 
 #ifndef MAIN
@@ -784,7 +1838,7 @@ int MAIN (int argc, char *argv[])
 
         // ================ Parse Arguments
 
-        while ((opt = getopt(argc, argv, ":hvVCSD:M:r:R:w:tp:qdcF:f:ni")) != -1) {
+        while ((opt = getopt(argc, argv, ":hvVCSD:M:r:R:w:tp:qdcF:f:niL:A:I:T:kX:J:K:Y:")) != -1) {
             switch (opt) {
             case 'h':               /* Print usage */
                 usage();
@@ -842,6 +1896,102 @@ int MAIN (int argc, char *argv[])
                     repeat = temp;
                 }
 				break;
+            case 'k':               /* Keep channels across -R cycles */
+                keepChannels = true;
+                break;
+            case 'X':               /* Churn rate */
+                if((epicsScanDouble(optarg, &temp)) != 1 || temp <= 0.0)
+                {
+                    fprintf(stderr, "'%s' is not a valid churn rate "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    churnRate = temp;
+                }
+                break;
+            case 'J':               /* Churn max in flight */
+            {
+                unsigned int    nMax;
+                if ( sscanf( optarg, "%u", &nMax ) != 1 || nMax == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid churn in-flight limit "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    maxConnects = nMax;
+                }
+            }
+                break;
+            case 'L':               /* Open-loop get rate */
+                if((epicsScanDouble(optarg, &temp)) != 1 || temp <= 0.0)
+                {
+                    fprintf(stderr, "'%s' is not a valid get rate "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    loadRate = temp;
+                }
+                break;
+            case 'A':               /* Open-loop arrival schedule */
+                if(strcmp(optarg, "fixed")==0) {
+                    loadPoisson = false;
+                } else if(strcmp(optarg, "poisson")==0) {
+                    loadPoisson = true;
+                } else {
+                    fprintf(stderr, "Unknown arrival schedule '%s' - ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                }
+                break;
+            case 'I':               /* Open-loop in-flight caps */
+            {
+                unsigned int    perPV   = 0;
+                unsigned int    total   = static_cast<unsigned int>(maxInFlight);
+                int             nScan   = sscanf( optarg, "%u:%u", &perPV, &total );
+                if ( nScan < 1 || perPV == 0 || total == 0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid <pv>[:<total>] in-flight limit "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    maxInFlightPV   = perPV;
+                    maxInFlight     = total;
+                }
+            }
+                break;
+            case 'K':               /* Capacity search */
+            {
+                double  start   = 0.0;
+                double  max     = searchMaxRate;
+                int     nScan   = sscanf( optarg, "%lf:%lf", &start, &max );
+                if ( nScan < 1 || start <= 0.0 || max < start )
+                {
+                    fprintf(stderr, "'%s' is not a valid <start>[:<max>] rate "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    searchStartRate = start;
+                    searchMaxRate   = max;
+                }
+            }
+                break;
+            case 'Y':               /* Capacity search SLO */
+            {
+                double  lossPct = sloLoss * 100.0;
+                double  p99ms   = sloP99 * 1e3;
+                int     nScan   = sscanf( optarg, "%lf:%lf", &lossPct, &p99ms );
+                if ( nScan < 1 || lossPct < 0.0 || p99ms <= 0.0 )
+                {
+                    fprintf(stderr, "'%s' is not a valid <loss%%>[:<p99 ms>] SLO "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    sloLoss = lossPct / 100.0;
+                    sloP99  = p99ms * 1e-3;
+                }
+            }
+                break;
+            case 'T':               /* Open-loop duration */
+                if((epicsScanDouble(optarg, &temp)) != 1)
+                {
+                    fprintf(stderr, "'%s' is not a valid duration "
+                                    "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                } else {
+                    loadDuration = temp;
+                }
+                break;
             case 'r':
                 request = optarg;
                 break;
@@ -941,6 +2091,13 @@ int MAIN (int argc, char *argv[])
 		std::vector<std::tr1::shared_ptr<Tracker> > tracked;
 		pvac::ClientProvider provider(defaultProvider);
 
+		if ( searchStartRate > 0.0 )
+			return runCapacitySearch( provider, pvList, pvRequest );
+		if ( loadRate > 0.0 )
+			return runOpenLoop( provider, pvList, pvRequest );
+		if ( churnRate > 0.0 )
+			return runChurn( provider, pvList, pvRequest );
+
 		epics::auto_ptr<WorkQueue> Q;
 		if(monitor)
 			Q.reset(new WorkQueue);
@@ -960,10 +2117,7 @@ int MAIN (int argc, char *argv[])
 
 		Tracker::prepare(); // install signal handler
 
-		do  {   // Create and run PVA clients for pvNames in argv[argc]
-			{
-
-            // ========================== Wait for operations to complete, or timeout
+		{   // Wait for the initial gets to complete, or timeout
 
             if(debugFlag)
                 std::cerr << "Waiting...\n";
@@ -985,22 +2139,10 @@ int MAIN (int argc, char *argv[])
                     }
                 }
             }
-			}
-
-    	if ( Tracker::abort )
-			break;
-
-		if ( repeat >= 0 )
-		{
-			epicsThreadSleep( repeat );
-
-			for ( std::vector<std::tr1::shared_ptr<Tracker> >::iterator it = tracked.begin(); it != tracked.end(); ++it )
-			{
-				pvac::ClientChannel chan( provider.connect((*it)->getName()) );
-				(*it)->restart( chan, pvRequest );
-			}
 		}
-	}   while ( repeat >= 0 && !Tracker::abort );
+
+		if ( repeat >= 0 && !Tracker::abort )
+			runRepeatSchedule( provider, tracked, pvRequest, repeat );
 
 	pvCollector::allCollectorsWriteValues( testDirPath );
 
@@ -0,0 +1,241 @@
+#ifndef PVHISTOGRAM_H
+#define PVHISTOGRAM_H
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <iomanip>
+#include <iostream>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+/// pvHistogram
+/// Thread safe log-linear histogram of durations in seconds.
+/// Values are kept as integer microseconds, exact below 32us and within
+/// 1/32 (~3%) above that, so percentiles stay accurate from us to hours
+/// w/ a fixed amount of memory.
+class pvHistogram
+{
+public:		// Public member functions
+	explicit pvHistogram( const std::string & name = std::string() )
+		:	m_name( name )
+		,	m_buckets( c_nBuckets, 0 )
+		,	m_count( 0 )
+		,	m_sum( 0.0 )
+		,	m_min( std::numeric_limits<double>::max() )
+		,	m_max( 0.0 )
+	{
+	}
+
+	/// add a duration in seconds
+	void add( double seconds )
+	{
+		if ( seconds < 0.0 )
+			seconds = 0.0;
+		epicsUInt64	usec	= static_cast<epicsUInt64>( seconds * 1.0e6 );
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		m_buckets[ bucketIndex( usec ) ]++;
+		m_count++;
+		m_sum += seconds;
+		if ( seconds < m_min )
+			m_min = seconds;
+		if ( seconds > m_max )
+			m_max = seconds;
+	}
+
+	/// add count durations in seconds, locking once for the batch
+	void add( const double * seconds, size_t count )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		epicsUInt64	*	buckets	= &m_buckets[0];
+		double			sum		= 0.0;
+		double			min		= m_min;
+		double			max		= m_max;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			double	value	= seconds[i] < 0.0 ? 0.0 : seconds[i];
+			buckets[ bucketIndex( static_cast<epicsUInt64>( value * 1.0e6 ) ) ]++;
+			sum += value;
+			if ( value < min )
+				min = value;
+			if ( value > max )
+				max = value;
+		}
+		m_count	+= count;
+		m_sum	+= sum;
+		m_min	= min;
+		m_max	= max;
+	}
+
+	/// merge the counts from another histogram
+	void merge( const pvHistogram & other )
+	{
+		if ( &other == this )
+			return;
+		std::vector<epicsUInt64>	buckets;
+		epicsUInt64	count;
+		double		sum, min, max;
+		{
+			epicsGuard<epicsMutex>	guard( other.m_mutex );
+			buckets	= other.m_buckets;
+			count	= other.m_count;
+			sum		= other.m_sum;
+			min		= other.m_min;
+			max		= other.m_max;
+		}
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		for ( size_t i = 0; i < c_nBuckets; i++ )
+			m_buckets[i] += buckets[i];
+		m_count += count;
+		m_sum	+= sum;
+		if ( min < m_min )
+			m_min = min;
+		if ( max > m_max )
+			m_max = max;
+	}
+
+	void clear( )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		m_buckets.assign( c_nBuckets, 0 );
+		m_count	= 0;
+		m_sum	= 0.0;
+		m_min	= std::numeric_limits<double>::max();
+		m_max	= 0.0;
+	}
+
+	epicsUInt64 count( ) const
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_count;
+	}
+
+	double mean( ) const
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_count ? m_sum / m_count : 0.0;
+	}
+
+	double min( ) const
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_count ? m_min : 0.0;
+	}
+
+	double max( ) const
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_max;
+	}
+
+	/// percentile returns the value in seconds at pct, 0.0 to 100.0
+	double percentile( double pct ) const
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		if ( m_count == 0 )
+			return 0.0;
+		epicsUInt64	target	= static_cast<epicsUInt64>( pct / 100.0 * m_count + 0.5 );
+		if ( target < 1 )
+			target = 1;
+		if ( target > m_count )
+			target = m_count;
+		epicsUInt64	seen	= 0;
+		for ( size_t i = 0; i < c_nBuckets; i++ )
+		{
+			seen += m_buckets[i];
+			if ( seen >= target )
+			{
+				double	value	= bucketMidpoint( i ) * 1.0e-6;
+				// Never report more than what we actually saw
+				if ( value > m_max )
+					value = m_max;
+				if ( value < m_min )
+					value = m_min;
+				return value;
+			}
+		}
+		return m_max;
+	}
+
+	/// show one line summary in msec, w/ optional header
+	void show( std::ostream & out, bool fHeader = false ) const
+	{
+		if ( fHeader )
+			out	<< std::left << std::setw(24) << "Histogram (ms)" << std::right
+				<< " " << std::setw(10) << "Count"
+				<< " " << std::setw(10) << "Min"
+				<< " " << std::setw(10) << "Mean"
+				<< " " << std::setw(10) << "p50"
+				<< " " << std::setw(10) << "p90"
+				<< " " << std::setw(10) << "p99"
+				<< " " << std::setw(10) << "p99.9"
+				<< " " << std::setw(10) << "Max" << std::endl;
+		std::ios::fmtflags	flags( out.flags() );
+		out	<< std::left << std::setw(24) << m_name << std::right
+			<< " " << std::setw(10) << count()
+			<< std::fixed << std::setprecision(3)
+			<< " " << std::setw(10) << min()  * 1e3
+			<< " " << std::setw(10) << mean() * 1e3
+			<< " " << std::setw(10) << percentile( 50.0 ) * 1e3
+			<< " " << std::setw(10) << percentile( 90.0 ) * 1e3
+			<< " " << std::setw(10) << percentile( 99.0 ) * 1e3
+			<< " " << std::setw(10) << percentile( 99.9 ) * 1e3
+			<< " " << std::setw(10) << max()  * 1e3 << std::endl;
+		out.flags( flags );
+	}
+
+	const std::string & getName( ) const
+	{
+		return m_name;
+	}
+
+private:	// Private class functions
+	/// bucketIndex: linear below c_nSub, then c_nSub buckets per power of 2
+	static size_t bucketIndex( epicsUInt64 usec )
+	{
+		if ( usec < c_nSub )
+			return static_cast<size_t>( usec );
+		// Binary search for the msb, a handful of steps instead of one per bit
+		size_t		msb	= 0;
+		epicsUInt64	v	= usec;
+		if ( v >> 32 ) { v >>= 32; msb += 32; }
+		if ( v >> 16 ) { v >>= 16; msb += 16; }
+		if ( v >>  8 ) { v >>=  8; msb +=  8; }
+		if ( v >>  4 ) { v >>=  4; msb +=  4; }
+		if ( v >>  2 ) { v >>=  2; msb +=  2; }
+		if ( v >>  1 ) { msb += 1; }
+		size_t	shift	= msb - c_subBits;
+		size_t	sub		= static_cast<size_t>( usec >> shift ) - c_nSub;
+		size_t	index	= ( shift + 1 ) * c_nSub + sub;
+		return index < c_nBuckets ? index : c_nBuckets - 1;
+	}
+
+	static double bucketMidpoint( size_t index )
+	{
+		if ( index < c_nSub )
+			return static_cast<double>( index );
+		size_t	shift	= index / c_nSub - 1;
+		size_t	sub		= index % c_nSub;
+		double	low		= static_cast<double>( ( static_cast<epicsUInt64>( c_nSub + sub ) ) << shift );
+		double	width	= static_cast<double>( static_cast<epicsUInt64>( 1 ) << shift );
+		return low + width / 2.0;
+	}
+
+private:	// Private member variables
+	std::string					m_name;
+	std::vector<epicsUInt64>	m_buckets;
+	epicsUInt64					m_count;
+	double						m_sum;
+	double						m_min;
+	double						m_max;
+	mutable epicsMutex			m_mutex;
+
+private:	// Private class variables
+	static const size_t	c_subBits	= 5;
+	static const size_t	c_nSub		= 1 << c_subBits;
+	static const size_t	c_nBuckets	= 40 * c_nSub;	// 2^40 us is ~12 days
+};
+
+#endif // PVHISTOGRAM_H
@@ -0,0 +1,451 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsEvent.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <pv/pvAccess.h>
+#include <pv/thread.h>
+
+#include "pvImpairProxy.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvImpair"
+#endif
+
+#define PV_IMPAIR_MAJOR_VERSION			0
+#define PV_IMPAIR_MINOR_VERSION			1
+#define PV_IMPAIR_MAINTENANCE_VERSION	0
+#define PV_IMPAIR_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool		debugFlag	= false;
+double		runTime		= 0.0;		// Seconds to run, 0 runs until signaled
+double		statsPeriod	= 10.0;		// Seconds between stats lines, 0 for none
+std::string	captureCommand;			// -C pvCapture command line to run through the proxy, empty for none
+epicsEvent	doneEvt;
+bool		abortFlag	= false;
+
+void alldone(int num)
+{
+    (void)num;
+    abortFlag = true;
+    doneEvt.signal();
+}
+
+// This could go to it's own cpp file and header
+/// CaptureHarness
+/// Runs a pvCapture command line w/ -a pointing at the proxy, so the missed
+/// counts under test are pvCapture's own.  A thread echoes pvCapture's output
+/// and keeps the numbers from its "Total:" line.
+struct CaptureHarness : public epicsThreadRunable
+{
+    CaptureHarness( )
+        :m_pid( -1 )
+        ,m_fd( -1 )
+        ,m_status( 0 )
+        ,m_fTotals( false )
+        ,m_nUpdates( 0 )
+        ,m_nMissed( 0 )
+        ,m_nOverruns( 0 )
+    {
+    }
+    virtual ~CaptureHarness()
+    {
+        stop();
+    }
+
+    /// start runs command, split at spaces, w/ "-a proxyAddr" after the program name.
+    /// Throws if the command is empty or can't be started.
+    void start( const std::string & command, const std::string & proxyAddr )
+    {
+        std::vector<std::string>    args;
+        std::istringstream          words( command );
+        std::string                 word;
+        while ( words >> word )
+        {
+            args.push_back( word );
+            if ( args.size() == 1 )
+            {
+                args.push_back( "-a" );
+                args.push_back( proxyAddr );
+            }
+        }
+        if ( args.empty() )
+            throw std::runtime_error( "Empty pvCapture command" );
+        std::vector<char *> argv;
+        for ( size_t i = 0; i < args.size(); i++ )
+            argv.push_back( const_cast<char *>( args[i].c_str() ) );
+        argv.push_back( NULL );
+
+        int fds[2];
+        if ( pipe( fds ) != 0 )
+            throw std::runtime_error( std::string( "pipe failed: " ) + strerror( errno ) );
+        m_pid = fork();
+        if ( m_pid < 0 )
+        {
+            close( fds[0] );
+            close( fds[1] );
+            throw std::runtime_error( std::string( "fork failed: " ) + strerror( errno ) );
+        }
+        if ( m_pid == 0 )
+        {
+            // Child, only async-signal-safe calls until exec
+            dup2( fds[1], 1 );
+            close( fds[0] );
+            close( fds[1] );
+            execvp( argv[0], &argv[0] );
+            _exit( 127 );
+        }
+        close( fds[1] );
+        m_fd = fds[0];
+        m_thread.reset( new pvd::Thread( pvd::Thread::Config()
+                                            .name( "pvImpairCapture" )
+                                            .autostart( true )
+                                            .run( this ) ) );
+    }
+
+    /// isRunning returns false once pvCapture has exited on its own
+    bool isRunning( )
+    {
+        if ( m_pid <= 0 )
+            return false;
+        if ( waitpid( m_pid, &m_status, WNOHANG ) != m_pid )
+            return true;
+        m_pid = -1;
+        return false;
+    }
+
+    /// stop sends pvCapture SIGINT, so it saves its values and reports its totals,
+    /// then waits for it to exit and for the rest of its output
+    void stop( )
+    {
+        if ( m_pid > 0 )
+        {
+            kill( m_pid, SIGINT );
+            while ( waitpid( m_pid, &m_status, 0 ) < 0 && errno == EINTR )
+                ;
+            m_pid = -1;
+        }
+        if ( m_thread )
+        {
+            m_thread->exitWait();
+            m_thread.reset();
+        }
+    }
+
+    /// run echoes pvCapture's output until it closes stdout
+    virtual void run( )
+    {
+        FILE *  fin = fdopen( m_fd, "r" );
+        if ( !fin )
+        {
+            close( m_fd );
+            return;
+        }
+        char    line[1024];
+        while ( fgets( line, sizeof(line), fin ) )
+        {
+            fputs( line, stdout );
+            fflush( stdout );
+            unsigned long long  nUpdates, nMissed, nOverruns;
+            if ( sscanf( line, "Total: %llu updates, %llu missed, %llu overruns", &nUpdates, &nMissed, &nOverruns ) == 3 )
+            {
+                epicsGuard<epicsMutex> G(m_lock);
+                m_fTotals   = true;
+                m_nUpdates  = nUpdates;
+                m_nMissed   = nMissed;
+                m_nOverruns = nOverruns;
+            }
+        }
+        fclose( fin );
+    }
+
+    /// getTotals returns false if pvCapture never reported its totals
+    bool getTotals( epicsUInt64 & nUpdates, epicsUInt64 & nMissed, epicsUInt64 & nOverruns )
+    {
+        epicsGuard<epicsMutex> G(m_lock);
+        nUpdates    = m_nUpdates;
+        nMissed     = m_nMissed;
+        nOverruns   = m_nOverruns;
+        return m_fTotals;
+    }
+
+    /// exitStatus returns pvCapture's exit code, or -1 if it didn't exit normally
+    int exitStatus( ) const
+    {
+        return WIFEXITED( m_status ) ? WEXITSTATUS( m_status ) : -1;
+    }
+
+    pid_t           m_pid;
+    int             m_fd;       // Read end of pvCapture's stdout, owned by run()
+    int             m_status;   // waitpid() status once pvCapture exits
+    epicsMutex      m_lock;     // Guards the totals
+    bool            m_fTotals;
+    epicsUInt64     m_nUpdates;
+    epicsUInt64     m_nMissed;
+    epicsUInt64     m_nOverruns;
+    std::tr1::shared_ptr<pvd::Thread>   m_thread;
+};
+
+/// showDetection compares pvCapture's totals w/ the proxy's ground truth.
+/// Only drops the proxy injected and a client can see count as expected misses.
+/// Server queue overruns and updates lost across resets also leave counter gaps
+/// pvCapture counts as missed, so they are reported on their own line.
+void showDetection( std::ostream & out, const pvImpairProxy::Stats & stats,
+                    epicsUInt64 nUpdates, epicsUInt64 nMissed, epicsUInt64 nOverruns )
+{
+    out << EXECNAME ": pvCapture " << nUpdates << " updates, " << nMissed << " missed vs "
+        << stats.nDropped << " injected, detection error "
+        << static_cast<double>( nMissed ) - static_cast<double>( stats.nDropped ) << std::endl;
+    out << EXECNAME ": Apart from the drops: " << nOverruns << " server queue overruns, "
+        << stats.nResets << " resets w/ " << stats.nResetLost << " queued updates lost, "
+        << stats.nDroppedUnseen << " drops w/ no later update to show the gap" << std::endl;
+    if ( nOverruns || stats.nResets )
+        out << EXECNAME ": Updates squashed by overruns or lost across resets are also in the missed count" << std::endl;
+}
+
+void usage (void)
+{
+    pvImpairProxy::Config	defaults;
+    fprintf( stdout, "\nUsage: " EXECNAME " [options]\n"
+    "\n"
+    "Network impairment proxy for loss detection tests.  Forwards pvAccess TCP\n"
+    "connections from a loopback port to one server, adding delay, jitter,\n"
+    "a bandwidth cap, random connection resets and dropped monitor updates.\n"
+    "Clients skip the search and connect straight to the proxy, ex. pvCapture -a.\n"
+    "The stats lines give the dropped updates a client should report as missed.\n"
+    "With -C the proxy runs pvCapture itself and compares its missed total w/ the\n"
+    "injected drops, w/ server queue overruns and reset losses reported apart.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -l <port>:         Loopback TCP port to listen on, default is %u\n"
+    "  -u <host:port>:    Server to forward to, default is %s\n"
+    "  -L <pct>:          Drop <pct> percent of monitor updates\n"
+    "  -D <ms>[:<ms>]:    Delay each message, plus up to the 2nd value of random jitter\n"
+    "  -B <bytes/sec>:    Bandwidth cap per connection and direction\n"
+    "  -R <sec>:          Mean seconds between random connection resets\n"
+    "  -s <seed>:         Random seed, default is %u\n"
+    "  -T <sec>:          Run for <sec> seconds, default runs until signaled\n"
+    "  -S <sec>:          Seconds between stats lines, 0 for none.  default is %.0f\n"
+    "  -C <command>:      Run the pvCapture <command>, split at spaces, w/ -a pointing at the\n"
+    "                     proxy.  After -T seconds, or once pvCapture exits, compare its\n"
+    "                     missed total w/ the injected drops.  Not w/ -U, followers repeat misses.\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -u 127.0.0.1:5075 -l 5077 -L 1 -D 5:5\n"
+    "         pvCapture -a 127.0.0.1:5077 PVA:GW:TEST:00:Count00\n"
+    "         " EXECNAME " -u 127.0.0.1:5075 -L 1 -T 60 -C 'pvCapture -f pvNames.txt -D /tmp/impair'\n\n"
+             , defaults.listenPort, defaults.upstream.c_str(), defaults.seed, statsPeriod );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+    pvImpairProxy::Config   config;
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVl:u:L:D:B:R:s:T:S:C:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_IMPAIR_MAJOR_VERSION,
+                                PV_IMPAIR_MINOR_VERSION,
+                                PV_IMPAIR_MAINTENANCE_VERSION,
+                                PV_IMPAIR_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 'l':
+        {
+            unsigned int    port;
+            if ( sscanf( optarg, "%u", &port ) != 1 || port == 0 || port > 65535 )
+                fprintf(stderr, "'%s' is not a valid port "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                config.listenPort = port;
+        }
+            break;
+        case 'u':
+            config.upstream = optarg;
+            break;
+        case 'L':
+        case 'B':
+        case 'R':
+        case 'T':
+        case 'S':
+        {
+            double  value;
+            if ( epicsScanDouble( optarg, &value ) != 1 || value < 0.0 || ( opt == 'L' && value > 100.0 ) )
+            {
+                fprintf(stderr, "'%s' is not a valid value for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 'L' )
+                config.dropFraction = value / 100.0;
+            else if ( opt == 'B' )
+                config.bandwidth = value;
+            else if ( opt == 'R' )
+                config.resetPeriod = value;
+            else if ( opt == 'T' )
+                runTime = value;
+            else
+                statsPeriod = value;
+        }
+            break;
+        case 'D':
+        {
+            double  delayMs, jitterMs = 0.0;
+            if ( sscanf( optarg, "%lf:%lf", &delayMs, &jitterMs ) < 1 || delayMs < 0.0 || jitterMs < 0.0 )
+            {
+                fprintf(stderr, "'%s' is not a valid delay "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            }
+            else
+            {
+                config.delay    = delayMs * 1.0e-3;
+                config.jitter   = jitterMs * 1.0e-3;
+            }
+        }
+            break;
+        case 's':
+        {
+            unsigned int    seed;
+            if ( sscanf( optarg, "%u", &seed ) != 1 )
+                fprintf(stderr, "'%s' is not a valid seed "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                config.seed = seed;
+        }
+            break;
+        case 'C':
+            captureCommand = optarg;
+            break;
+        case 'd':               /* Debug output */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+
+    signal(SIGINT,  alldone);
+    signal(SIGTERM, alldone);
+    signal(SIGQUIT, alldone);
+
+    pvImpairProxy   proxy( config );
+    proxy.start();
+    std::cout << EXECNAME ": Forwarding 127.0.0.1:" << config.listenPort << " to " << config.upstream
+              << ", delay " << config.delay * 1e3 << " ms, jitter " << config.jitter * 1e3 << " ms, ";
+    if ( config.bandwidth > 0.0 )
+        std::cout << "cap " << config.bandwidth << " bytes/sec, ";
+    if ( config.resetPeriod > 0.0 )
+        std::cout << "reset every " << config.resetPeriod << " sec on average, ";
+    std::cout << "drop " << config.dropFraction * 100.0 << "% of monitor updates" << std::endl;
+
+    CaptureHarness  harness;
+    if ( !captureCommand.empty() )
+    {
+        std::ostringstream  proxyAddr;
+        proxyAddr << "127.0.0.1:" << config.listenPort;
+        harness.start( captureCommand, proxyAddr.str() );
+    }
+
+    // ========================== Run until signaled, runTime elapses or pvCapture exits
+
+    epicsUInt64 tStart  = epicsMonotonicGet();
+    double      tStats  = statsPeriod;
+    while ( !abortFlag )
+    {
+        if ( !captureCommand.empty() && !harness.isRunning() )
+            break;
+        double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+        if ( runTime > 0.0 && elapsed >= runTime )
+            break;
+        double  wait    = 1.0;
+        if ( runTime > 0.0 && runTime - elapsed < wait )
+            wait = runTime - elapsed;
+        if ( statsPeriod > 0.0 )
+        {
+            if ( elapsed >= tStats )
+            {
+                proxy.showStats( std::cout );
+                tStats += statsPeriod;
+            }
+            if ( tStats - elapsed < wait )
+                wait = tStats - elapsed;
+        }
+        doneEvt.wait( wait );
+    }
+
+    // pvCapture goes before the proxy so it doesn't see a disconnect
+    if ( !captureCommand.empty() )
+        harness.stop();
+    proxy.stop();
+    proxy.showStats( std::cout );
+
+    if ( !captureCommand.empty() )
+    {
+        epicsUInt64 nUpdates, nMissed, nOverruns;
+        if ( !harness.getTotals( nUpdates, nMissed, nOverruns ) )
+        {
+            std::cerr << "Error: pvCapture exited w/ status " << harness.exitStatus() << " before reporting its totals\n";
+            return 1;
+        }
+        showDetection( std::cout, proxy.getStats(), nUpdates, nMissed, nOverruns );
+    }
+
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <epicsGuard.h>
+#include <epicsTime.h>
+
+#include "pvImpairProxy.h"
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+// PVA message header, see the pvAccess protocol spec
+const unsigned char	PVA_MAGIC			= 0xCA;
+const size_t		PVA_HEADER_SIZE		= 8;
+const unsigned char	PVA_FLAG_CONTROL	= 0x01;
+const unsigned char	PVA_FLAG_SEGMENTED	= 0x30;
+const unsigned char	PVA_FLAG_BIG_ENDIAN	= 0x80;
+const unsigned char	PVA_CMD_MONITOR		= 13;
+const unsigned char	PVA_MONITOR_DATA	= 0x00;	// Monitor subcommand of a data update
+
+const size_t		maxQueuedBytes		= 4 * 1024 * 1024;	// Per direction, stop reading beyond this
+const epicsUInt64	bandwidthBurstNs	= 10000000;			// Unused bandwidth carried over, covers poll's ms granularity
+
+/// pvaUInt32 reads a 4 byte message field in the byte order given by the header flags at msg
+epicsUInt32 pvaUInt32( const unsigned char * msg, const unsigned char * p )
+{
+	if ( msg[2] & PVA_FLAG_BIG_ENDIAN )
+		return ( static_cast<epicsUInt32>( p[0] ) << 24 ) | ( p[1] << 16 ) | ( p[2] << 8 ) | p[3];
+	return ( static_cast<epicsUInt32>( p[3] ) << 24 ) | ( p[2] << 16 ) | ( p[1] << 8 ) | p[0];
+}
+
+/// pvaMessageLength returns the length of the whole message at p, header included
+size_t pvaMessageLength( const unsigned char * p )
+{
+	if ( p[2] & PVA_FLAG_CONTROL )
+		return PVA_HEADER_SIZE;
+	return PVA_HEADER_SIZE + pvaUInt32( p, p + 4 );
+}
+
+/// isMonitorUpdate is true for an unsegmented server to client monitor data update,
+/// payload is ioid then subcommand
+bool isMonitorUpdate( const unsigned char * p, size_t msgLen )
+{
+	return	!( p[2] & ( PVA_FLAG_CONTROL | PVA_FLAG_SEGMENTED ) )
+		&&	p[3] == PVA_CMD_MONITOR
+		&&	msgLen > PVA_HEADER_SIZE + 4
+		&&	p[PVA_HEADER_SIZE + 4] == PVA_MONITOR_DATA;
+}
+
+/// resolveAddress parses host:port into addr, returns false if it can't
+bool resolveAddress( const std::string & hostPort, struct sockaddr_in & addr )
+{
+	size_t	colon	= hostPort.rfind( ':' );
+	if ( colon == std::string::npos || colon == 0 || colon + 1 == hostPort.size() )
+		return false;
+	std::string		host( hostPort, 0, colon );
+	std::string		port( hostPort, colon + 1 );
+	struct addrinfo	hints;
+	memset( &hints, 0, sizeof(hints) );
+	hints.ai_family		= AF_INET;
+	hints.ai_socktype	= SOCK_STREAM;
+	struct addrinfo	*	result	= NULL;
+	if ( getaddrinfo( host.c_str(), port.c_str(), &hints, &result ) != 0 || result == NULL )
+		return false;
+	memcpy( &addr, result->ai_addr, sizeof(addr) );
+	freeaddrinfo( result );
+	return true;
+}
+
+/// sendAll sends all of bytes, returns false if the connection is gone
+bool sendAll( int sock, const std::string & bytes )
+{
+	size_t	nSent	= 0;
+	while ( nSent < bytes.size() )
+	{
+		ssize_t	n	= send( sock, bytes.data() + nSent, bytes.size() - nSent, MSG_NOSIGNAL );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n <= 0 )
+			return false;
+		nSent += n;
+	}
+	return true;
+}
+
+void setNoDelay( int sock )
+{
+	int	one	= 1;
+	setsockopt( sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) );
+}
+
+/// uniform returns a random number in [0,1)
+double uniform( unsigned & seed )
+{
+	return rand_r( &seed ) / ( RAND_MAX + 1.0 );
+}
+
+} // namespace
+
+/// Pump
+/// Forwards one direction of one connection, src to dst, w/ the proxy's impairments.
+/// Server to client pumps split the stream into PVA messages to drop monitor updates.
+class pvImpairProxy::Pump : public epicsThreadRunable
+{
+public:
+	Pump( pvImpairProxy & proxy, Connection & conn, int src, int dst, bool fDownstream, unsigned seed )
+		:	m_proxy( proxy )
+		,	m_conn( conn )
+		,	m_src( src )
+		,	m_dst( dst )
+		,	m_fDownstream( fDownstream )
+		,	m_seed( seed )
+	{
+	}
+	virtual void run();
+
+private:
+	struct Message
+	{
+		std::string		bytes;
+		epicsUInt64		tDue;		// epicsMonotonicGet() time to send
+		bool			fUpdate;	// Monitor update, counted as lost if reset while queued
+		epicsUInt64		nDropsBefore;	// Updates of the same monitor dropped since its last update
+	};
+
+	pvImpairProxy &	m_proxy;
+	Connection &	m_conn;
+	int				m_src;
+	int				m_dst;
+	bool			m_fDownstream;
+	unsigned		m_seed;
+};
+
+/// Connection
+/// One client connection, its upstream connection and the two pumps between them
+class pvImpairProxy::Connection
+{
+public:
+	Connection( pvImpairProxy & proxy, int clientSock, int serverSock, unsigned seed )
+		:	m_clientSock( clientSock )
+		,	m_serverSock( serverSock )
+		,	m_closing( false )
+		,	m_reset( false )
+		,	m_nDone( 0 )
+		,	m_down( proxy, *this, serverSock, clientSock, true, seed )
+		,	m_up( proxy, *this, clientSock, serverSock, false, seed + 1 )
+	{
+		m_downThread.reset( new pvd::Thread( pvd::Thread::Config()
+											.name( "pvImpairDown" )
+											.autostart( true )
+											.run( &m_down ) ) );
+		m_upThread.reset( new pvd::Thread( pvd::Thread::Config()
+											.name( "pvImpairUp" )
+											.autostart( true )
+											.run( &m_up ) ) );
+	}
+	~Connection()
+	{
+		shutdown( false );
+		m_downThread->exitWait();
+		m_upThread->exitWait();
+		close( m_clientSock );
+		close( m_serverSock );
+	}
+
+	/// shutdown wakes both pumps, fReset closes abortively so both peers see a reset
+	void shutdown( bool fReset )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		if ( m_closing )
+			return;
+		m_closing	= true;
+		m_reset		= fReset;
+		if ( fReset )
+		{
+			struct linger	abortive;
+			abortive.l_onoff	= 1;
+			abortive.l_linger	= 0;
+			setsockopt( m_clientSock, SOL_SOCKET, SO_LINGER, &abortive, sizeof(abortive) );
+			setsockopt( m_serverSock, SOL_SOCKET, SO_LINGER, &abortive, sizeof(abortive) );
+		}
+		::shutdown( m_clientSock, SHUT_RDWR );
+		::shutdown( m_serverSock, SHUT_RDWR );
+	}
+	bool isClosing( )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_closing;
+	}
+	bool isReset( )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_reset;
+	}
+	void pumpDone( )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		m_nDone++;
+	}
+	bool isDone( )
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		return m_nDone == 2;
+	}
+
+private:
+	int				m_clientSock;
+	int				m_serverSock;
+	epicsMutex		m_mutex;
+	bool			m_closing;
+	bool			m_reset;
+	size_t			m_nDone;
+	Pump			m_down;
+	Pump			m_up;
+	std::tr1::shared_ptr<pvd::Thread>	m_downThread;
+	std::tr1::shared_ptr<pvd::Thread>	m_upThread;
+};
+
+void pvImpairProxy::Pump::run()
+{
+	const Config &			config		= m_proxy.m_config;
+	std::deque<Message>		queue;
+	size_t					queuedBytes	= 0;
+	std::string				rxBuf;
+	std::vector<char>		buf( 65536 );
+	bool					fParse		= m_fDownstream;
+	epicsUInt64				tLastDue	= 0;	// Keeps the stream in order under jitter
+	epicsUInt64				tNextSend	= 0;	// Earliest send allowed by the bandwidth cap
+	bool					fEof		= false;	// src closed, drain the queue then close
+	// A drop only shows as a gap once a later update of the same monitor arrives,
+	// so drops are held per ioid and counted when that update is sent
+	std::map<epicsUInt32, epicsUInt64>	pendingDrops;
+
+	while ( !m_conn.isClosing() && !( fEof && queue.empty() ) )
+	{
+		epicsUInt64	tNow		= epicsMonotonicGet();
+		int			timeoutMs	= 100;
+		if ( !queue.empty() )
+		{
+			epicsUInt64	tSend	= std::max( queue.front().tDue, tNextSend );
+			timeoutMs = tSend > tNow ? static_cast<int>( std::min<epicsUInt64>( 100, ( tSend - tNow + 999999 ) / 1000000 ) ) : 0;
+		}
+		struct pollfd	pfd;
+		pfd.fd		= m_src;
+		pfd.events	= POLLIN;
+		pfd.revents	= 0;
+		// Stop reading while backed up so a slow path pushes back on the sender through TCP
+		int		status	= poll( &pfd, !fEof && queuedBytes < maxQueuedBytes ? 1 : 0, timeoutMs );
+		if ( status < 0 && errno != EINTR )
+			break;
+
+		Stats	stats;
+		if ( status > 0 )
+		{
+			ssize_t	nRead	= recv( m_src, &buf[0], buf.size(), 0 );
+			if ( nRead < 0 && errno == EINTR )
+				continue;
+			if ( nRead < 0 )
+				break;
+			if ( nRead == 0 )
+				fEof = true;
+			rxBuf.append( &buf[0], nRead );
+
+			tNow = epicsMonotonicGet();
+			size_t	offset	= 0;
+			while ( offset < rxBuf.size() )
+			{
+				const unsigned char	*	p		= reinterpret_cast<const unsigned char *>( rxBuf.data() ) + offset;
+				size_t					msgLen	= rxBuf.size() - offset;
+				bool					fUpdate	= false;
+				epicsUInt32				ioid	= 0;
+				if ( fParse )
+				{
+					if ( msgLen < PVA_HEADER_SIZE )
+						break;
+					if ( p[0] != PVA_MAGIC )
+					{
+						// Not a PVA stream after all, forward the rest as is
+						std::cerr << "pvImpairProxy: Lost PVA message sync, no more drops on this connection" << std::endl;
+						fParse = false;
+						continue;
+					}
+					msgLen = pvaMessageLength( p );
+					if ( rxBuf.size() - offset < msgLen )
+						break;
+					fUpdate = isMonitorUpdate( p, msgLen );
+					if ( fUpdate )
+						ioid = pvaUInt32( p, p + PVA_HEADER_SIZE );
+				}
+				Message	msg;
+				msg.nDropsBefore	= 0;
+				if ( fUpdate )
+				{
+					stats.nUpdates++;
+					if ( config.dropFraction > 0.0 && uniform( m_seed ) < config.dropFraction )
+					{
+						pendingDrops[ioid]++;
+						offset += msgLen;
+						continue;
+					}
+					std::map<epicsUInt32, epicsUInt64>::iterator	itDrops	= pendingDrops.find( ioid );
+					if ( itDrops != pendingDrops.end() )
+					{
+						msg.nDropsBefore = itDrops->second;
+						pendingDrops.erase( itDrops );
+					}
+				}
+
+				msg.bytes.assign( rxBuf, offset, msgLen );
+				msg.fUpdate	= fUpdate;
+				msg.tDue	= tNow + static_cast<epicsUInt64>( ( config.delay + config.jitter * uniform( m_seed ) ) * 1.0e9 );
+				msg.tDue	= std::max( msg.tDue, tLastDue );
+				tLastDue	= msg.tDue;
+				queuedBytes	+= msgLen;
+				queue.push_back( msg );
+				offset += msgLen;
+			}
+			rxBuf.erase( 0, offset );
+		}
+
+		tNow = epicsMonotonicGet();
+		bool	fSendFailed	= false;
+		while ( !queue.empty() && queue.front().tDue <= tNow && tNextSend <= tNow )
+		{
+			const Message &	msg	= queue.front();
+			if ( !sendAll( m_dst, msg.bytes ) )
+			{
+				fSendFailed = true;
+				break;
+			}
+			if ( config.bandwidth > 0.0 )
+				tNextSend = std::max( tNextSend, tNow - std::min( tNow, bandwidthBurstNs ) ) + static_cast<epicsUInt64>( msg.bytes.size() / config.bandwidth * 1.0e9 );
+			if ( m_fDownstream )
+			{
+				stats.nMessages	+= fParse ? 1 : 0;
+				stats.nBytes	+= msg.bytes.size();
+				stats.nDropped	+= msg.nDropsBefore;
+			}
+			queuedBytes -= msg.bytes.size();
+			queue.pop_front();
+		}
+		if ( m_fDownstream )
+			m_proxy.addStats( stats );
+		if ( fSendFailed )
+			break;
+	}
+
+	// Updates still queued on a reset never reach the client, ground truth for the reset
+	if ( m_fDownstream )
+	{
+		Stats	stats;
+		for ( size_t i = 0; i < queue.size(); i++ )
+		{
+			if ( queue[i].fUpdate && m_conn.isReset() )
+				stats.nResetLost++;
+			stats.nDroppedUnseen += queue[i].nDropsBefore;
+		}
+		for ( std::map<epicsUInt32, epicsUInt64>::iterator it = pendingDrops.begin(); it != pendingDrops.end(); ++it )
+			stats.nDroppedUnseen += it->second;
+		m_proxy.addStats( stats );
+	}
+	m_conn.shutdown( false );
+	m_conn.pumpDone();
+}
+
+pvImpairProxy::pvImpairProxy( const Config & config )
+	:	m_config( config )
+	,	m_listenSock( -1 )
+	,	m_running( false )
+{
+	if ( m_config.delay < 0.0 )
+		m_config.delay = 0.0;
+	if ( m_config.jitter < 0.0 )
+		m_config.jitter = 0.0;
+	m_config.dropFraction = std::min( std::max( m_config.dropFraction, 0.0 ), 1.0 );
+}
+
+pvImpairProxy::~pvImpairProxy()
+{
+	stop();
+}
+
+void pvImpairProxy::start( )
+{
+	if ( m_running )
+		return;
+
+	struct sockaddr_in	upstreamAddr;
+	if ( !resolveAddress( m_config.upstream, upstreamAddr ) )
+		throw std::runtime_error( "pvImpairProxy: Invalid upstream address " + m_config.upstream );
+
+	m_listenSock = socket( AF_INET, SOCK_STREAM, 0 );
+	if ( m_listenSock < 0 )
+		throw std::runtime_error( std::string( "pvImpairProxy: socket failed, " ) + strerror( errno ) );
+	int	one	= 1;
+	setsockopt( m_listenSock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+	struct sockaddr_in	listenAddr;
+	memset( &listenAddr, 0, sizeof(listenAddr) );
+	listenAddr.sin_family		= AF_INET;
+	listenAddr.sin_addr.s_addr	= htonl( INADDR_LOOPBACK );
+	listenAddr.sin_port			= htons( m_config.listenPort );
+	if (	bind( m_listenSock, reinterpret_cast<struct sockaddr *>( &listenAddr ), sizeof(listenAddr) ) != 0
+		||	listen( m_listenSock, 64 ) != 0 )
+	{
+		std::ostringstream	msg;
+		msg << "pvImpairProxy: Unable to listen on port " << m_config.listenPort << ", " << strerror( errno );
+		close( m_listenSock );
+		m_listenSock = -1;
+		throw std::runtime_error( msg.str() );
+	}
+
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		m_stats		= Stats();
+		m_running	= true;
+	}
+	m_thread.reset( new pvd::Thread( pvd::Thread::Config()
+									.name( "pvImpairProxy" )
+									.autostart( true )
+									.run( this ) ) );
+}
+
+void pvImpairProxy::stop( )
+{
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		if ( !m_running )
+			return;
+		m_running = false;
+	}
+	if ( m_thread )
+		m_thread->exitWait();
+	m_thread.reset();
+	close( m_listenSock );
+	m_listenSock = -1;
+}
+
+pvImpairProxy::Stats pvImpairProxy::getStats( ) const
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	return m_stats;
+}
+
+void pvImpairProxy::addStats( const Stats & stats )
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	m_stats.nConnections	+= stats.nConnections;
+	m_stats.nResets			+= stats.nResets;
+	m_stats.nMessages		+= stats.nMessages;
+	m_stats.nBytes			+= stats.nBytes;
+	m_stats.nUpdates		+= stats.nUpdates;
+	m_stats.nDropped		+= stats.nDropped;
+	m_stats.nDroppedUnseen	+= stats.nDroppedUnseen;
+	m_stats.nResetLost		+= stats.nResetLost;
+}
+
+void pvImpairProxy::showStats( std::ostream & out ) const
+{
+	Stats	stats	= getStats();
+	out	<< "pvImpairProxy: " << stats.nConnections << " connections, " << stats.nResets << " resets, "
+		<< stats.nMessages << " messages, " << stats.nBytes << " bytes, "
+		<< stats.nUpdates << " monitor updates, " << stats.nDropped << " dropped, "
+		<< stats.nDroppedUnseen << " dropped unseen, "
+		<< stats.nResetLost << " lost to resets" << std::endl;
+}
+
+/// run accepts client connections, reaps closed ones and resets them at random
+void pvImpairProxy::run()
+{
+	unsigned	seed		= m_config.seed;
+	epicsUInt64	tNextReset	= 0;
+	if ( m_config.resetPeriod > 0.0 )
+		tNextReset = epicsMonotonicGet() + static_cast<epicsUInt64>( -log( 1.0 - uniform( seed ) ) * m_config.resetPeriod * 1.0e9 );
+
+	for ( ;; )
+	{
+		{
+			epicsGuard<epicsMutex>	guard( m_mutex );
+			if ( !m_running )
+				break;
+		}
+
+		struct pollfd	pfd;
+		pfd.fd		= m_listenSock;
+		pfd.events	= POLLIN;
+		pfd.revents	= 0;
+		Stats	stats;
+		if ( poll( &pfd, 1, 100 ) > 0 )
+		{
+			int	clientSock	= accept( m_listenSock, NULL, NULL );
+			if ( clientSock >= 0 )
+			{
+				struct sockaddr_in	upstreamAddr;
+				int	serverSock	= socket( AF_INET, SOCK_STREAM, 0 );
+				if (	serverSock < 0
+					||	!resolveAddress( m_config.upstream, upstreamAddr )
+					||	connect( serverSock, reinterpret_cast<struct sockaddr *>( &upstreamAddr ), sizeof(upstreamAddr) ) != 0 )
+				{
+					std::cerr << "pvImpairProxy: Unable to connect to " << m_config.upstream << ", " << strerror( errno ) << std::endl;
+					if ( serverSock >= 0 )
+						close( serverSock );
+					close( clientSock );
+				}
+				else
+				{
+					// Timing is the proxy's to decide, don't let Nagle add its own delay
+					setNoDelay( clientSock );
+					setNoDelay( serverSock );
+					seed += 2;
+					m_connections.push_back( std::tr1::shared_ptr<Connection>( new Connection( *this, clientSock, serverSock, seed ) ) );
+					stats.nConnections++;
+				}
+			}
+		}
+
+		for ( std::list<std::tr1::shared_ptr<Connection> >::iterator it = m_connections.begin(); it != m_connections.end(); )
+		{
+			if ( (*it)->isDone() )
+				it = m_connections.erase( it );
+			else
+				++it;
+		}
+
+		if ( tNextReset && epicsMonotonicGet() >= tNextReset )
+		{
+			std::vector<Connection *>	open;
+			for ( std::list<std::tr1::shared_ptr<Connection> >::iterator it = m_connections.begin(); it != m_connections.end(); ++it )
+				if ( !(*it)->isClosing() )
+					open.push_back( it->get() );
+			if ( !open.empty() )
+			{
+				open[ static_cast<size_t>( uniform( seed ) * open.size() ) ]->shutdown( true );
+				stats.nResets++;
+			}
+			tNextReset += static_cast<epicsUInt64>( -log( 1.0 - uniform( seed ) ) * m_config.resetPeriod * 1.0e9 );
+		}
+		addStats( stats );
+	}
+
+	// Connection destructors join their pumps
+	m_connections.clear();
+}
@@ -0,0 +1,110 @@
+#ifndef PVIMPAIRPROXY_H
+#define PVIMPAIRPROXY_H
+
+#include <list>
+#include <string>
+#include <iostream>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <pv/thread.h>
+#include <pv/sharedPtr.h>
+
+/// pvImpairProxy
+/// TCP forwarding stand-in between pvAccess clients and one server, for
+/// benchmarking missed update detection.  Each accepted client connection gets
+/// its own upstream connection and two forwarding threads.  Forwarded messages
+/// can be delayed w/ random jitter and held to a bandwidth cap, in order, and
+/// connections can be reset at random.  Server to client monitor updates can be
+/// dropped whole, at PVA message boundaries, so the client stays in sync with the
+/// stream and only sees a missing update.  Everything injected is counted as the
+/// ground truth to compare the client's missed counts against.
+/// Not for pipelined monitors, a dropped update is never acked.
+class pvImpairProxy : public epicsThreadRunable
+{
+public:		// Public types
+	struct Config
+	{
+		unsigned		listenPort;		// Loopback TCP port clients connect to
+		std::string		upstream;		// Server address, host:port
+		double			delay;			// Seconds added to each message, both directions
+		double			jitter;			// Max random seconds added to delay, order is kept
+		double			bandwidth;		// Bytes/sec per connection and direction, 0 for no cap
+		double			resetPeriod;	// Mean seconds between connection resets, 0 for none
+		double			dropFraction;	// Fraction of monitor updates dropped
+		unsigned		seed;			// Random seed, for repeatable runs
+
+		Config()
+			:	listenPort( 5077 )
+			,	upstream( "127.0.0.1:5075" )
+			,	delay( 0.0 )
+			,	jitter( 0.0 )
+			,	bandwidth( 0.0 )
+			,	resetPeriod( 0.0 )
+			,	dropFraction( 0.0 )
+			,	seed( 1 )
+		{
+		}
+	};
+
+	/// Cumulative counts since start(), the ground truth for loss detection
+	struct Stats
+	{
+		epicsUInt64		nConnections;	// Client connections accepted
+		epicsUInt64		nResets;		// Connections reset on purpose
+		epicsUInt64		nMessages;		// Server to client PVA messages forwarded
+		epicsUInt64		nBytes;			// Server to client bytes forwarded
+		epicsUInt64		nUpdates;		// Monitor updates seen, forwarded or dropped
+		epicsUInt64		nDropped;		// Monitor updates dropped on purpose and followed by
+										// a later update of the same monitor, so a client can see the gap
+		epicsUInt64		nDroppedUnseen;	// Dropped w/o a later update reaching the client
+		epicsUInt64		nResetLost;		// Monitor updates queued when a connection was reset
+
+		Stats()
+			:	nConnections( 0 ), nResets( 0 ), nMessages( 0 ), nBytes( 0 )
+			,	nUpdates( 0 ), nDropped( 0 ), nDroppedUnseen( 0 ), nResetLost( 0 )
+		{
+		}
+	};
+
+public:		// Public member functions
+	explicit pvImpairProxy( const Config & config );
+	virtual ~pvImpairProxy();
+
+	/// start listening and starts the accept thread, throws on socket errors
+	void start( );
+	/// stop closes all connections and joins all threads
+	void stop( );
+
+	Stats	getStats( ) const;
+	void	showStats( std::ostream & out ) const;
+
+	const Config & getConfig( ) const
+	{
+		return m_config;
+	}
+
+	virtual void run();
+
+private:	// Private types
+	class Connection;
+	class Pump;
+	friend class Pump;
+
+private:	// Private member functions
+	void	addStats( const Stats & stats );
+
+private:	// Private member variables
+	Config									m_config;
+	int										m_listenSock;
+	std::list<std::tr1::shared_ptr<Connection> >	m_connections;	// accept thread only
+	std::tr1::shared_ptr<epics::pvData::Thread>		m_thread;
+	mutable epicsMutex						m_mutex;
+	bool									m_running;
+	Stats									m_stats;
+
+	EPICS_NOT_COPYABLE(pvImpairProxy)
+};
+
+#endif // PVIMPAIRPROXY_H
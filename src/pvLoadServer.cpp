@@ -0,0 +1,274 @@
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <math.h>
+
+#include <epicsGuard.h>
+#include <epicsTime.h>
+#include <pv/pvData.h>
+#include <pv/configuration.h>
+#include <pv/ntscalar.h>
+#include <pv/ntscalarArray.h>
+
+#include "pvLoadServer.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+pvLoadServer::pvLoadServer( const Config & config )
+	:	m_config( config )
+	,	m_provider( "pvLoadServer" )
+	,	m_running( false )
+	,	m_nPosts( 0 )
+	,	m_nTicks( 0 )
+	,	m_nLateTicks( 0 )
+	,	m_tickNs( 0 )
+{
+	if ( m_config.rate <= 0.0 )
+		m_config.rate = 1.0;
+	if ( m_config.tickRate <= 0.0 )
+		m_config.tickRate = m_config.rate;
+	if ( m_config.circBuffSize < 1 )
+		m_config.circBuffSize = 1;
+
+	char	pvName[256];
+	for ( size_t i = 0; i < m_config.nCounters; i++ )
+	{
+		snprintf( pvName, sizeof(pvName), "%sCount%02u", m_config.prefix.c_str(), static_cast<unsigned int>(i) );
+		addPV( pvName, false );
+	}
+	for ( size_t i = 0; i < m_config.nCircBuffs; i++ )
+	{
+		snprintf( pvName, sizeof(pvName), "%sCircBuff%u", m_config.prefix.c_str(), static_cast<unsigned int>(i) );
+		addPV( pvName, true );
+	}
+	addStatsPV( m_config.prefix + "Stats:Posts" );
+	addStatsPV( m_config.prefix + "Stats:PostRate" );
+	addStatsPV( m_config.prefix + "Stats:LateTicks" );
+	addStatsPV( m_config.prefix + "Stats:TickTime" );
+}
+
+pvLoadServer::~pvLoadServer()
+{
+	stop();
+}
+
+/// initPV looks up the fields of a new LoadPV's value and opens its SharedPV
+void pvLoadServer::initPV( LoadPV & loadPV )
+{
+	loadPV.scalarField	= loadPV.value->getSubField<pvd::PVScalar>( "value" );
+	loadPV.arrayField	= loadPV.value->getSubField<pvd::PVScalarArray>( "value" );
+	loadPV.secField		= loadPV.value->getSubFieldT<pvd::PVScalar>( "timeStamp.secondsPastEpoch" );
+	loadPV.nsecField	= loadPV.value->getSubFieldT<pvd::PVScalar>( "timeStamp.nanoseconds" );
+	loadPV.changed.set( loadPV.value->getSubFieldT<pvd::PVField>( "value" )->getFieldOffset() );
+	loadPV.changed.set( loadPV.value->getSubFieldT<pvd::PVField>( "timeStamp" )->getFieldOffset() );
+	loadPV.ringNext	= 0;
+	loadPV.count	= 0.0;
+	loadPV.pv		= pvas::SharedPV::buildReadOnly();
+	loadPV.pv->open( *loadPV.value );
+}
+
+void pvLoadServer::addPV( const std::string & pvName, bool fCircBuff )
+{
+	LoadPV	loadPV;
+	if ( fCircBuff )
+	{
+		loadPV.value = epics::nt::NTScalarArray::createBuilder()->value( m_config.type )->addAlarm()->addTimeStamp()->createPVStructure();
+		loadPV.ring.assign( m_config.circBuffSize, 0.0 );
+	}
+	else
+		loadPV.value = epics::nt::NTScalar::createBuilder()->value( m_config.type )->addAlarm()->addTimeStamp()->createPVStructure();
+	initPV( loadPV );
+	m_provider.add( pvName, loadPV.pv );
+	m_pvs.push_back( loadPV );
+	m_pvNames.push_back( pvName );
+}
+
+void pvLoadServer::addStatsPV( const std::string & pvName )
+{
+	LoadPV	loadPV;
+	loadPV.value = epics::nt::NTScalar::createBuilder()->value( pvd::pvDouble )->addAlarm()->addTimeStamp()->createPVStructure();
+	initPV( loadPV );
+	m_provider.add( pvName, loadPV.pv );
+	m_stats.push_back( loadPV );
+}
+
+void pvLoadServer::start( )
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	if ( m_running )
+		return;
+
+	pva::ConfigurationBuilder	builder;
+	builder.push_env();
+	if ( m_config.serverPort )
+		builder.add( "EPICS_PVAS_SERVER_PORT", m_config.serverPort );
+	if ( m_config.broadcastPort )
+		builder.add( "EPICS_PVAS_BROADCAST_PORT", m_config.broadcastPort );
+	if ( !m_config.intfAddrList.empty() )
+		builder.add( "EPICS_PVAS_INTF_ADDR_LIST", m_config.intfAddrList );
+	builder.push_map();
+	m_server = pva::ServerContext::create( pva::ServerContext::Config()
+											.config( builder.build() )
+											.provider( m_provider.provider() ) );
+
+	m_running = true;
+	m_thread.reset( new pvd::Thread( pvd::Thread::Config()
+									.name( "pvLoadServer" )
+									.prio( epicsThreadPriorityHigh )
+									.autostart( true )
+									.run( this ) ) );
+}
+
+void pvLoadServer::stop( )
+{
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		if ( !m_running )
+			return;
+		m_running = false;
+	}
+	m_wakeup.signal();
+	if ( m_thread )
+		m_thread->exitWait();
+	m_thread.reset();
+	if ( m_server )
+		m_server->shutdown();
+	m_server.reset();
+}
+
+unsigned pvLoadServer::getServerPort( ) const
+{
+	return m_server ? static_cast<unsigned>( m_server->getServerPort() ) : 0;
+}
+
+epicsUInt64 pvLoadServer::getNumPosts( ) const
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	return m_nPosts;
+}
+
+epicsUInt64 pvLoadServer::getNumTicks( ) const
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	return m_nTicks;
+}
+
+epicsUInt64 pvLoadServer::getNumLateTicks( ) const
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	return m_nLateTicks;
+}
+
+void pvLoadServer::showStats( std::ostream & out ) const
+{
+	epicsGuard<epicsMutex>	guard( m_mutex );
+	out	<< "pvLoadServer: " << m_pvs.size() << " PVs, " << m_nPosts << " posts, "
+		<< m_nTicks << " ticks, " << m_nLateTicks << " late ticks, "
+		<< std::fixed << std::setprecision(3)
+		<< ( m_nTicks ? m_tickNs * 1.0e-6 / m_nTicks : 0.0 ) << " ms/tick" << std::endl;
+	out.unsetf( std::ios::fixed );
+}
+
+/// post the next value of one counter or circular buffer
+void pvLoadServer::post( LoadPV & loadPV, const epicsTimeStamp & stamp )
+{
+	loadPV.count += 1.0;
+	if ( loadPV.ring.empty() )
+		loadPV.scalarField->putFrom<double>( loadPV.count );
+	else
+	{
+		// Oldest first, newest value last
+		loadPV.ring[loadPV.ringNext] = loadPV.count;
+		loadPV.ringNext = ( loadPV.ringNext + 1 ) % loadPV.ring.size();
+		pvd::shared_vector<double>	values( loadPV.ring.size() );
+		for ( size_t i = 0; i < loadPV.ring.size(); i++ )
+			values[i] = loadPV.ring[ ( loadPV.ringNext + i ) % loadPV.ring.size() ];
+		loadPV.arrayField->putFrom<double>( pvd::freeze( values ) );
+	}
+	loadPV.secField->putFrom<epicsUInt64>( stamp.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH );
+	loadPV.nsecField->putFrom<epicsUInt32>( stamp.nsec );
+	loadPV.pv->post( *loadPV.value, loadPV.changed );
+}
+
+void pvLoadServer::postStats( const epicsTimeStamp & stamp, double elapsed )
+{
+	double	values[4];
+	{
+		epicsGuard<epicsMutex>	guard( m_mutex );
+		values[0] = static_cast<double>( m_nPosts );
+		values[1] = elapsed > 0.0 ? m_nPosts / elapsed : 0.0;
+		values[2] = static_cast<double>( m_nLateTicks );
+		values[3] = m_nTicks ? m_tickNs * 1.0e-6 / m_nTicks : 0.0;
+	}
+	for ( size_t i = 0; i < m_stats.size() && i < 4; i++ )
+	{
+		LoadPV	&	loadPV	= m_stats[i];
+		loadPV.scalarField->putFrom<double>( values[i] );
+		loadPV.secField->putFrom<epicsUInt64>( stamp.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH );
+		loadPV.nsecField->putFrom<epicsUInt32>( stamp.nsec );
+		loadPV.pv->post( *loadPV.value, loadPV.changed );
+	}
+}
+
+/// run is the timer thread
+/// Each tick posts every update due since the last tick for all PVs, so a
+/// rate above tickRate posts several updates per PV per tick.  Updates
+/// within a tick get timestamps 1/rate apart, ending at the tick time.
+void pvLoadServer::run()
+{
+	const double		tickPeriod	= 1.0 / m_config.tickRate;
+	const epicsUInt64	tStart		= epicsMonotonicGet();
+	double				tNext		= 0.0;	// Next tick, sec since tStart
+	double				tStats		= 1.0;	// Next stats post, sec since tStart
+	epicsUInt64			nUpdates	= 0;	// Updates posted so far for each PV
+
+	for ( ;; )
+	{
+		{
+			epicsGuard<epicsMutex>	guard( m_mutex );
+			if ( !m_running )
+				break;
+		}
+		double	tNow	= ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+		if ( tNow < tNext )
+		{
+			m_wakeup.wait( tNext - tNow );
+			continue;
+		}
+		bool	fLate	= tNow - tNext > tickPeriod;
+		tNext += tickPeriod;
+		if ( fLate )
+			tNext = tNow + tickPeriod;	// Don't burst to catch up on ticks, the updates catch up below
+
+		epicsTimeStamp	tickStamp;
+		epicsTimeGetCurrent( &tickStamp );
+		epicsUInt64		nDue	= static_cast<epicsUInt64>( tNow * m_config.rate ) + 1;
+		epicsUInt64		nPosts	= 0;
+		for ( ; nUpdates < nDue; nUpdates++ )
+		{
+			epicsTimeStamp	stamp	= tickStamp;
+			epicsTimeAddSeconds( &stamp, -static_cast<double>( nDue - 1 - nUpdates ) / m_config.rate );
+			for ( size_t i = 0; i < m_pvs.size(); i++ )
+				post( m_pvs[i], stamp );
+			nPosts += m_pvs.size();
+		}
+		epicsUInt64	tickNs	= epicsMonotonicGet() - tStart - static_cast<epicsUInt64>( tNow * 1.0e9 );
+
+		{
+			epicsGuard<epicsMutex>	guard( m_mutex );
+			m_nPosts	+= nPosts;
+			m_nTicks++;
+			m_tickNs	+= tickNs;
+			if ( fLate )
+				m_nLateTicks++;
+		}
+
+		if ( tNow >= tStats )
+		{
+			postStats( tickStamp, tNow );
+			tStats += 1.0;
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#ifndef PVLOADSERVER_H
+#define PVLOADSERVER_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <pv/thread.h>
+#include <pv/pvData.h>
+#include <pv/sharedPtr.h>
+#include <pv/serverContext.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+/// pvLoadServer
+/// Synthetic pvAccess load server, a local stand-in for the loadServer IOC.
+/// Serves <prefix>CountNN counters and <prefix>CircBuffN circular buffer waveforms
+/// from SharedPVs.  One timer thread posts all due updates per tick, w/ each
+/// PV's updates within a tick timestamped 1/rate apart, ending at the tick time,
+/// and publishes its own send statistics as <prefix>Stats:* PVs.
+class pvLoadServer : public epicsThreadRunable
+{
+public:		// Public types
+	struct Config
+	{
+		std::string					prefix;			// PV name prefix, ex. PVA:GW:TEST:00:
+		size_t						nCounters;		// Number of <prefix>CountNN PVs
+		size_t						nCircBuffs;		// Number of <prefix>CircBuffN PVs
+		size_t						circBuffSize;	// Elements per circular buffer
+		double						rate;			// Updates per sec for each PV
+		double						tickRate;		// Timer ticks per sec, updates are batched per tick
+		epics::pvData::ScalarType	type;			// Value type of counters and circular buffers
+		unsigned					serverPort;		// EPICS_PVAS_SERVER_PORT, 0 for the environment's
+		unsigned					broadcastPort;	// EPICS_PVAS_BROADCAST_PORT, 0 for the environment's
+		std::string					intfAddrList;	// EPICS_PVAS_INTF_ADDR_LIST, empty for the environment's
+
+		Config()
+			:	prefix( "PVA:GW:TEST:00:" )
+			,	nCounters( 100 )
+			,	nCircBuffs( 0 )
+			,	circBuffSize( 1 )
+			,	rate( 100.0 )
+			,	tickRate( 100.0 )
+			,	type( epics::pvData::pvDouble )
+			,	serverPort( 0 )
+			,	broadcastPort( 0 )
+		{
+		}
+	};
+
+public:		// Public member functions
+	explicit pvLoadServer( const Config & config );
+	virtual ~pvLoadServer();
+
+	/// start serves the PVs and starts the timer thread
+	void start( );
+	/// stop the timer thread and shut down the server
+	void stop( );
+
+	/// Send statistics
+	epicsUInt64	getNumPosts( ) const;
+	epicsUInt64	getNumTicks( ) const;
+	epicsUInt64	getNumLateTicks( ) const;
+	size_t		getNumPVs( ) const
+	{
+		return m_pvs.size();
+	}
+	const std::vector<std::string> & getPVNames( ) const
+	{
+		return m_pvNames;
+	}
+	unsigned	getServerPort( ) const;
+
+	void showStats( std::ostream & out ) const;
+
+	virtual void run();
+
+private:	// Private types
+	struct LoadPV
+	{
+		epics::pvData::PVStructurePtr	value;
+		epics::pvData::BitSet			changed;
+		pvas::SharedPV::shared_pointer	pv;
+		// Fields of value, looked up once
+		std::tr1::shared_ptr<epics::pvData::PVScalar>		scalarField;	// NULL for circular buffers
+		std::tr1::shared_ptr<epics::pvData::PVScalarArray>	arrayField;		// NULL for counters
+		std::tr1::shared_ptr<epics::pvData::PVScalar>		secField;
+		std::tr1::shared_ptr<epics::pvData::PVScalar>		nsecField;
+		std::vector<double>				ring;		// Circular buffer contents, empty for counters
+		size_t							ringNext;	// Next ring element to replace
+		double							count;		// Last counter value posted
+	};
+
+private:	// Private member functions
+	void addPV( const std::string & pvName, bool fCircBuff );
+	void addStatsPV( const std::string & pvName );
+	static void initPV( LoadPV & loadPV );
+	void post( LoadPV & loadPV, const epicsTimeStamp & stamp );
+	void postStats( const epicsTimeStamp & stamp, double elapsed );
+
+private:	// Private member variables
+	Config								m_config;
+	std::vector<LoadPV>					m_pvs;
+	std::vector<LoadPV>					m_stats;	// Posts, PostRate, LateTicks, TickTime
+	std::vector<std::string>			m_pvNames;
+	pvas::StaticProvider				m_provider;
+	epics::pvAccess::ServerContext::shared_pointer	m_server;
+	std::tr1::shared_ptr<epics::pvData::Thread>		m_thread;
+	epicsEvent							m_wakeup;
+	mutable epicsMutex					m_mutex;
+	bool								m_running;
+	epicsUInt64							m_nPosts;
+	epicsUInt64							m_nTicks;
+	epicsUInt64							m_nLateTicks;
+	epicsUInt64							m_tickNs;	// Cumulative ns spent posting
+
+	EPICS_NOT_COPYABLE(pvLoadServer)
+};
+
+#endif // PVLOADSERVER_H
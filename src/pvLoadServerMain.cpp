@@ -0,0 +1,280 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <stdio.h>
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <pv/pvData.h>
+#include <pv/pvAccess.h>
+#include <pv/logger.h>
+
+#include "pvLoadServer.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvLoadServer"
+#endif
+
+#define PV_LOADSERVER_MAJOR_VERSION			0
+#define PV_LOADSERVER_MINOR_VERSION			1
+#define PV_LOADSERVER_MAINTENANCE_VERSION	0
+#define PV_LOADSERVER_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool		debugFlag	= false;
+double		runTime		= 0.0;		// Seconds to run, 0 runs until signaled
+double		statsPeriod	= 10.0;		// Seconds between stats lines, 0 for none
+epicsEvent	doneEvt;
+bool		abortFlag	= false;
+
+void alldone(int num)
+{
+    (void)num;
+    abortFlag = true;
+    doneEvt.signal();
+}
+
+void usage (void)
+{
+    pvLoadServer::Config	defaults;
+    fprintf( stdout, "\nUsage: " EXECNAME " [options]\n"
+    "\n"
+    "Synthetic pvAccess load server, a local stand-in for the loadServer IOC.\n"
+    "Serves <prefix>CountNN counters and <prefix>CircBuffN circular buffers,\n"
+    "plus send statistics in <prefix>Stats:Posts, PostRate, LateTicks and TickTime.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -P <prefix>:       PV name prefix, default is '%s'\n"
+    "  -n <count>:        Number of counters, default is %u\n"
+    "  -c <count>:        Number of circular buffers, default is %u\n"
+    "  -s <size>:         Circular buffer size, default is %u\n"
+    "  -r <rate>:         Updates per sec for each PV, default is %.1f\n"
+    "  -k <rate>:         Timer ticks per sec, updates are batched per tick, default is the update rate\n"
+    "  -t <type>:         Value type, ex. double, int, ushort.  default is double\n"
+    "  -p <port>:         EPICS_PVAS_SERVER_PORT, default from the environment\n"
+    "  -b <port>:         EPICS_PVAS_BROADCAST_PORT, default from the environment\n"
+    "  -i <addr list>:    EPICS_PVAS_INTF_ADDR_LIST, ex. 127.0.0.1 for local only tests\n"
+    "  -L <file>:         Write the served counter and circular buffer names to <file>, ex. for pvCapture -f\n"
+    "  -T <sec>:          Run for <sec> seconds, default runs until signaled\n"
+    "  -S <sec>:          Seconds between stats lines, 0 for none.  default is %.0f\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -P PVA:GW:TEST:00: -n 100 -r 100\n\n"
+             , defaults.prefix.c_str(), static_cast<unsigned int>(defaults.nCounters),
+             static_cast<unsigned int>(defaults.nCircBuffs), static_cast<unsigned int>(defaults.circBuffSize),
+             defaults.rate, statsPeriod );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+    pvLoadServer::Config    config;
+    std::string             listFilename;
+    bool                    fTickRate = false;
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVP:n:c:s:r:k:t:p:b:i:L:T:S:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_LOADSERVER_MAJOR_VERSION,
+                                PV_LOADSERVER_MINOR_VERSION,
+                                PV_LOADSERVER_MAINTENANCE_VERSION,
+                                PV_LOADSERVER_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 'P':
+            config.prefix = optarg;
+            break;
+        case 'n':
+        case 'c':
+        case 's':
+        {
+            unsigned int    count;
+            if ( sscanf( optarg, "%u", &count ) != 1 || ( opt == 's' && count == 0 ) )
+            {
+                fprintf(stderr, "'%s' is not a valid count for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 'n' )
+                config.nCounters = count;
+            else if ( opt == 'c' )
+                config.nCircBuffs = count;
+            else
+                config.circBuffSize = count;
+        }
+            break;
+        case 'r':
+        case 'k':
+        {
+            double  rate;
+            if ( epicsScanDouble( optarg, &rate ) != 1 || rate <= 0.0 )
+            {
+                fprintf(stderr, "'%s' is not a valid rate for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 'r' )
+                config.rate = rate;
+            else
+            {
+                config.tickRate = rate;
+                fTickRate = true;
+            }
+        }
+            break;
+        case 't':
+            try
+            {
+                pvd::ScalarType type = pvd::ScalarTypeFunc::getScalarType( optarg );
+                if ( type == pvd::pvBoolean || type == pvd::pvString )
+                    fprintf(stderr, "'%s' is not a numeric type "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                else
+                    config.type = type;
+            }
+            catch ( std::exception & )
+            {
+                fprintf(stderr, "'%s' is not a valid ScalarType "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            }
+            break;
+        case 'p':
+        case 'b':
+        {
+            unsigned int    port;
+            if ( sscanf( optarg, "%u", &port ) != 1 || port == 0 || port > 65535 )
+            {
+                fprintf(stderr, "'%s' is not a valid port "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            }
+            else if ( opt == 'p' )
+                config.serverPort = port;
+            else
+                config.broadcastPort = port;
+        }
+            break;
+        case 'i':
+            config.intfAddrList = optarg;
+            break;
+        case 'L':
+            listFilename = optarg;
+            break;
+        case 'T':
+        case 'S':
+        {
+            double  sec;
+            if ( epicsScanDouble( optarg, &sec ) != 1 || sec < 0.0 )
+            {
+                fprintf(stderr, "'%s' is not a valid time for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 'T' )
+                runTime = sec;
+            else
+                statsPeriod = sec;
+        }
+            break;
+        case 'd':               /* Debug log level */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+    if ( !fTickRate )
+        config.tickRate = config.rate;
+
+    SET_LOG_LEVEL(debugFlag ? pva::logLevelDebug : pva::logLevelError);
+
+    pvLoadServer    server( config );
+    if ( !listFilename.empty() )
+    {
+        std::ofstream   fout( listFilename.c_str() );
+        const std::vector<std::string> &    pvNames = server.getPVNames();
+        for ( size_t i = 0; i < pvNames.size(); i++ )
+            fout << pvNames[i] << std::endl;
+    }
+
+    signal(SIGINT,  alldone);
+    signal(SIGTERM, alldone);
+    signal(SIGQUIT, alldone);
+
+    server.start();
+    std::cout << EXECNAME ": Serving " << server.getNumPVs() << " PVs w/ prefix " << config.prefix
+              << " at " << config.rate << " Hz, " << config.tickRate << " ticks/sec, TCP port "
+              << server.getServerPort() << std::endl;
+
+    // ========================== Run until signaled or runTime elapses
+
+    epicsUInt64 tStart  = epicsMonotonicGet();
+    double      tStats  = statsPeriod;
+    while ( !abortFlag )
+    {
+        double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+        if ( runTime > 0.0 && elapsed >= runTime )
+            break;
+        double  wait    = 1.0;
+        if ( runTime > 0.0 && runTime - elapsed < wait )
+            wait = runTime - elapsed;
+        if ( statsPeriod > 0.0 )
+        {
+            if ( elapsed >= tStats )
+            {
+                server.showStats( std::cout );
+                tStats += statsPeriod;
+            }
+            if ( tStats - elapsed < wait )
+                wait = tStats - elapsed;
+        }
+        doneEvt.wait( wait );
+    }
+
+    server.stop();
+    server.showStats( std::cout );
+
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
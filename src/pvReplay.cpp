@@ -0,0 +1,486 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <pv/pvData.h>
+#include <pv/logger.h>
+#include <pv/configuration.h>
+#include <pv/serverContext.h>
+#include <pv/ntscalar.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+#include "pvCaptureFile.h"
+#include "pvHistogram.h"
+
+#ifndef EXECNAME
+#define EXECNAME "pvReplay"
+#endif
+
+#define PV_REPLAY_MAJOR_VERSION			0
+#define PV_REPLAY_MINOR_VERSION			1
+#define PV_REPLAY_MAINTENANCE_VERSION	0
+#define PV_REPLAY_DEVELOPMENT_FLAG		1
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+bool            debugFlag       = false;
+double          replaySpeed     = 1.0;      // 1 for original timing, N for N times faster, 0 for as fast as possible
+size_t          nLoops          = 1;        // Times through the recording, 0 loops until signaled
+bool            keepTimeStamps  = false;    // Post the recorded timeStamps instead of the replay time
+bool            continueCounts  = false;    // Offset values each loop so counters keep incrementing
+std::string     pvPrefix;                   // Prepended to each recorded pvName
+pvd::ScalarType valueType       = pvd::pvDouble;
+double          statsPeriod     = 10.0;     // Seconds between progress lines, 0 for none
+bool            abortFlag       = false;
+epicsEvent      abortEvt;
+
+void alldone(int num)
+{
+    (void)num;
+    abortFlag = true;
+    abortEvt.signal();
+}
+
+// This could go to it's own cpp file and header
+/// ReplayPV
+/// One recorded series, served from a read only SharedPV as an NTScalar
+struct ReplayPV
+{
+    ReplayPV( const std::string & pvName, const std::vector<pvCaptureSample> & samples )
+        :m_pvName( pvName )
+        ,m_samples( samples )
+        ,m_valueStep( 0.0 )
+        ,m_nPosted( 0 )
+    {
+        // Capture files are in arrival order, replay them in timestamp order
+        std::stable_sort( m_samples.begin(), m_samples.end() );
+        if ( !m_samples.empty() )
+            m_valueStep = m_samples.back().value - m_samples.front().value + 1.0;
+        m_value = epics::nt::NTScalar::createBuilder()->value( valueType )->addAlarm()->addTimeStamp()->createPVStructure();
+        m_valueField    = m_value->getSubFieldT<pvd::PVScalar>( "value" );
+        m_secField      = m_value->getSubFieldT<pvd::PVScalar>( "timeStamp.secondsPastEpoch" );
+        m_nsecField     = m_value->getSubFieldT<pvd::PVScalar>( "timeStamp.nanoseconds" );
+        m_changed.set( m_valueField->getFieldOffset() );
+        m_changed.set( m_value->getSubFieldT<pvd::PVField>( "timeStamp" )->getFieldOffset() );
+        m_pv = pvas::SharedPV::buildReadOnly();
+        m_pv->open( *m_value );
+    }
+
+    /// post sample iSample of loop iLoop
+    void post( size_t iSample, size_t iLoop )
+    {
+        const pvCaptureSample & sample = m_samples[iSample];
+        double  value   = sample.value;
+        if ( continueCounts )
+            value += iLoop * m_valueStep;
+        m_valueField->putFrom<double>( value );
+        if ( keepTimeStamps )
+        {
+            // Capture files hold POSIX seconds, same as pvData timeStamps
+            m_secField->putFrom<epicsUInt32>( sample.sec );
+            m_nsecField->putFrom<epicsUInt32>( sample.nsec );
+        }
+        else
+        {
+            epicsTimeStamp  tsNow;
+            epicsTimeGetCurrent( &tsNow );
+            // pvData timeStamps count from the POSIX epoch
+            m_secField->putFrom<epicsUInt64>( tsNow.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH );
+            m_nsecField->putFrom<epicsUInt32>( tsNow.nsec );
+        }
+        m_pv->post( *m_value, m_changed );
+        m_nPosted++;
+    }
+
+    std::string                         m_pvName;
+    std::vector<pvCaptureSample>        m_samples;
+    double                              m_valueStep;    // Value increase per loop w/ -c
+    size_t                              m_nPosted;
+    pvd::PVStructurePtr                 m_value;
+    pvd::BitSet                         m_changed;
+    std::tr1::shared_ptr<pvd::PVScalar> m_valueField;
+    std::tr1::shared_ptr<pvd::PVScalar> m_secField;
+    std::tr1::shared_ptr<pvd::PVScalar> m_nsecField;
+    pvas::SharedPV::shared_pointer      m_pv;
+};
+
+/// One scheduled post: seconds from the start of the recording, PV index, sample index
+struct ReplayEvent
+{
+    double      offset;
+    size_t      iPV;
+    size_t      iSample;
+    bool operator>( const ReplayEvent & other ) const
+    {
+        return offset > other.offset;
+    }
+};
+
+/// addCaptureFiles appends path, or the .pvCapture and .caCapture files in it if it's a directory,
+/// text or pvCaptureConvert binary
+void addCaptureFiles( const std::string & path, std::vector<std::string> & filePaths )
+{
+    struct stat fileStat;
+    if ( stat( path.c_str(), &fileStat ) != 0 || !S_ISDIR( fileStat.st_mode ) )
+    {
+        filePaths.push_back( path );
+        return;
+    }
+    DIR *   dir = opendir( path.c_str() );
+    if ( dir == NULL )
+    {
+        std::cerr << "Unable to read directory " << path << std::endl;
+        return;
+    }
+    std::vector<std::string>    names;
+    for ( struct dirent * entry = readdir( dir ); entry != NULL; entry = readdir( dir ) )
+        if ( pvCaptureFile::isCaptureFileName( entry->d_name ) || pvCaptureFile::isBinaryFileName( entry->d_name ) )
+            names.push_back( path + "/" + entry->d_name );
+    closedir( dir );
+    std::sort( names.begin(), names.end() );
+    for ( size_t i = 0; i < names.size(); i++ )
+    {
+        // Replay the binary copy of a converted file instead of the text
+        if (    pvCaptureFile::isCaptureFileName( names[i] )
+            &&  std::binary_search( names.begin(), names.end(), pvCaptureFile::binaryFileName( names[i] ) ) )
+            continue;
+        filePaths.push_back( names[i] );
+    }
+}
+
+void usage (void)
+{
+    fprintf( stdout, "\nUsage: " EXECNAME " [options] <file or dir>...\n"
+    "\n"
+    "Replays captured .pvCapture, .caCapture and pvGet files as PVs from a local pvAccess server.\n"
+    "All PVs share one time axis starting at the earliest sample, so each PV keeps its\n"
+    "recorded inter-arrival pattern and its alignment w/ the other PVs.\n"
+    "A directory replays all the .pvCapture and .caCapture files in it, or their\n"
+    "pvCaptureConvert binary copies.\n"
+    "\n"
+    "options:\n"
+    "  -h:                Help: Print this message\n"
+    "  -V:                Print version and exit\n"
+    "  -s <speed>:        1 for original timing, N for N times faster, 0 for as fast as possible.  default is 1\n"
+    "  -n <loops>:        Times through the recording, 0 loops until signaled.  default is 1\n"
+    "  -c:                Continue counters: offset each loop's values so counters keep incrementing\n"
+    "  -k:                Keep the recorded timeStamps, default stamps each post w/ the replay time\n"
+    "  -P <prefix>:       Prepend <prefix> to each recorded pvName\n"
+    "  -t <type>:         Value type, ex. double, int, ushort.  default is double\n"
+    "  -p <port>:         EPICS_PVAS_SERVER_PORT, default from the environment\n"
+    "  -b <port>:         EPICS_PVAS_BROADCAST_PORT, default from the environment\n"
+    "  -i <addr list>:    EPICS_PVAS_INTF_ADDR_LIST, ex. 127.0.0.1 for local only tests\n"
+    "  -S <sec>:          Seconds between progress lines, 0 for none.  default is %.0f\n"
+    "  -d:                Enable debug output\n"
+    "\n"
+    "Example: " EXECNAME " -s 10 -n 0 -c /tmp/pvCaptureTest1\n\n"
+             , statsPeriod );
+}
+
+} // namespace
+
+
+int main (int argc, char *argv[])
+{
+    try
+    {
+    int opt;                    /* getopt() current option */
+    unsigned                serverPort      = 0;
+    unsigned                broadcastPort   = 0;
+    std::string             intfAddrList;
+
+    // ================ Parse Arguments
+
+    while ((opt = getopt(argc, argv, ":hVs:n:ckP:t:p:b:i:S:d")) != -1) {
+        switch (opt) {
+        case 'h':               /* Print usage */
+            usage();
+            return 0;
+        case 'V':               /* Print version */
+        {
+            pva::Version version(EXECNAME, "cpp",
+                                PV_REPLAY_MAJOR_VERSION,
+                                PV_REPLAY_MINOR_VERSION,
+                                PV_REPLAY_MAINTENANCE_VERSION,
+                                PV_REPLAY_DEVELOPMENT_FLAG);
+            fprintf(stdout, "%s\n", version.getVersionString().c_str());
+            return 0;
+        }
+        case 's':
+        case 'S':
+        {
+            double  value;
+            if ( epicsScanDouble( optarg, &value ) != 1 || value < 0.0 )
+            {
+                fprintf(stderr, "'%s' is not a valid value for -%c "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg, opt);
+            }
+            else if ( opt == 's' )
+                replaySpeed = value;
+            else
+                statsPeriod = value;
+        }
+            break;
+        case 'n':
+        {
+            unsigned int    count;
+            if ( sscanf( optarg, "%u", &count ) != 1 )
+                fprintf(stderr, "'%s' is not a valid loop count "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            else
+                nLoops = count;
+        }
+            break;
+        case 'c':
+            continueCounts = true;
+            break;
+        case 'k':
+            keepTimeStamps = true;
+            break;
+        case 'P':
+            pvPrefix = optarg;
+            break;
+        case 't':
+            try
+            {
+                pvd::ScalarType type = pvd::ScalarTypeFunc::getScalarType( optarg );
+                if ( type == pvd::pvBoolean || type == pvd::pvString )
+                    fprintf(stderr, "'%s' is not a numeric type "
+                            "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+                else
+                    valueType = type;
+            }
+            catch ( std::exception & )
+            {
+                fprintf(stderr, "'%s' is not a valid ScalarType "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            }
+            break;
+        case 'p':
+        case 'b':
+        {
+            unsigned int    port;
+            if ( sscanf( optarg, "%u", &port ) != 1 || port == 0 || port > 65535 )
+            {
+                fprintf(stderr, "'%s' is not a valid port "
+                        "- ignored. ('" EXECNAME " -h' for help.)\n", optarg);
+            }
+            else if ( opt == 'p' )
+                serverPort = port;
+            else
+                broadcastPort = port;
+        }
+            break;
+        case 'i':
+            intfAddrList = optarg;
+            break;
+        case 'd':               /* Debug log level */
+            debugFlag = true;
+            break;
+        case '?':
+            fprintf(stderr,
+                    "Unrecognized option: '-%c'. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        case ':':
+            fprintf(stderr,
+                    "Option '-%c' requires an argument. ('" EXECNAME " -h' for help.)\n",
+                    optopt);
+            return 1;
+        default :
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string>    filePaths;
+    for ( int i = optind; i < argc; i++ )
+        addCaptureFiles( argv[i], filePaths );
+    if ( filePaths.empty() )
+    {
+        fprintf(stderr, "No capture files given. ('" EXECNAME " -h' for help.)\n");
+        return 1;
+    }
+
+    SET_LOG_LEVEL(debugFlag ? pva::logLevelDebug : pva::logLevelError);
+
+    // ========================== Load the recording
+
+    std::vector<std::tr1::shared_ptr<ReplayPV> >    replayPVs;
+    std::set<std::string>   pvNames;
+    pvas::StaticProvider    provider( "pvReplay" );
+    epicsUInt64             tsFirst     = 0;
+    epicsUInt64             tsLast      = 0;
+    size_t                  nSamples    = 0;
+    for ( size_t i = 0; i < filePaths.size(); i++ )
+    {
+        pvCaptureFile   captureFile;
+        if ( captureFile.read( filePaths[i] ) != 0 )
+            continue;
+        std::string pvName  = pvPrefix + captureFile.getPVName();
+        if ( captureFile.getNumSamples() == 0 )
+        {
+            std::cerr << "Warning: No samples in " << filePaths[i] << std::endl;
+            continue;
+        }
+        if ( !pvNames.insert( pvName ).second )
+        {
+            std::cerr << "Warning: " << filePaths[i] << " ignored, already replaying " << pvName << std::endl;
+            continue;
+        }
+        std::vector<pvCaptureSample>    samples;
+        captureFile.getSamples( samples );
+        std::tr1::shared_ptr<ReplayPV>  replayPV( new ReplayPV( pvName, samples ) );
+        provider.add( pvName, replayPV->m_pv );
+        epicsUInt64 tsKeyFirst  = replayPV->m_samples.front().tsKey();
+        epicsUInt64 tsKeyLast   = replayPV->m_samples.back().tsKey();
+        if ( replayPVs.empty() || tsKeyFirst < tsFirst )
+            tsFirst = tsKeyFirst;
+        if ( replayPVs.empty() || tsKeyLast > tsLast )
+            tsLast = tsKeyLast;
+        nSamples += replayPV->m_samples.size();
+        replayPVs.push_back( replayPV );
+    }
+    if ( replayPVs.empty() )
+    {
+        std::cerr << "Error: Nothing to replay" << std::endl;
+        return 1;
+    }
+
+    // Seconds of sample time from tsFirst
+    #define TSKEY_OFFSET( tsKey )   ( static_cast<double>( ( (tsKey) >> 32 ) - ( tsFirst >> 32 ) ) \
+                                    + ( static_cast<double>( (tsKey) & 0xFFFFFFFF ) - static_cast<double>( tsFirst & 0xFFFFFFFF ) ) * 1.0e-9 )
+    const double    span        = TSKEY_OFFSET( tsLast );
+    // Loops follow each other after one average per PV inter-arrival time
+    const double    loopPeriod  = span + ( nSamples > replayPVs.size() ? span * replayPVs.size() / ( nSamples - replayPVs.size() ) : 1.0 );
+
+    // ========================== Serve
+
+    pva::ConfigurationBuilder   builder;
+    builder.push_env();
+    if ( serverPort )
+        builder.add( "EPICS_PVAS_SERVER_PORT", serverPort );
+    if ( broadcastPort )
+        builder.add( "EPICS_PVAS_BROADCAST_PORT", broadcastPort );
+    if ( !intfAddrList.empty() )
+        builder.add( "EPICS_PVAS_INTF_ADDR_LIST", intfAddrList );
+    builder.push_map();
+    pva::ServerContext::shared_pointer  server( pva::ServerContext::create( pva::ServerContext::Config()
+                                                    .config( builder.build() )
+                                                    .provider( provider.provider() ) ) );
+
+    signal(SIGINT,  alldone);
+    signal(SIGTERM, alldone);
+    signal(SIGQUIT, alldone);
+
+    std::cout << EXECNAME ": Replaying " << nSamples << " samples from " << replayPVs.size() << " PVs, "
+              << span << " sec recorded, ";
+    if ( replaySpeed > 0.0 )
+        std::cout << replaySpeed << "x speed";
+    else
+        std::cout << "as fast as possible";
+    if ( nLoops )
+        std::cout << ", " << nLoops << " loop(s)";
+    else
+        std::cout << ", looping until signaled";
+    std::cout
+              << ", TCP port " << server->getServerPort() << std::endl;
+
+    // ========================== Replay in timestamp order across all PVs
+
+    typedef std::priority_queue<ReplayEvent, std::vector<ReplayEvent>, std::greater<ReplayEvent> >  schedule_t;
+    pvHistogram     lag( "replay lag" );
+    size_t          nPosted     = 0;
+    const epicsUInt64   tStart  = epicsMonotonicGet();
+    double          tStats      = statsPeriod;
+    for ( size_t iLoop = 0; ( nLoops == 0 || iLoop < nLoops ) && !abortFlag; iLoop++ )
+    {
+        schedule_t  schedule;
+        for ( size_t iPV = 0; iPV < replayPVs.size(); iPV++ )
+        {
+            ReplayEvent event;
+            event.offset    = iLoop * loopPeriod + TSKEY_OFFSET( replayPVs[iPV]->m_samples[0].tsKey() );
+            event.iPV       = iPV;
+            event.iSample   = 0;
+            schedule.push( event );
+        }
+        while ( !schedule.empty() && !abortFlag )
+        {
+            ReplayEvent event   = schedule.top();
+            schedule.pop();
+            if ( replaySpeed > 0.0 )
+            {
+                double  due     = event.offset / replaySpeed;
+                double  tNow    = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+                if ( due > tNow )
+                {
+                    // Short waits spin on the scheduler, the OS sleep granularity would smear bursts
+                    if ( due - tNow > 0.002 )
+                        abortEvt.wait( due - tNow - 0.001 );
+                    while ( !abortFlag && ( epicsMonotonicGet() - tStart ) * 1.0e-9 < due )
+                        epicsThreadSleep( 0.0 );
+                }
+                lag.add( ( epicsMonotonicGet() - tStart ) * 1.0e-9 - due );
+            }
+            ReplayPV &  replayPV = *replayPVs[event.iPV];
+            replayPV.post( event.iSample, iLoop );
+            nPosted++;
+            if ( ++event.iSample < replayPV.m_samples.size() )
+            {
+                event.offset = iLoop * loopPeriod + TSKEY_OFFSET( replayPV.m_samples[event.iSample].tsKey() );
+                schedule.push( event );
+            }
+
+            double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+            if ( statsPeriod > 0.0 && elapsed >= tStats )
+            {
+                std::cout << EXECNAME ": Loop " << iLoop << ", " << nPosted << " posts in " << elapsed << " sec, "
+                          << ( elapsed > 0.0 ? nPosted / elapsed : 0.0 ) << " posts/sec" << std::endl;
+                tStats += statsPeriod;
+            }
+        }
+    }
+    #undef TSKEY_OFFSET
+
+    double  elapsed = ( epicsMonotonicGet() - tStart ) * 1.0e-9;
+    std::cout << EXECNAME ": " << nPosted << " posts in " << elapsed << " sec, "
+              << ( elapsed > 0.0 ? nPosted / elapsed : 0.0 ) << " posts/sec" << std::endl;
+    if ( replaySpeed > 0.0 )
+        lag.show( std::cout, true );
+
+    server->shutdown();
+    if(debugFlag)
+        std::cerr << "Done\n";
+    return 0;
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -5,7 +5,9 @@
 #include <map>
 #include <set>
 #include <limits>
+#include <iterator>
 
+#include <epicsGuard.h>
 #include <epicsMutex.h>
 #include <epicsTypes.h>
 #include <epicsEvent.h>
@@ -19,6 +21,66 @@ class pvStorage : public pvCollector
 {
     typedef std::map< epicsUInt64, T > events_t;
 	friend class pvStorageDouble;
+public:		// Public types
+	/// View
+	/// Zero copy view of the saved values w/ tsKey in [from, to], found by
+	/// binary search of the tsKey ordered events.  The view holds the storage
+	/// lock for its lifetime, so saveValue waits on it.  Keep views short
+	/// lived, ex. one report or one dump, and use getEvents for a copy to keep.
+	///	pvStorage<double>::View	view( *pStorage, from, to );
+	///	for ( pvStorage<double>::View::const_iterator it = view.begin(); it != view.end(); ++it )
+	///		sum += it->second;
+	class View
+	{
+	public:
+		typedef typename events_t::const_iterator	const_iterator;
+		typedef typename events_t::value_type		value_type;
+
+		View( pvStorage<T> & storage, epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+			:	m_guard( storage.m_mutex )
+			,	m_begin( storage.m_events.lower_bound( from ) )
+			,	m_end( to < from ? m_begin : const_iterator( storage.m_events.upper_bound( to ) ) )
+		{
+		}
+
+		const_iterator begin( ) const
+		{
+			return m_begin;
+		}
+		const_iterator end( ) const
+		{
+			return m_end;
+		}
+		bool empty( ) const
+		{
+			return m_begin == m_end;
+		}
+		/// size walks the view, linear in the number of values in it
+		size_t size( ) const
+		{
+			return std::distance( m_begin, m_end );
+		}
+		/// front and back, the first and last values, require a non empty view
+		const value_type & front( ) const
+		{
+			return *m_begin;
+		}
+		const value_type & back( ) const
+		{
+			const_iterator	it = m_end;
+			return *--it;
+		}
+
+	private:
+		epicsGuard<epicsMutex>	m_guard;
+		const_iterator			m_begin;
+		const_iterator			m_end;
+
+		View( const View & );
+		View & operator=( const View & );
+	};
+	friend class View;
+
 public:		// Public member functions
 
 	pvStorage( const std::string & pvName, epics::pvData::ScalarType type )
@@ -61,6 +123,57 @@ public:		// Public member functions
 		return m_events.size();
 	}
 
+	size_t getNumEvents( epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+	{
+		View	view( *this, from, to );
+		return view.size();
+	}
+
+	bool getTsKeyRange( epicsUInt64 & first, epicsUInt64 & last,
+						epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+	{
+		View	view( *this, from, to );
+		if ( view.empty() )
+			return false;
+		first	= view.front().first;
+		last	= view.back().first;
+		return true;
+	}
+
+	/// getFirst gets the first saved value w/ tsKey in [from, to]
+	/// Returns false if there are none.
+	bool getFirst( epicsUInt64 & tsKey, T & value, epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+	{
+		View	view( *this, from, to );
+		if ( view.empty() )
+			return false;
+		tsKey	= view.front().first;
+		value	= view.front().second;
+		return true;
+	}
+
+	/// getLast gets the last saved value w/ tsKey in [from, to]
+	/// Returns false if there are none.
+	bool getLast( epicsUInt64 & tsKey, T & value, epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+	{
+		View	view( *this, from, to );
+		if ( view.empty() )
+			return false;
+		tsKey	= view.back().first;
+		value	= view.back().second;
+		return true;
+	}
+
+	/// getEvents copies the saved values w/ tsKey in [from, to] to events
+	/// Returns the number copied, keys already in events are kept and not counted.
+	size_t getEvents( events_t & events, epicsUInt64 from = 0, epicsUInt64 to = std::numeric_limits<epicsUInt64>::max() )
+	{
+		View	view( *this, from, to );
+		size_t	numBefore	= events.size();
+		events.insert( view.begin(), view.end() );
+		return events.size() - numBefore;
+	}
+
     void writeValues( const std::string & testDirPath )
 	{
 		if ( getNumSavedValues() == 0 )
@@ -80,17 +193,28 @@ public:		// Public member functions
 
     void writeValues( std::ostream & fout )
 	{
-		epicsGuard<epicsMutex>	guard( m_mutex );
-		fout << "[" << std::endl;
-		for ( typename events_t::iterator it = m_events.begin(); it != m_events.end(); ++it )
+		writeValues( fout, 0, std::numeric_limits<epicsUInt64>::max() );
+	}
+
+	/// writeValues w/ a tsKey range writes just the saved values in [from, to]
+    void writeValues( std::ostream & fout, epicsUInt64 from, epicsUInt64 to )
+	{
+		View	view( *this, from, to );
+		fout << "[";
+		for ( typename View::const_iterator it = view.begin(); it != view.end(); ++it )
 		{
 			epicsUInt64		key		= it->first;
 			epicsUInt32		sec		= key >> 32;
 			epicsUInt32		nsec	= key;
+			// No trailing comma so the file parses as json
+			if ( it == view.begin() )
+				fout << std::endl;
+			else
+				fout << "," << std::endl;
 			fout	<<	std::fixed << std::setw(17)
-					<< "    [	[ "	<< sec << ", " << nsec << "], " << it->second << " ]," << std::endl;
+					<< "    [	[ "	<< sec << ", " << nsec << "], " << it->second << " ]";
 		}
-		fout << "]" << std::endl;
+		fout << std::endl << "]" << std::endl;
 		// std::cout << "pvStorage Wrote " << getNumSavedValues() << " values to test file." << std::endl;
 	}
 
@@ -24,6 +24,7 @@ class stressTest:
         self._totalNumTimeouts  = 0     # Total number of timeouts collected for all clients and testPVs
         self._startTime        = None   # Earliest timestamp for test
         self._endTime          = None   # Latest   timestamp for test
+        self._fileTypes         = {}    # map of fileType to ( numLines, numTsValues, numTimeouts ) from readSummary
 
     def getEndTime( self ):
         return self._endTime
@@ -75,8 +76,8 @@ class stressTest:
         print( "TestName: %s" % self._testName )
 
         # Show files
+        typeInfo = {}   # map of fileType to ( numLines, numTsValues )
         if len(self._testFiles):
-            typeInfo = {}   # map of fileType to ( numLines, numTsValues )
             sortedFileNames = list(self._testFiles)
             sortedFileNames.sort()
             for fileName in sortedFileNames:
@@ -90,6 +91,9 @@ class stressTest:
                                             fileInfo[2] + numTimeouts )
                 else:
                     typeInfo[fileType] = fileInfo
+        else:
+            typeInfo = self._fileTypes
+        if len(typeInfo):
             print( "    FileTypes  NumLines NumTsValues NumTimeouts" )
             #      "    TTTTTTTTTT NNNNNNNN TTTTTTTTTTT TTTTTTTTTTT" )
             for fileType in typeInfo:
@@ -183,6 +187,8 @@ class stressTest:
                     stressTestFile = stressTestFilePVGet( filePath )
                 elif fileName.endswith( 'pvCapture' ):
                     stressTestFile = stressTestFilePVCapture( filePath )
+                elif fileName.endswith( '.caCapture' ):
+                    stressTestFile = stressTestFileCACapture( filePath )
                 #elif fileName.endswith( '.log' ):
                     # readLogFile( fileName )
                 #elif fileName.endswith( '.list' ):
@@ -204,3 +210,25 @@ class stressTest:
             self.analyze()
         return
 
+    def readSummary( self, summaryPath ):
+        '''Loads the JSON summary written by pvAnalyze, which reads and analyzes
+        the test files in parallel, instead of readFiles() and analyze().'''
+        with open( summaryPath ) as f:
+            summary = json.load( f )
+        self._testName          = summary['testName']
+        self._testPath          = summary['testPath']
+        self._startTime         = summary['startTime']
+        self._endTime           = summary['endTime']
+        self._totalNumPVs       = summary['numPVs']
+        self._totalNumTsValues  = summary['numTsValues']
+        self._totalNumMissed    = summary['numMissed']
+        self._totalNumTimeouts  = summary['numTimeouts']
+        self._fileTypes         = {}
+        for fileType in summary['fileTypes']:
+            typeSummary = summary['fileTypes'][fileType]
+            self._fileTypes[fileType] = ( typeSummary['numLines'], typeSummary['numTsValues'], typeSummary['numTimeouts'] )
+        for clientSummary in summary['clients']:
+            client = stressTestClient( clientSummary['name'], clientSummary['host'] )
+            client.loadSummary( clientSummary )
+            self._testClients[clientSummary['name']] = client
+        return
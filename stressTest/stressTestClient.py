@@ -161,3 +161,18 @@ class stressTestClient:
                 missRate = pvTsMissRates[sec]
                 self._tsMissRates[sec] += missRate
 
+    def loadSummary( self, clientSummary ):
+        '''Loads the results of a pvAnalyze summary instead of reading and analyzing files.'''
+        self._clientType  = clientSummary['type']
+        self._numMissed   = clientSummary['numMissed']
+        self._numTimeouts = clientSummary['numTimeouts']
+        if clientSummary['numTsValues']:
+            self._startTime = clientSummary['startTime']
+            self._endTime   = clientSummary['endTime']
+        firstSec = clientSummary['firstSec']
+        self._tsRates     = { firstSec + i: rate for i, rate in enumerate( clientSummary['tsRates'] ) }
+        self._tsMissRates = { firstSec + i: rate for i, rate in enumerate( clientSummary['tsMissRates'] ) }
+        for pvSummary in clientSummary['pvs']:
+            testPV = self.getTestPV( pvSummary['name'] )
+            testPV.loadSummary( pvSummary )
+
@@ -45,7 +45,8 @@ def readPVCaptureFile( filePath ):
     '''Capture files should follow json syntax and contain
     a list of tsPV values.
     Each tsPV is a list of timestamp, value.
-    Each timestamp is a list of EPICS secPastEpoch, nsec.
+    Each timestamp is a list of POSIX secPastEpoch, nsec, as in pvData timeStamps.
+    caCapture converts its EPICS epoch DBR stamps to POSIX seconds before saving.
     Ex.
     [
         [ [ 1559217327, 738206558], 8349 ],
@@ -267,6 +268,10 @@ class stressTestFilePVCapture( stressTestFile ):
     def getFileType( self ):
         return "pvCapture"
 
+class stressTestFileCACapture( stressTestFilePVCapture ):
+    def getFileType( self ):
+        return "caCapture"
+
 
 # Example code
 #class LoggingDict(SomeOtherMapping):            # new base class
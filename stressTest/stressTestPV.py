@@ -11,11 +11,14 @@ class stressTestPV:
         self._numTimeouts = 0       # Cumulative number of timeouts
         self._startTime   = None    # Earliest timestamp of all collected values
         self._endTime     = None    # Latest   timestamp of all collected values
+        self._numTsValues = 0       # Number of timestamped values, from loadSummary w/o tsValues
 
     # Accessors
     def getName( self ):
         return self._pvName
     def getNumTsValues( self ):
+        if len(self._tsValues) == 0:
+            return self._numTsValues
         return len(self._tsValues)
     def getNumMissed( self ):
         return self._numMissed
@@ -76,16 +79,32 @@ class stressTestPV:
                 timeouts += 1
                 continue
             if priorValue is not None:
-                if priorValue + 1 != value:
+                if priorValue + 1 < value:
                     # Keep track of miss incidents
                     #missed += 1
                     # or
                     # Keep track of how many we missed
-                    missed += ( value - priorValue + 1 )
+                    missed += ( value - priorValue - 1 )
             priorValue = value
 
         if sec:
             self._tsRates[sec] = count
             self._tsMissRates[sec] = missed
             self._timeoutRates[sec] = timeouts
+            self._numMissed += missed
+            self._numTimeouts += timeouts
+
+    def loadSummary( self, pvSummary ):
+        '''Loads the results of a pvAnalyze summary instead of analyzing tsValues.
+        Per second rates are lists starting at firstSec.'''
+        self._numTsValues = pvSummary['numTsValues']
+        self._numMissed   = pvSummary['numMissed']
+        self._numTimeouts = pvSummary['numTimeouts']
+        if self._numTsValues:
+            self._startTime = pvSummary['startTime']
+            self._endTime   = pvSummary['endTime']
+        firstSec = pvSummary['firstSec']
+        self._tsRates      = { firstSec + i: rate for i, rate in enumerate( pvSummary.get( 'tsRates', [] ) ) }
+        self._tsMissRates  = { firstSec + i: rate for i, rate in enumerate( pvSummary.get( 'tsMissRates', [] ) ) }
+        self._timeoutRates = { firstSec + i: rate for i, rate in enumerate( pvSummary.get( 'timeoutRates', [] ) ) }
 
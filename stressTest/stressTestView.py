@@ -29,7 +29,7 @@ def plotCaptureRates( sTest, level=2, block=True ):
     sortedClientNames.sort()
     for clientName in sortedClientNames:
         client = sTest._testClients[clientName]
-        if client.getClientType() != 'pvCapture':
+        if client.getClientType() not in ( 'pvCapture', 'caCapture' ):
             continue
         testPVs = client.getTestPVs()
         for pvName in testPVs:
@@ -133,7 +133,8 @@ def process_options(argv):
         argv = sys.argv[1:]
     description =   'stressTestView supports viewing results from CA or PVA network stress tests.\n'
     epilog_fmt  =   '\nExamples:\n' \
-                    'stressTestView PATH/TO/TEST/TOP"\n'
+                    'stressTestView PATH/TO/TEST/TOP"\n' \
+                    'pvAnalyze -o summary.json PATH/TO/TEST/TOP; stressTestView -s summary.json\n'
     epilog = textwrap.dedent( epilog_fmt )
     parser = argparse.ArgumentParser( description=description, formatter_class=argparse.RawDescriptionHelpFormatter, epilog=epilog )
     #parser.add_argument( 'cmd',  help='Command to launch.  Should be an executable file.' )
@@ -142,6 +143,7 @@ def process_options(argv):
     #parser.add_argument( '-d', '--delay',  action="store", type=float, default=0.0, help='Delay between process launch.' )
     parser.add_argument( '--noPlot',    action="store_true", help='Suppress plot popups.' )
     parser.add_argument( '-t', '--top',  action="store", help='Top directory of test results.' )
+    parser.add_argument( '-s', '--summary',  action="store", help='pvAnalyze JSON summary to view instead of reading the test files.' )
     parser.add_argument( '-r', '--report',   action="store", type=int, default=2, help='Set report level.    Higher numbers show more detail.' )
     parser.add_argument( '-v', '--verbose',  action="store_true", help='show more verbose output.' )
     #parser.add_argument( '-p', '--port',  action="store", type=int, default=40000, help='Base port number, procServ port is port + str(procNumber)' )
@@ -156,7 +158,16 @@ def main(argv=None):
     global procList
     options = process_options(argv)
 
-    if options.top:
+    if options.summary:
+        if not os.path.isfile( options.summary ):
+            print( "%s is not a file!" % options.summary )
+            return 1
+        test1 = stressTest( None, None )
+        test1.readSummary( options.summary )
+        test1.report( options.report )
+        if not options.noPlot:
+            viewPlots( test1, options.report )
+    elif options.top:
         if not os.path.isdir( options.top ):
             print( "%s is not a directory!" % options.top )
             return 1